@@ -27,14 +27,24 @@
 
 
 //------------------------------------------------------------------------------
-ofxOAuth::ofxOAuth(): ofxOAuthVerifierCallbackInterface()
+ofxOAuth::ofxOAuth():
+    ofxOAuthVerifierCallbackInterface(),
+    authThread(*this)
 {
     oauthMethod = OFX_OA_HMAC;  // default
     httpMethod  = OFX_HTTP_GET; // default
+    authState   = OFX_AUTH_UNAUTHORIZED;
+    acceptCompression = true;
+    bodyHashEnabled = false;
+    apiName = "GENERIC";
+
+    {
+        ofScopedLock lock(credentialsMutex);
+        _publishCredentials(); // an empty snapshot, so getters are always safe
+    }
+
+    transport = std::shared_ptr<ofxOAuthTransport>(new ofxOAuthTransport());
 
-    const char* v = getenv("CURLOPT_CAINFO");
-    if(v != NULL) _old_curlopt_cainfo = v;
-    
     // this Certificate Authority bundle is extracted 
     // from mozilla.org.pem, which can be found here
     //
@@ -47,41 +57,40 @@ ofxOAuth::ofxOAuth(): ofxOAuthVerifierCallbackInterface()
     
     setSSLCACertificateFile("cacert.pem");
     
-    // this setter sets an environmental variable,
-    // which is accessed by liboauth whenever libcurl
-    // calls are executed.
+    // this setter hands the bundle to our transport, which
+    // parses it once and shares it with the other clients.
     
     callbackConfirmed = false;
     
     verificationRequested = false;
     accessFailed = false;
     accessFailedReported = false;
-    
-    apiName = "GENERIC"; 
+    listeningToUpdate = false;
     
     credentialsPathname = "credentials.xml";
     verifierCallbackServerDocRoot = "VerifierCallbackServer/";
     vertifierCallbackServerPort = -1;
     enableVerifierCallbackServer = true;
     
-    ofAddListener(ofEvents().update,this,&ofxOAuth::update);
+    {
+        ofScopedLock lock(authStateMutex);
+        _listenToUpdate(true);
+    }
 }
 
 //------------------------------------------------------------------------------
 ofxOAuth::~ofxOAuth()
 {
-    // be nice and set it back, if there was 
-    // something there when we started.
-    if(!_old_curlopt_cainfo.empty())
     {
-        setenv("CURLOPT_CAINFO",_old_curlopt_cainfo.c_str(),true);
-    }
-    else
-    {
-        unsetenv("CURLOPT_CAINFO");
+        ofScopedLock lock(authStateMutex);
+        _listenToUpdate(false);
     }
 
-    ofRemoveListener(ofEvents().update,this,&ofxOAuth::update);
+    // stop the authorization flow before anything it uses goes away.
+    authThread.stopThread();
+    verifierEvent.set();
+    authThread.waitForThread(false);
+    _stopVerifierCallbackServer();
 }
 
 //------------------------------------------------------------------------------
@@ -118,327 +127,813 @@ void ofxOAuth::setup(const std::string& _apiURL,
 //------------------------------------------------------------------------------
 void ofxOAuth::update(ofEventArgs& args)
 {
-    if(accessFailed)
+    // the flow starts on the first frame the client is configured for it,
+    // so it doesn't matter whether the app sets it up before or after the
+    // first frame.  It then runs on the authorization thread.
+    if(getAuthState() == OFX_AUTH_UNAUTHORIZED && _isConfiguredForAuthorization())
+    {
+        _startAuthorization();
+    }
+
+    // the browser is opened here, on the main thread, for the
+    // authorization thread.
+    std::string url;
+
     {
-        if(!accessFailedReported)
+        ofScopedLock lock(authStateMutex);
+        url.swap(pendingBrowserURL);
+
+        // once the flow has ended there is nothing to do each frame, until
+        // resetErrors() or another browser url registers us again.
+        if(authState == OFX_AUTH_AUTHORIZED || authState == OFX_AUTH_FAILED)
         {
-            ofLogError("ofxOAuth::update") << "Access failed.";
-            accessFailedReported = true;
+            _listenToUpdate(false);
         }
     }
-    else if(accessToken.empty() || accessTokenSecret.empty())
+
+    if(!url.empty())
+    {
+        ofLaunchBrowser(url);
+    }
+}
+
+//------------------------------------------------------------------------------
+void ofxOAuth::_listenToUpdate(bool listen)
+{
+    if(listeningToUpdate == listen) return;
+
+    listeningToUpdate = listen;
+
+    if(listen)
+    {
+        ofAddListener(ofEvents().update,this,&ofxOAuth::update);
+    }
+    else
+    {
+        ofRemoveListener(ofEvents().update,this,&ofxOAuth::update);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool ofxOAuth::_isConfiguredForAuthorization() const
+{
+    ofxOAuthCredentialsPtr c = getCredentials();
+
+    return c->isAuthorized() || (!c->consumerKey.empty() &&
+                                 !c->consumerSecret.empty() &&
+                                 !c->requestTokenURL.empty());
+}
+
+//------------------------------------------------------------------------------
+void ofxOAuth::_setAccessFailed()
+{
+    ofScopedLock lock(authStateMutex);
+    accessFailed = true;
+}
+
+//------------------------------------------------------------------------------
+ofxOAuth::AuthState ofxOAuth::getAuthState() const
+{
+    ofScopedLock lock(authStateMutex);
+    return authState;
+}
+
+//------------------------------------------------------------------------------
+void ofxOAuth::_startAuthorization()
+{
+    if(isAuthorized())
+    {
+        _setAuthState(OFX_AUTH_AUTHORIZED);
+        return;
+    }
+
+    if(authThread.isThreadRunning())
     {
-        if(requestTokenVerifier.empty())
+        return;
+    }
+
+    authThread.waitForThread(false); // join a previous run, if any
+    authThread.startThread(false, false);
+}
+
+//------------------------------------------------------------------------------
+void ofxOAuth::_runAuthorization()
+{
+    while(authThread.isThreadRunning())
+    {
+        ofxOAuthCredentialsPtr c = getCredentials();
+
+        bool failed = false;
+        bool reportFailure = false;
+
+        {
+            ofScopedLock lock(authStateMutex);
+            failed = accessFailed;
+            reportFailure = failed && !accessFailedReported;
+            if(reportFailure) accessFailedReported = true;
+        }
+
+        if(failed)
+        {
+            if(reportFailure)
+            {
+                ofLogError("ofxOAuth::_runAuthorization") << "Access failed.";
+            }
+            _stopVerifierCallbackServer();
+            _setAuthState(OFX_AUTH_FAILED);
+            return;
+        }
+        else if(c->isAuthorized())
+        {
+            _stopVerifierCallbackServer();
+            _setAuthState(OFX_AUTH_AUTHORIZED);
+            return;
+        }
+        else if(c->requestToken.empty())
         {
-            if(requestToken.empty())
+            bool enabled = false;
+            std::shared_ptr<ofxOAuthVerifierCallbackServer> server;
+            std::shared_ptr<ofxOAuthVerifierCallbackServer> sharedServer;
+            std::string docRoot;
+            int port = -1;
+
+            {
+                ofScopedLock lock(authStateMutex);
+                enabled = enableVerifierCallbackServer;
+                server = verifierCallbackServer;
+                sharedServer = sharedVerifierCallbackServer;
+                docRoot = verifierCallbackServerDocRoot;
+                port = vertifierCallbackServerPort;
+            }
+
+            if(enabled)
             {
-                if(enableVerifierCallbackServer)
+                if(server == NULL)
                 {
-                    if(verifierCallbackServer == NULL)
+                    if(sharedServer != NULL)
                     {
-                        verifierCallbackServer = std::shared_ptr<ofxOAuthVerifierCallbackServer>(new ofxOAuthVerifierCallbackServer(this,verifierCallbackServerDocRoot, vertifierCallbackServerPort));
-                        verifierCallbackURL = verifierCallbackServer->getURL();
-                        verifierCallbackServer->start();
+                        server = sharedServer;
                     }
-                }
-                else
-                {
-                    // nichts
-                    ofLogVerbose("ofxOAuth::update") << "Server disabled, expecting verifiy key input via a non server method (i.e. text input.)";
-                    ofLogVerbose("ofxOAuth::update") << "\t\tThis is done via 'oob' (Out-of-band OAuth authentication).";
-                    ofLogVerbose("ofxOAuth::update") << "\t\tCall setRequestTokenVerifier() with a verification code to continue.";
-                }
+                    else
+                    {
+                        server = std::shared_ptr<ofxOAuthVerifierCallbackServer>(new ofxOAuthVerifierCallbackServer(this, docRoot, port));
+                    }
+
+                    // the url is only known once the port is bound.
+                    if(server->start())
+                    {
+                        std::string url = server->getURL();
 
-                obtainRequestToken();
+                        ofScopedLock lock(authStateMutex);
+                        verifierCallbackServer = server;
+                        verifierCallbackURL = url;
+                    }
+                    else
+                    {
+                        server.reset();
+                    }
+                }
             }
             else
             {
-                if(!verificationRequested)
-                {
-                    requestUserVerification();
-                    verificationRequested = true;
-                    ofLogVerbose("ofxOAuth::update") << "Waiting for user verification (need the pin number / requestTokenVerifier!)";
-                    ofLogVerbose("ofxOAuth::update") << "\t\tIf the server is enabled, then this will happen as soon as the user is redirected.";
-                    ofLogVerbose("ofxOAuth::update") << "\t\tIf the server is disabled, verification must be done via 'oob'";
-                    ofLogVerbose("ofxOAuth::update") << "\t\t(Out-of-band OAuth authentication). Call setRequestTokenVerifier()";
-                    ofLogVerbose("ofxOAuth::update") << "\t\twith a verification code to continue.";
-                }
-                else
-                {
-                    // nichts
-                }
+                ofLogVerbose("ofxOAuth::_runAuthorization") << "Server disabled, expecting verifiy key input via a non server method (i.e. text input.)";
+                ofLogVerbose("ofxOAuth::_runAuthorization") << "\t\tThis is done via 'oob' (Out-of-band OAuth authentication).";
+                ofLogVerbose("ofxOAuth::_runAuthorization") << "\t\tCall setRequestTokenVerifier() with a verification code to continue.";
             }
+
+            _setAuthState(OFX_AUTH_REQUESTING_TOKEN);
+            obtainRequestToken();
+
+            std::string token = getCredentials()->requestToken;
+
+            // don't spin on an exchange that cannot succeed (e.g. no url set).
+            if(token.empty())
+            {
+                _setAccessFailed();
+            }
+            else if(server != NULL)
+            {
+                // the redirect will carry this token.
+                server->addRoute(token, this);
+
+                ofScopedLock lock(authStateMutex);
+                verifierCallbackRouteToken = token;
+            }
+        }
+        else if(c->requestTokenVerifier.empty())
+        {
+            bool requested = false;
+
+            {
+                ofScopedLock lock(authStateMutex);
+                requested = verificationRequested;
+                verificationRequested = true;
+            }
+
+            if(!requested)
+            {
+                requestUserVerification();
+                ofLogVerbose("ofxOAuth::_runAuthorization") << "Waiting for user verification (need the pin number / requestTokenVerifier!)";
+                ofLogVerbose("ofxOAuth::_runAuthorization") << "\t\tIf the server is enabled, then this will happen as soon as the user is redirected.";
+                ofLogVerbose("ofxOAuth::_runAuthorization") << "\t\tIf the server is disabled, verification must be done via 'oob'";
+                ofLogVerbose("ofxOAuth::_runAuthorization") << "\t\t(Out-of-band OAuth authentication). Call setRequestTokenVerifier()";
+                ofLogVerbose("ofxOAuth::_runAuthorization") << "\t\twith a verification code to continue.";
+                _setAuthState(OFX_AUTH_WAITING_FOR_VERIFIER);
+            }
+
+            // sleep until setRequestTokenVerifier() or the destructor wakes us.
+            verifierEvent.wait();
         }
         else
         {
-            if(!accessFailed)
             {
+                ofScopedLock lock(authStateMutex);
                 verificationRequested = false;
-                if(verifierCallbackServer != NULL)
-                {
-                    verifierCallbackServer->stop(); // stop the server
-                    verifierCallbackServer.reset(); // destroy the server, setting it back to null
-                }
-                obtainAccessToken();
             }
-        } 
+
+            _stopVerifierCallbackServer();
+            _setAuthState(OFX_AUTH_REQUESTING_ACCESS_TOKEN);
+            obtainAccessToken();
+
+            if(!isAuthorized()) _setAccessFailed();
+        }
     }
-    else
+}
+
+//------------------------------------------------------------------------------
+void ofxOAuth::_stopVerifierCallbackServer()
+{
+    std::shared_ptr<ofxOAuthVerifierCallbackServer> server;
+    std::string routeToken;
+    bool shared = false;
+
+    {
+        ofScopedLock lock(authStateMutex);
+        server.swap(verifierCallbackServer);
+        routeToken.swap(verifierCallbackRouteToken);
+        shared = (server == sharedVerifierCallbackServer);
+    }
+
+    if(server != NULL)
     {
-        if(verifierCallbackServer != NULL)
+        // waits for a request that is calling into us, so the lock
+        // must not be held.
+        if(!routeToken.empty())
+        {
+            server->removeRoute(routeToken);
+        }
+
+        // a shared server keeps serving the other clients.
+        if(!shared)
         {
-            // go ahead and free that memory
-            verifierCallbackServer->stop(); // stop the server
-            verifierCallbackServer.reset(); // destroy the server, setting it back to null
+            server->stop(); // stop the server
         }
+
+        server.reset(); // destroy the server
+    }
+}
+
+//------------------------------------------------------------------------------
+void ofxOAuth::_setAuthState(AuthState state)
+{
+    {
+        ofScopedLock lock(authStateMutex);
+        if(authState == state) return;
+        authState = state;
+    }
+
+    AuthStateEventArgs args(state);
+    ofNotifyEvent(authStateChanged, args, this);
+}
+
+//------------------------------------------------------------------------------
+std::string ofxOAuth::get(const std::string& uri, const std::string& query)
+{
+    return _perform("ofxOAuth::get", OFX_HTTP_GET, uri, ofxOAuthParams(query)).toString();
+}
+
+//------------------------------------------------------------------------------
+std::string ofxOAuth::post(const std::string& uri, const std::string& query)
+{
+    return _perform("ofxOAuth::post", OFX_HTTP_POST, uri, ofxOAuthParams(query)).toString();
+}
+
+//------------------------------------------------------------------------------
+std::string ofxOAuth::get(const std::string& uri, const ofxOAuthParams& params)
+{
+    return _perform("ofxOAuth::get", OFX_HTTP_GET, uri, params).toString();
+}
+
+//------------------------------------------------------------------------------
+std::string ofxOAuth::post(const std::string& uri, const ofxOAuthParams& params)
+{
+    return _perform("ofxOAuth::post", OFX_HTTP_POST, uri, params).toString();
+}
+
+//------------------------------------------------------------------------------
+ofxOAuthResponse ofxOAuth::getResponse(const std::string& uri, const std::string& query)
+{
+    return _perform("ofxOAuth::getResponse", OFX_HTTP_GET, uri, ofxOAuthParams(query));
+}
+
+//------------------------------------------------------------------------------
+ofxOAuthResponse ofxOAuth::postResponse(const std::string& uri, const std::string& query)
+{
+    return _perform("ofxOAuth::postResponse", OFX_HTTP_POST, uri, ofxOAuthParams(query));
+}
+
+//------------------------------------------------------------------------------
+ofxOAuthResponse ofxOAuth::getResponse(const std::string& uri, const ofxOAuthParams& params)
+{
+    return _perform("ofxOAuth::getResponse", OFX_HTTP_GET, uri, params);
+}
+
+//------------------------------------------------------------------------------
+ofxOAuthResponse ofxOAuth::postResponse(const std::string& uri, const ofxOAuthParams& params)
+{
+    return _perform("ofxOAuth::postResponse", OFX_HTTP_POST, uri, params);
+}
+
+//------------------------------------------------------------------------------
+ofxOAuthResponse ofxOAuth::_perform(const std::string& logTag,
+                                    AuthHttpMethod method,
+                                    const std::string& uri,
+                                    const ofxOAuthParams& params,
+                                    std::shared_ptr<ofxOAuthBodySource> bodySource)
+{
+    ofxOAuthRetryPolicy policy = getRetryPolicy();
+    bool idempotent = (method == OFX_HTTP_GET);
+    unsigned long long startTime = ofGetElapsedTimeMillis();
+
+    ofxOAuthResponse response;
+
+    std::shared_ptr<ofxOAuthResponseCache> cache;
+    std::string cacheKey;
+    ofxOAuthCacheEntryPtr cached;
+
+    if(method == OFX_HTTP_GET)
+    {
+        cache = getResponseCache();
+    }
+
+    // the body hash is signed like any other oauth parameter.
+    const ofxOAuthParams* signedParams = &params;
+    ofxOAuthParams paramsWithBodyHash;
+
+    if(bodySource != NULL && bodyHashEnabled)
+    {
+        std::string bodyHash;
+
+        if(!ofxOAuthSigner::computeBodyHash(*bodySource, bodyHash))
+        {
+            response.curlCode = CURLE_READ_ERROR;
+            response.error = "Unable to read the request body.";
+            return response;
+        }
+
+        paramsWithBodyHash = params;
+        paramsWithBodyHash.add("oauth_body_hash", bodyHash);
+        signedParams = &paramsWithBodyHash;
+    }
+
+    if(cache != NULL)
+    {
+        // the full url, so clients of different apis that share a cache
+        // don't answer each other's requests.
+        ofxOAuthCredentialsPtr c = getCredentials();
+        cacheKey = ofxOAuthResponseCache::makeKey("GET", c->apiURL + uri, params, c->accessToken);
+        cached = cache->lookup(cacheKey);
+
+        if(cached != NULL && cached->isFresh(ofxOAuthResponseCache::getTime()))
+        {
+            cache->countHit();
+            cached->getResponse(response);
+            return response;
+        }
+
+        if(cached == NULL || !cached->canRevalidate())
+        {
+            cache->countMiss();
+            cached.reset();
+        }
+    }
+
+    for(int attempt = 1; ; ++attempt)
+    {
+        // every attempt is signed again, with a fresh nonce and timestamp.
+        ofxOAuthTransportRequest request;
+
+        response = ofxOAuthResponse();
+        response.attempts = attempt - 1;
+
+        if(!_signRequest(logTag, method, uri, *signedParams, request))
+        {
+            response.curlCode = CURLE_FAILED_INIT;
+            response.error = "Unable to sign the request.";
+            return response;
+        }
+
+        if(bodySource != NULL)
+        {
+            // replaces the (empty) form body.
+            request.bodySource = bodySource;
+        }
+
+        if(cached != NULL)
+        {
+            // an unchanged response then costs a 304 without a body.
+            ofxOAuthResponseCache::addConditionalHeaders(*cached, request.extraHeaders);
+        }
+
+        if(policy.deadlineMillis > 0)
+        {
+            long elapsed = (long)(ofGetElapsedTimeMillis() - startTime);
+            request.timeoutMillis = std::max(1L, policy.deadlineMillis - elapsed);
+        }
+
+        unsigned long long attemptStartTime = ofGetElapsedTimeMillis();
+
+        if(idempotent && policy.hedgeGets)
+        {
+            long hedgeDelay = latencies.getPercentile(0.95f);
+            hedgeDelay = hedgeDelay < 0 ? policy.hedgeDelayMillis : std::max(hedgeDelay, policy.minHedgeDelayMillis);
+            _performHedged(logTag, method, uri, *signedParams, request, hedgeDelay, response);
+        }
+        else
+        {
+            getTransport()->perform(request, response);
+        }
+
+        response.attempts = attempt;
+
+        ofxOAuthRetryPolicy::Failure failure = ofxOAuthRetryPolicy::classify(response);
+
+        if(failure == ofxOAuthRetryPolicy::NO_FAILURE)
+        {
+            if(idempotent) latencies.add((long)(ofGetElapsedTimeMillis() - attemptStartTime));
+            break;
+        }
+
+        ofLogVerbose(logTag) << "HTTP request failed (" << ofxOAuthRetryPolicy::toString(failure) << "): "
+                             << (response.error.empty() ? ofToString(response.status) : response.error);
+
+        if(!policy.shouldRetry(failure, idempotent, attempt))
+        {
+            break;
+        }
+
+        long delay = policy.getBackoffMillis(attempt, response.headers);
+
+        if(delay < 0)
+        {
+            ofLogVerbose(logTag) << "Not retrying, the server asked to wait longer than " << policy.maxDelayMillis << " ms.";
+            break;
+        }
+
+        if(policy.deadlineMillis > 0 &&
+           (long)(ofGetElapsedTimeMillis() - startTime) + delay >= policy.deadlineMillis)
+        {
+            ofLogVerbose(logTag) << "Not retrying, the deadline would pass.";
+            break;
+        }
+
+        ofLogVerbose(logTag) << "Retrying in " << delay << " ms (attempt " << attempt + 1 << " of " << policy.maxAttempts << ").";
+        ofSleepMillis((int)delay);
+    }
+
+    if(cache != NULL && response.isOk())
+    {
+        if(response.status == 304 && cached != NULL)
+        {
+            cache->revalidated(cached, response)->getResponse(response);
+        }
+        else if(response.status == 200)
+        {
+            cache->store(cacheKey, response);
+        }
+    }
+
+    // a stale entry the server didn't confirm was a miss after all.
+    if(cache != NULL && cached != NULL && !(response.isOk() && response.status == 304))
+    {
+        cache->countMiss();
+    }
+
+    if(!response.empty() && ofGetLogLevel() <= OF_LOG_VERBOSE)
+    {
+        // only copy the body for the log when it will actually be printed.
+        ofLogVerbose(logTag) << "HTTP-Reply: " << response.toString();
+    }
+
+    return response;
+}
+
+//------------------------------------------------------------------------------
+void ofxOAuth::_performHedged(const std::string& logTag,
+                              AuthHttpMethod method,
+                              const std::string& uri,
+                              const ofxOAuthParams& params,
+                              const ofxOAuthTransportRequest& request,
+                              long hedgeDelayMillis,
+                              ofxOAuthResponse& response)
+{
+    std::shared_ptr<ofxOAuthAsyncTransport> async = getAsyncTransport();
+    std::shared_ptr<ofxOAuthBufferPool> pool = getTransport()->getBufferPool();
+
+    Poco::Event doneEvent;
+    HedgeListener first(doneEvent, pool->acquire());
+    HedgeListener second(doneEvent, pool->acquire());
+    bool hedged = false;
+
+    async->submitStream(request, &first);
+
+    if(!doneEvent.tryWait(hedgeDelayMillis))
+    {
+        // the duplicate is signed separately, so it isn't taken for a replay,
+        // but carries what _perform added after signing, e.g. the conditional
+        // headers that let a revalidation end in a 304.  Only GETs are
+        // hedged, so there is no body source to share.
+        ofxOAuthTransportRequest duplicate;
+
+        if(_signRequest(logTag, method, uri, params, duplicate))
+        {
+            duplicate.extraHeaders = request.extraHeaders;
+            duplicate.timeoutMillis = request.timeoutMillis;
+            async->submitStream(duplicate, &second);
+            hedged = true;
+            ofLogVerbose(logTag) << "No reply after " << hedgeDelayMillis << " ms, sent a hedged request.";
+        }
+    }
+
+    // the first successful reply wins, or the last one if both fail.
+    HedgeListener* winner = NULL;
+
+    while(winner == NULL)
+    {
+        if(first.isDone() && (!hedged || first.isOk() || second.isDone()))
+        {
+            winner = &first;
+        }
+        else if(hedged && second.isDone() && (second.isOk() || first.isDone()))
+        {
+            winner = &second;
+        }
+        else
+        {
+            doneEvent.wait();
+        }
+    }
+
+    if(hedged)
+    {
+        // the listeners live on this stack, so the loser must be finished.
+        HedgeListener& loser = (winner == &first) ? second : first;
+        loser.cancel();
+        while(!loser.isDone()) doneEvent.wait();
+    }
+
+    winner->getResponse(response);
+}
+
+//------------------------------------------------------------------------------
+ofxOAuthResponse ofxOAuth::postMultipart(const std::string& uri,
+                                         std::shared_ptr<ofxOAuthMultipartBody> body)
+{
+    return _perform("ofxOAuth::postMultipart", OFX_HTTP_POST, uri, ofxOAuthParams(), body);
+}
+
+//------------------------------------------------------------------------------
+ofxOAuthAsyncResult ofxOAuth::getAsync(const std::string& uri,
+                                       const std::string& query,
+                                       ofxOAuthRequestListener* listener)
+{
+    ofxOAuthTransportRequest request;
+
+    if(!_signRequest("ofxOAuth::getAsync", OFX_HTTP_GET, uri, query, request))
+    {
+        return getAsyncTransport()->submitFailed("Unable to sign the request.", listener);
+    }
+
+    return getAsyncTransport()->submit(request, listener);
+}
+
+//------------------------------------------------------------------------------
+ofxOAuthAsyncResult ofxOAuth::postAsync(const std::string& uri,
+                                        const std::string& query,
+                                        ofxOAuthRequestListener* listener)
+{
+    ofxOAuthTransportRequest request;
+
+    if(!_signRequest("ofxOAuth::postAsync", OFX_HTTP_POST, uri, query, request))
+    {
+        return getAsyncTransport()->submitFailed("Unable to sign the request.", listener);
     }
+
+    return getAsyncTransport()->submit(request, listener);
 }
 
 //------------------------------------------------------------------------------
-std::string ofxOAuth::get(const std::string& uri, const std::string& query)
+ofxOAuthAsyncResult ofxOAuth::getStream(const std::string& uri,
+                                        const std::string& query,
+                                        ofxOAuthStreamListener* listener)
 {
-    std::string result = "";
-        
-    if(apiURL.empty())
-    {
-        ofLogError("ofxOAuth::get") << "No api URL specified.";
-        return result;
-    }
-    
-    if(consumerKey.empty())
-    {
-        ofLogError("ofxOAuth::get") << "No consumer key specified.";
-        return result;
-    }
-    
-    if(consumerSecret.empty())
+    ofxOAuthTransportRequest request;
+
+    if(!_signRequest("ofxOAuth::getStream", OFX_HTTP_GET, uri, query, request))
     {
-        ofLogError("ofxOAuth::get") << "No consumer secret specified.";
-        return result;
+        return getAsyncTransport()->submitFailed("Unable to sign the request.", listener);
     }
-    
-    if(accessToken.empty())
+
+    return getAsyncTransport()->submitStream(request, listener);
+}
+
+//------------------------------------------------------------------------------
+ofxOAuthAsyncResult ofxOAuth::postStream(const std::string& uri,
+                                         const std::string& query,
+                                         ofxOAuthStreamListener* listener)
+{
+    ofxOAuthTransportRequest request;
+
+    if(!_signRequest("ofxOAuth::postStream", OFX_HTTP_POST, uri, query, request))
     {
-        ofLogError("ofxOAuth::get") << "No access token specified.";
-        return result;
+        return getAsyncTransport()->submitFailed("Unable to sign the request.", listener);
     }
 
-    if(accessTokenSecret.empty())
+    return getAsyncTransport()->submitStream(request, listener);
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<ofxOAuthAsyncTransport> ofxOAuth::getAsyncTransport()
+{
+    ofScopedLock lock(transportMutex);
+
+    // the event loop thread is only started once something is submitted.
+    if(asyncTransport == NULL)
     {
-        ofLogError("ofxOAuth::get") << "No access token secret specified.";
-        return result;
+        asyncTransport = std::shared_ptr<ofxOAuthAsyncTransport>(new ofxOAuthAsyncTransport(transport));
     }
 
-    std::string req_url;
-    std::string req_hdr;
-    std::string http_hdr;
-    
-    std::string reply;
-    
-    // oauth_sign_url2 (see oauth.h) in steps
-    int  argc   = 0;
-    char **argv = NULL;
-    
+    return asyncTransport;
+}
+
+//------------------------------------------------------------------------------
+bool ofxOAuth::_signRequest(const std::string& logTag,
+                            AuthHttpMethod method,
+                            const std::string& uri,
+                            const std::string& query,
+                            ofxOAuthTransportRequest& request) const
+{
     // break apart the url parameters to they can be signed below
     // if desired we can also pass in additional patermeters (like oath* params)
     // here.  For instance, if ?oauth_callback=XXX is defined in this url,
     // it will be parsed and used in the Authorization header.
-    
-    std::string url = apiURL + uri + "?" + query;
-    
-    argc = oauth_split_url_parameters(url.c_str(), &argv);
-    
-    // sign the array.
-    oauth_sign_array2_process(&argc, 
-                              &argv,
-                              NULL,							//< postargs (unused)
-                              _getOAuthMethod(),			// hash type, OA_HMAC, OA_RSA, OA_PLAINTEXT
-                              _getHttpMethod().c_str(),		//< HTTP method (defaults to "GET")
-                              consumerKey.c_str(),			//< consumer key - posted plain text
-                              consumerSecret.c_str(),		//< consumer secret - used as 1st part of secret-key
-                              accessToken.c_str(),			//< token key - posted plain text in URL
-                              accessTokenSecret.c_str());	//< token secret - used as 2st part of secret-key
-    
-    ofLogVerbose("ofxOAuth::get") << "-------------------";
-    ofLogVerbose("ofxOAuth::get") << "consumerKey          >" << consumerKey << "<";
-    ofLogVerbose("ofxOAuth::get") << "consumerSecret       >" << consumerSecret << "<";
-    ofLogVerbose("ofxOAuth::get") << "requestToken         >" << requestToken << "<";
-    ofLogVerbose("ofxOAuth::get") << "requestTokenVerifier >" << requestTokenVerifier << "<";
-    ofLogVerbose("ofxOAuth::get") << "requestTokenSecret   >" << requestTokenSecret << "<";
-    ofLogVerbose("ofxOAuth::get") << "accessToken          >" << accessToken << "<";
-    ofLogVerbose("ofxOAuth::get") << "accessTokenSecret    >" << accessTokenSecret << "<";
-    ofLogVerbose("ofxOAuth::get") << "-------------------";
-
-    // collect any parameters in our list that need to be placed in the request URI
-    req_url = oauth_serialize_url_sep(argc, 0, argv, const_cast<char *>("&"), 1); 
-    
-    // collect any of the oauth parameters for inclusion in the HTTP Authorization header.
-    req_hdr = oauth_serialize_url_sep(argc, 1, argv, const_cast<char *>(", "), 6); // const_cast<char *>() is to avoid Deprecated 
-    
-    // look at url parameters to be signed if you want.
-    if(ofGetLogLevel() <= OF_LOG_VERBOSE)
-        for (int i=0;i<argc; i++) ofLogVerbose("ofxOAuth::get") << " : " << i << ":" << argv[i];
-    
-    // free our parameter arrays that were allocated during parsing above    
-    oauth_free_array(&argc, &argv);
-    
-    // construct the Authorization header.  Include realm information if available.
-    if(!realm.empty())
-    {
-        // Note that (optional) 'realm' is not to be 
-        // included in the oauth signed parameters and thus only added here.
-        // see 9.1.1 in http://oauth.net/core/1.0/#anchor14
-        http_hdr = "Authorization: OAuth realm=\"" + realm + "\", " + req_hdr; 
-    }
-    else
-    {
-        http_hdr = "Authorization: OAuth " + req_hdr; 
-    }
-    
-    ofLogVerbose("ofxOAuth::get") << "request URL    >" << req_url << "<";
-    ofLogVerbose("ofxOAuth::get") << "request HEADER >" << req_hdr << "<";
-    ofLogVerbose("ofxOAuth::get") << "http    HEADER >" << http_hdr << "<";
-    
-    reply = oauth_http_get2(req_url.c_str(),   // the base url to get
-                            NULL,              // the query string to send
-                            http_hdr.c_str()); // Authorization header is included here
-    
-    if (reply.empty())
-    {
-        ofLogVerbose("ofxOAuth::get") << "HTTP get request failed.";
-    }
-    else
-    {
-        ofLogVerbose("ofxOAuth::get") << "HTTP-Reply: " << reply;
-        result = reply;
-    }
-    
-    return result;
+    ofxOAuthParams params(query);
+    return _signRequest(logTag, method, uri, params, request);
 }
 
 //------------------------------------------------------------------------------
-std::string ofxOAuth::post(const std::string& uri, const std::string& query)
+bool ofxOAuth::_signRequest(const std::string& logTag,
+                            AuthHttpMethod method,
+                            const std::string& uri,
+                            const ofxOAuthParams& _params,
+                            ofxOAuthTransportRequest& request) const
 {
-	// we will use POST as HTTP method
-	httpMethod = OFX_HTTP_POST;
-	
-    string result = "";
-    
-	if(apiURL.empty())
+    // everything below reads this snapshot only, never the members.
+    ofxOAuthCredentialsPtr c = getCredentials();
+
+    if(c->apiURL.empty())
     {
-        ofLogError("ofxOAuth::post") << "No api URL specified.";
-        return result;
+        ofLogError(logTag) << "No api URL specified.";
+        return false;
     }
     
-    if(consumerKey.empty())
+    if(c->consumerKey.empty())
     {
-        ofLogError("ofxOAuth::post") << "No consumer key specified.";
-        return result;
+        ofLogError(logTag) << "No consumer key specified.";
+        return false;
     }
     
-    if(consumerSecret.empty())
+    if(c->consumerSecret.empty())
     {
-        ofLogError("ofxOAuth::post") << "No consumer secret specified.";
-        return result;
+        ofLogError(logTag) << "No consumer secret specified.";
+        return false;
     }
     
-    if(accessToken.empty())
+    if(c->accessToken.empty())
     {
-        ofLogError("ofxOAuth::post") << "No access token specified.";
-        return result;
+        ofLogError(logTag) << "No access token specified.";
+        return false;
     }
-	
-    if(accessTokenSecret.empty())
+
+    if(c->accessTokenSecret.empty())
     {
-        ofLogError("ofxOAuth::post") << "No access token secret specified.";
-        return result;
+        ofLogError(logTag) << "No access token secret specified.";
+        return false;
     }
-	std::string req_url;
-    std::string req_hdr;
-    std::string http_hdr;
-    
-    std::string reply;
-    
-    // oauth_sign_url2 (see oauth.h) in steps
-    int  argc   = NULL;
-    char **argv = NULL;
-	
-    // break apart the url parameters so they can be signed below
-    // if desired we can also pass in additional patermeters (like oath* params)
-    // here.  For instance, if ?oauth_callback=XXX is defined in this url,
-    // it will be parsed and used in the Authorization header.
-    
-    std::string url = apiURL + uri + "?" + query;
-    
-    argc = oauth_split_url_parameters(url.c_str(), &argv);
-
-	// sign the array.
-	oauth_sign_array2_process(&argc,						// argcp pointer to array length int
-                              &argv,						// argvp pointer to array values
-							  NULL,							//< postargs This parameter points to an area where the return value is stored.
-															// If 'postargs' is NULL, no value is stored.
-                              _getOAuthMethod(),			// hash type, OA_HMAC, OA_RSA, OA_PLAINTEXT
-                              _getHttpMethod().c_str(),		//< HTTP method (defaults to "GET")
-                              consumerKey.c_str(),			//< consumer key - posted plain text
-                              consumerSecret.c_str(),		//< consumer secret - used as 1st part of secret-key
-                              accessToken.c_str(),			//< token key - posted plain text in URL
-                              accessTokenSecret.c_str());	//< token secret - used as 2st part of secret-key
-	
-    ofLogVerbose("ofxOAuth::post") << "-------------------";
-    ofLogVerbose("ofxOAuth::post") << "consumerKey          >" << consumerKey << "<";
-    ofLogVerbose("ofxOAuth::post") << "consumerSecret       >" << consumerSecret << "<";
-    ofLogVerbose("ofxOAuth::post") << "requestToken         >" << requestToken << "<";
-    ofLogVerbose("ofxOAuth::post") << "requestTokenVerifier >" << requestTokenVerifier << "<";
-    ofLogVerbose("ofxOAuth::post") << "requestTokenSecret   >" << requestTokenSecret << "<";
-    ofLogVerbose("ofxOAuth::post") << "accessToken          >" << accessToken << "<";
-    ofLogVerbose("ofxOAuth::post") << "accessTokenSecret    >" << accessTokenSecret << "<";
-    ofLogVerbose("ofxOAuth::post") << "-------------------";
-	
-    // collect any parameters in our list that need to be placed in the request URI
-    req_url = oauth_serialize_url_sep(argc, 0, argv, const_cast<char *>("&"), 1);
-
-    // collect any of the oauth parameters for inclusion in the HTTP Authorization header.
-    req_hdr = oauth_serialize_url_sep(argc, 1, argv, const_cast<char *>(", "), 2); // const_cast<char *>() is to avoid Deprecated
-    
-    // look at url parameters to be signed if you want.
-    if(ofGetLogLevel() <= OF_LOG_VERBOSE)
-        for (int i=0;i<argc; i++) ofLogVerbose("ofxOAuth::post") << " : " << i << ":" << argv[i];
-    
-    // free our parameter arrays that were allocated during parsing above
-    oauth_free_array(&argc, &argv);
-    
-    // construct the Authorization header.  Include realm information if available.
-    if(!realm.empty())
+
+    ofxOAuthParams params(_params);
+
+    ofLogVerbose(logTag) << "-------------------";
+    ofLogVerbose(logTag) << "consumerKey          >" << c->consumerKey << "<";
+    ofLogVerbose(logTag) << "consumerSecret       >" << c->consumerSecret << "<";
+    ofLogVerbose(logTag) << "requestToken         >" << c->requestToken << "<";
+    ofLogVerbose(logTag) << "requestTokenVerifier >" << c->requestTokenVerifier << "<";
+    ofLogVerbose(logTag) << "requestTokenSecret   >" << c->requestTokenSecret << "<";
+    ofLogVerbose(logTag) << "accessToken          >" << c->accessToken << "<";
+    ofLogVerbose(logTag) << "accessTokenSecret    >" << c->accessTokenSecret << "<";
+    ofLogVerbose(logTag) << "-------------------";
+
+    return _signParams(logTag,
+                       *c,
+                       method,
+                       c->apiURL + uri,
+                       params,
+                       c->accessToken,       //< token key - posted plain text in URL
+                       c->accessSigningKey,  //< precomputed HMAC-SHA1 key
+                       request);
+}
+
+//------------------------------------------------------------------------------
+bool ofxOAuth::_signParams(const std::string& logTag,
+                           const ofxOAuthCredentials& c,
+                           AuthHttpMethod method,
+                           const std::string& url,
+                           ofxOAuthParams& params,
+                           const std::string& tokenKey,
+                           const ofxOAuthHMACSHA1& signingKey,
+                           ofxOAuthTransportRequest& request) const
+{
+    // a POST sends the caller's parameters as a form body instead of in
+    // the url, so there is no limit on their size.  They are signed all
+    // the same.
+    std::string formBody;
+    if(method == OFX_HTTP_POST)
     {
-        // Note that (optional) 'realm' is not to be
-        // included in the oauth signed parameters and thus only added here.
-        // see 9.1.1 in http://oauth.net/core/1.0/#anchor14
-        http_hdr = "Authorization: OAuth realm=\"" + realm + "\", " + req_hdr;
+        params.appendQuery(formBody, false);
     }
-    else
+
+    // any parameters given as part of the url are signed too.
+    std::size_t queryStart = url.find('?');
+    if(queryStart != std::string::npos)
     {
-        http_hdr = "Authorization: OAuth " + req_hdr;
+        params.addQuery(url.substr(queryStart + 1));
     }
-	
-    ofLogVerbose("ofxOAuth::post") << "request URL    >" << req_url << "<";
-    ofLogVerbose("ofxOAuth::post") << "request HEADER >" << req_hdr << "<";
-    ofLogVerbose("ofxOAuth::post") << "http    HEADER >" << http_hdr << "<";
-	
-    reply = oauth_http_post2(req_url.c_str(),   // the base url to query
-							 "",				// the query string to send
-							 http_hdr.c_str());	// Authorization header is included here
-    
-    if (reply.empty())
+
+    request.method = _getHttpMethod(method);
+    request.account = c.consumerKey + "&" + tokenKey;
+
+    // sign the parameters and build the url and Authorization header in one pass.
+    if(!ofxOAuthSigner::signRequest(params,
+                                    request.method,
+                                    url,
+                                    c.signatureMethod,
+                                    c.consumerKey,
+                                    c.consumerSecret,
+                                    tokenKey,
+                                    signingKey,
+                                    c.realm,
+                                    request.url,
+                                    request.header))
     {
-        ofLogVerbose("ofxOAuth::post") << "HTTP get request failed.";
+        ofLogError(logTag) << "Unable to sign the request.";
+        return false;
     }
-    else
+
+    if(method == OFX_HTTP_POST)
     {
-        ofLogVerbose("ofxOAuth::post") << "HTTP-Reply: " << reply;
-        result = reply;
+        // only the parameters that were part of the url stay in it.
+        request.url = ofxOAuthSigner::normalizeURL(url.substr(0, queryStart));
+        if(queryStart != std::string::npos)
+        {
+            ofxOAuthParams urlParams(url.substr(queryStart + 1));
+            if(urlParams.querySize(false) > 0)
+            {
+                request.url += '?';
+                urlParams.appendQuery(request.url, false);
+            }
+        }
+        request.body.swap(formBody);
     }
-    
-	return result;
+
+    // look at url parameters to be signed if you want.
+    if(ofGetLogLevel() <= OF_LOG_VERBOSE)
+    {
+        for(std::size_t i = 0; i < params.size(); i++)
+        {
+            ofLogVerbose(logTag) << i << " >" << params.getKey(i) << "=" << params.getValue(i) << "<";
+        }
+    }
+
+    ofLogVerbose(logTag) << "request URL    >" << request.url << "<";
+    ofLogVerbose(logTag) << "http    HEADER >" << request.header << "<";
+    ofLogVerbose(logTag) << "form    BODY   >" << request.body << "<";
+
+    // liboauth's oauth_http_post2 always sent a body (if empty) with a POST.
+    request.hasBody = (method == OFX_HTTP_POST);
+
+    request.acceptCompression = acceptCompression;
+
+    return true;
 }
 
 //------------------------------------------------------------------------------
@@ -446,45 +941,34 @@ std::map<string, string> ofxOAuth::obtainRequestToken()
 {
     map<std::string, std::string> returnParams;
 
-    if(requestTokenURL.empty())
+    ofxOAuthCredentialsPtr c = getCredentials();
+
+    if(c->requestTokenURL.empty())
     {
         ofLogError("ofxOAuth::obtainRequestToken") << "No request token URL specified.";
         return returnParams;
     }
     
-    if(consumerKey.empty())
+    if(c->consumerKey.empty())
     {
         ofLogError("ofxOAuth::obtainRequestToken") << "No consumer key specified.";
         return returnParams;
     }
 
-    if(consumerSecret.empty())
+    if(c->consumerSecret.empty())
     {
         ofLogError("ofxOAuth::obtainRequestToken") << "No consumer secret specified.";
         return returnParams;
     }
 
-    std::string req_url;
-    std::string req_hdr;
-    std::string http_hdr;
-
     std::string reply;
-    
-    // oauth_sign_url2 (see oauth.h) in steps
-    int  argc   = 0;
-    char **argv = NULL;
-    
-    // break apart the url parameters to they can be signed below
-    // if desired we can also pass in additional patermeters (like oath* params)
-    // here.  For instance, if ?oauth_callback=XXX is defined in this url,
-    // it will be parsed and used in the Authorization header.
-    argc = oauth_split_url_parameters(requestTokenURL.c_str(), &argv);
+
+    ofxOAuthParams params;
     
     // add the authorization callback url info if available
     if(!getVerifierCallbackURL().empty())
     {
-        std::string callbackParam = "oauth_callback=" + getVerifierCallbackURL();
-        oauth_add_param_to_array(&argc, &argv, callbackParam.c_str());
+        params.add("oauth_callback", getVerifierCallbackURL());
     }
 
     // NOTE BELOW:
@@ -498,78 +982,53 @@ std::map<string, string> ofxOAuth::obtainRequestToken()
     
     if(!getApplicationDisplayName().empty())
     {
-        std::string displayNameParam = "xoauth_displayname=" + getApplicationDisplayName();
-        oauth_add_param_to_array(&argc, &argv, displayNameParam.c_str());
+        params.add("xoauth_displayname", getApplicationDisplayName());
     }
     
     if(!getApplicationScope().empty())
     {
-        // TODO: this will not be integrated correctly by lib oauth
-        // b/c it does not have a oauth / xoauth prefix
-        // XXXXXXXXXX
-        std::string scopeParam = "scope=" + getApplicationScope();
-        oauth_add_param_to_array(&argc, &argv, scopeParam.c_str());
+        // scope does not have an oauth_ prefix, so like xoauth_displayname
+        // it is signed and sent in the URL rather than the header.
+        params.add("scope", getApplicationScope());
     }
     
     
-    // NOTE: if desired, normal oatuh parameters, such as oauth_nonce could be overriden here
-    // rathern than having them auto-calculated using the oauth_sign_array2_process method
-    //oauth_add_param_to_array(&argc, &argv, "oauth_nonce=xxxxxxxpiOuDKDAmwHKZXXhGelPc4cJq");
-
-    // sign the array.
-    oauth_sign_array2_process(&argc, 
-                              &argv,
-                              NULL, //< postargs (unused)
-                              _getOAuthMethod(), // hash type, OA_HMAC, OA_RSA, OA_PLAINTEXT
-                              _getHttpMethod().c_str(), //< HTTP method (defaults to "GET")
-                              consumerKey.c_str(), //< consumer key - posted plain text
-                              consumerSecret.c_str(), //< consumer secret - used as 1st part of secret-key
-                              NULL,  //< token key - posted plain text in URL
-                              NULL); //< token secret - used as 2st part of secret-key
-    
+    // NOTE: if desired, normal oauth parameters, such as oauth_nonce could be overriden here
+    // rather than having them auto-calculated when signing.
+    //params.add("oauth_nonce", "xxxxxxxpiOuDKDAmwHKZXXhGelPc4cJq");
+
     ofLogVerbose("ofxOAuth::obtainRequestToken") << "-------------------";
-    ofLogVerbose("ofxOAuth::obtainRequestToken") << "consumerKey          >" << consumerKey << "<";
-    ofLogVerbose("ofxOAuth::obtainRequestToken") << "consumerSecret       >" << consumerSecret << "<";
-    ofLogVerbose("ofxOAuth::obtainRequestToken") << "requestToken         >" << requestToken << "<";
-    ofLogVerbose("ofxOAuth::obtainRequestToken") << "requestTokenVerifier >" << requestTokenVerifier << "<";
-    ofLogVerbose("ofxOAuth::obtainRequestToken") << "requestTokenSecret   >" << requestTokenSecret << "<";
-    ofLogVerbose("ofxOAuth::obtainRequestToken") << "accessToken          >" << accessToken << "<";
-    ofLogVerbose("ofxOAuth::obtainRequestToken") << "accessTokenSecret    >" << accessTokenSecret << "<";
+    ofLogVerbose("ofxOAuth::obtainRequestToken") << "consumerKey          >" << c->consumerKey << "<";
+    ofLogVerbose("ofxOAuth::obtainRequestToken") << "consumerSecret       >" << c->consumerSecret << "<";
+    ofLogVerbose("ofxOAuth::obtainRequestToken") << "requestToken         >" << c->requestToken << "<";
+    ofLogVerbose("ofxOAuth::obtainRequestToken") << "requestTokenVerifier >" << c->requestTokenVerifier << "<";
+    ofLogVerbose("ofxOAuth::obtainRequestToken") << "requestTokenSecret   >" << c->requestTokenSecret << "<";
+    ofLogVerbose("ofxOAuth::obtainRequestToken") << "accessToken          >" << c->accessToken << "<";
+    ofLogVerbose("ofxOAuth::obtainRequestToken") << "accessTokenSecret    >" << c->accessTokenSecret << "<";
     ofLogVerbose("ofxOAuth::obtainRequestToken") << "-------------------";
 
-    // collect any parameters in our list that need to be placed in the request URI
-    req_url = oauth_serialize_url_sep(argc, 0, argv, const_cast<char *>("&"), 1); 
-
-    // collect any of the oauth parameters for inclusion in the HTTP Authorization header.
-    req_hdr = oauth_serialize_url_sep(argc, 1, argv, const_cast<char *>(", "), 6); // const_cast<char *>() is to avoid Deprecated 
-
-    // look at url parameters to be signed if you want.
-    if(ofGetLogLevel() <= OF_LOG_VERBOSE)
-        for (int i=0;i<argc; i++) ofLogVerbose("ofxOAuth::obtainRequestToken") << i << " >" << argv[i] << "<";
-
-    // free our parameter arrays that were allocated during parsing above    
-    oauth_free_array(&argc, &argv);
-    
-    // construct the Authorization header.  Include realm information if available.
-    if(!realm.empty())
-    {
-        // Note that (optional) 'realm' is not to be 
-        // included in the oauth signed parameters and thus only added here.
-        // see 9.1.1 in http://oauth.net/core/1.0/#anchor14
-        http_hdr = "Authorization: OAuth realm=\"" + realm + "\", " + req_hdr; 
-    }
-    else
+    ofxOAuthTransportRequest request;
+
+    // sign the request.
+    if(!_signParams("ofxOAuth::obtainRequestToken",
+                    *c,
+                    httpMethod,
+                    c->requestTokenURL,
+                    params,
+                    "",                     //< no token yet
+                    c->consumerSigningKey,  //< precomputed HMAC-SHA1 key
+                    request))
     {
-        http_hdr = "Authorization: OAuth " + req_hdr;
+        _setAccessFailed();
+        return returnParams;
     }
 
-    ofLogVerbose("ofxOAuth::obtainRequestToken") << "Request URL    = " << req_url;
-    ofLogVerbose("ofxOAuth::obtainRequestToken") << "Request HEADER = " << req_hdr;
-    ofLogVerbose("ofxOAuth::obtainRequestToken") << "http    HEADER = " << http_hdr;
-    
-    reply = oauth_http_get2(req_url.c_str(),   // the base url to get
-                            NULL,              // the query string to send
-                            http_hdr.c_str()); // Authorization header is included here
+    ofxOAuthResponse response;
+    getTransport()->perform(request, response); // Authorization header is included here
+    reply = response.toString();
+
+    std::string newRequestToken;
+    std::string newRequestTokenSecret;
     
     if (reply.empty())
     {
@@ -591,11 +1050,11 @@ std::map<string, string> ofxOAuth::obtainRequestToken()
                 
                 if(Poco::icompare(tokens[0],"oauth_token") == 0)
                 {
-                    requestToken = tokens[1];
+                    newRequestToken = tokens[1];
                 }
                 else if(Poco::icompare(tokens[0],"oauth_token_secret") == 0)
                 {
-                    requestTokenSecret = tokens[1];
+                    newRequestTokenSecret = tokens[1];
                 }
                 else if(Poco::icompare(tokens[0],"oauth_callback_confirmed") == 0)
                 {
@@ -617,16 +1076,28 @@ std::map<string, string> ofxOAuth::obtainRequestToken()
         }
     }
     
-    if(requestTokenSecret.empty())
+    // publish the token and its secret together, so no request is ever
+    // signed with one and not the other.
+    if(!newRequestToken.empty() || !newRequestTokenSecret.empty())
+    {
+        ofScopedLock lock(credentialsMutex);
+        if(!newRequestToken.empty()) requestToken = newRequestToken;
+        if(!newRequestTokenSecret.empty()) requestTokenSecret = newRequestTokenSecret;
+        _publishCredentials();
+    }
+
+    c = getCredentials();
+
+    if(c->requestTokenSecret.empty())
     {
         ofLogWarning("ofxOAuth::obtainRequestToken") << "Request token secret not returned.";
-        accessFailed = true;
+        _setAccessFailed();
     }
 
-    if(requestToken.empty())
+    if(c->requestToken.empty())
     {
         ofLogWarning("ofxOAuth::obtainRequestToken") << "Request token not returned.";
-        accessFailed = true;
+        _setAccessFailed();
     }
 
     
@@ -637,127 +1108,91 @@ std::map<string, string> ofxOAuth::obtainRequestToken()
 std::map<std::string,std::string> ofxOAuth::obtainAccessToken()
 {
     std::map<std::string,std::string> returnParams;
+
+    ofxOAuthCredentialsPtr c = getCredentials();
     
-    if(accessTokenURL.empty())
+    if(c->accessTokenURL.empty())
     {
         ofLogError("ofxOAuth::obtainAccessToken") << "No access token URL specified.";
         return returnParams;
     }
     
-    if(consumerKey.empty())
+    if(c->consumerKey.empty())
     {
         ofLogError("ofxOAuth::obtainAccessToken") << "No consumer key specified.";
         return returnParams;
     }
     
-    if(consumerSecret.empty())
+    if(c->consumerSecret.empty())
     {
         ofLogError("ofxOAuth::obtainAccessToken") << "No consumer secret specified.";
         return returnParams;
     }
     
-    if(requestToken.empty())
+    if(c->requestToken.empty())
     {
         ofLogError("ofxOAuth::obtainAccessToken") << "No request token specified.";
         return returnParams;
     }
     
-    if(requestTokenSecret.empty())
+    if(c->requestTokenSecret.empty())
     {
         ofLogError("ofxOAuth::obtainAccessToken") << "No request token secret specified.";
         return returnParams;
     }
     
-    if(requestTokenVerifier.empty())
+    if(c->requestTokenVerifier.empty())
     {
         ofLogError("ofxOAuth::obtainAccessToken") << "No request token verifier specified.";
         return returnParams;
     }
     
-    std::string req_url;
-    std::string req_hdr;
-    std::string http_hdr;
-    
     std::string reply;
-    
-    // oauth_sign_url2 (see oauth.h) in steps
-    int  argc   = 0;
-    char **argv = NULL;
-    
-    // break apart the url parameters to they can be signed below
-    // if desired we can also pass in additional patermeters (like oath* params)
-    // here.  For instance, if ?oauth_callback=XXX is defined in this url,
-    // it will be parsed and used in the Authorization header.
-    argc = oauth_split_url_parameters(getAccessTokenURL().c_str(), &argv);
+
+    ofxOAuthParams params;
     
     // add the verifier param
-    std::string verifierParam = "oauth_verifier=" + requestTokenVerifier;
-    oauth_add_param_to_array(&argc, &argv, verifierParam.c_str());
+    params.add("oauth_verifier", c->requestTokenVerifier);
 
     // NOTE: if desired, normal oauth parameters, such as oauth_nonce could be overriden here
-    // rathern than having them auto-calculated using the oauth_sign_array2_process method
-    //oauth_add_param_to_array(&argc, &argv, "oauth_nonce=xxxxxxxpiOuDKDAmwHKZXXhGelPc4cJq");
-    
-    // sign the array.
-    oauth_sign_array2_process(&argc, 
-                              &argv,
-                              NULL, //< postargs (unused)
-                              _getOAuthMethod(), // hash type, OA_HMAC, OA_RSA, OA_PLAINTEXT
-                              _getHttpMethod().c_str(), //< HTTP method (defaults to "GET")
-                              consumerKey.c_str(), //< consumer key - posted plain text
-                              consumerSecret.c_str(), //< consumer secret - used as 1st part of secret-key
-                              requestToken.c_str(),  //< token key - posted plain text in URL
-                              requestTokenSecret.c_str()); //< token secret - used as 2st part of secret-key
+    // rather than having them auto-calculated when signing.
+    //params.add("oauth_nonce", "xxxxxxxpiOuDKDAmwHKZXXhGelPc4cJq");
 
     ofLogVerbose("ofxOAuth::obtainAccessToken") << "-------------------";
-    ofLogVerbose("ofxOAuth::obtainAccessToken") << "consumerKey          >" << consumerKey << "<";
-    ofLogVerbose("ofxOAuth::obtainAccessToken") << "consumerSecret       >" << consumerSecret << "<";
-    ofLogVerbose("ofxOAuth::obtainAccessToken") << "requestToken         >" << requestToken << "<";
-    ofLogVerbose("ofxOAuth::obtainAccessToken") << "requestTokenVerifier >" << requestTokenVerifier << "<";
-    ofLogVerbose("ofxOAuth::obtainAccessToken") << "requestTokenSecret   >" << requestTokenSecret << "<";
-    ofLogVerbose("ofxOAuth::obtainAccessToken") << "accessToken          >" << accessToken << "<";
-    ofLogVerbose("ofxOAuth::obtainAccessToken") << "accessTokenSecret    >" << accessTokenSecret << "<";
+    ofLogVerbose("ofxOAuth::obtainAccessToken") << "consumerKey          >" << c->consumerKey << "<";
+    ofLogVerbose("ofxOAuth::obtainAccessToken") << "consumerSecret       >" << c->consumerSecret << "<";
+    ofLogVerbose("ofxOAuth::obtainAccessToken") << "requestToken         >" << c->requestToken << "<";
+    ofLogVerbose("ofxOAuth::obtainAccessToken") << "requestTokenVerifier >" << c->requestTokenVerifier << "<";
+    ofLogVerbose("ofxOAuth::obtainAccessToken") << "requestTokenSecret   >" << c->requestTokenSecret << "<";
+    ofLogVerbose("ofxOAuth::obtainAccessToken") << "accessToken          >" << c->accessToken << "<";
+    ofLogVerbose("ofxOAuth::obtainAccessToken") << "accessTokenSecret    >" << c->accessTokenSecret << "<";
     ofLogVerbose("ofxOAuth::obtainAccessToken") << "-------------------";
-    
-    // collect any parameters in our list that need to be placed in the request URI
-    req_url = oauth_serialize_url_sep(argc, 0, argv, const_cast<char *>("&"), 1); 
-    
-    // collect any of the oauth parameters for inclusion in the HTTP Authorization header.
-    req_hdr = oauth_serialize_url_sep(argc, 1, argv, const_cast<char *>(", "), 6); // const_cast<char *>() is to avoid Deprecated 
-    
-    // look at url parameters to be signed if you want.
-    if(ofGetLogLevel() <= OF_LOG_VERBOSE)
-    {
-        for(int i=0; i < argc; i++)
-        {
-            ofLogVerbose("ofxOAuth::obtainAccessToken") << i << " >" << argv[i] << "<";
-        }
-    }
-    
-    // free our parameter arrays that were allocated during parsing above    
-    oauth_free_array(&argc, &argv);
-    
-    // construct the Authorization header.  Include realm information if available.
-    if(!realm.empty())
-    {
-        // Note that (optional) 'realm' is not to be 
-        // included in the oauth signed parameters and thus only added here.
-        // see 9.1.1 in http://oauth.net/core/1.0/#anchor14
-        http_hdr = "Authorization: OAuth realm=\"" + realm + "\", " + req_hdr; 
-    }
-    else
+
+    ofxOAuthTransportRequest request;
+
+    // sign the request.
+    if(!_signParams("ofxOAuth::obtainAccessToken",
+                    *c,
+                    httpMethod,
+                    c->accessTokenURL,
+                    params,
+                    c->requestToken,        //< token key - posted plain text in URL
+                    c->requestSigningKey,   //< precomputed HMAC-SHA1 key
+                    request))
     {
-        http_hdr = "Authorization: OAuth " + req_hdr;
+        _setAccessFailed();
+        return returnParams;
     }
-    
-    ofLogVerbose("ofxOAuth::obtainAccessToken") << "request URL    >" << req_url << "<";
-    ofLogVerbose("ofxOAuth::obtainAccessToken") << "request HEADER >" << req_hdr << "<";
-    ofLogVerbose("ofxOAuth::obtainAccessToken") << "http    HEADER >" << http_hdr << "<";
-    
-    reply = oauth_http_get2(req_url.c_str(),   // the base url to get
-                            NULL,              // the query string to send
-                            http_hdr.c_str()); // Authorization header is included here
-    
+
+    ofxOAuthResponse response;
+    getTransport()->perform(request, response); // Authorization header is included here
+    reply = response.toString();
+
+    std::string newAccessToken;
+    std::string newAccessTokenSecret;
+    std::string newEncodedUserId;
+    std::string newUserId;
+    std::string newScreenName;
     
     if (reply.empty())
     {
@@ -779,23 +1214,23 @@ std::map<std::string,std::string> ofxOAuth::obtainAccessToken()
                 
                 if(Poco::icompare(tokens[0],"oauth_token") == 0)
                 {
-                    accessToken = tokens[1];
+                    newAccessToken = tokens[1];
                 }
                 else if(Poco::icompare(tokens[0],"oauth_token_secret") == 0)
                 {
-                    accessTokenSecret = tokens[1];
+                    newAccessTokenSecret = tokens[1];
                 }
                 else if(Poco::icompare(tokens[0],"encoded_user_id") == 0)
                 {
-                    encodedUserId = tokens[1];
+                    newEncodedUserId = tokens[1];
                 }
                 else if(Poco::icompare(tokens[0],"user_id") == 0)
                 {
-                    userId = tokens[1];
+                    newUserId = tokens[1];
                 }
                 else if(Poco::icompare(tokens[0],"screen_name") == 0)
                 {
-                    screenName = tokens[1];
+                    newScreenName = tokens[1];
                 }
                 else if(Poco::icompare(tokens[0],"oauth_problem") == 0)
                 {
@@ -813,16 +1248,30 @@ std::map<std::string,std::string> ofxOAuth::obtainAccessToken()
         }
     }
     
-    if(accessTokenSecret.empty())
+    {
+        // this runs on the authorization thread, so the identity is
+        // published with the tokens rather than written to the members.
+        ofScopedLock lock(credentialsMutex);
+        if(!newAccessToken.empty()) accessToken = newAccessToken;
+        if(!newAccessTokenSecret.empty()) accessTokenSecret = newAccessTokenSecret;
+        if(!newEncodedUserId.empty()) encodedUserId = newEncodedUserId;
+        if(!newUserId.empty()) userId = newUserId;
+        if(!newScreenName.empty()) screenName = newScreenName;
+        _publishCredentials();
+    }
+
+    c = getCredentials();
+
+    if(c->accessTokenSecret.empty())
     {
         ofLogWarning("ofxOAuth::obtainAccessToken") << "Access token secret not returned.";
-        accessFailed = true;
+        _setAccessFailed();
     }
     
-    if(accessToken.empty())
+    if(c->accessToken.empty())
     {
         ofLogWarning("ofxOAuth::obtainAccessToken") << "Access token not returned.";
-        accessFailed = true;
+        _setAccessFailed();
     }
     
     // save it to an xml file!
@@ -854,7 +1303,20 @@ std::string ofxOAuth::requestUserVerification(std::string additionalAuthParams,
     url += getRequestToken();
     url += additionalAuthParams;
 
-    if(launchBrowser) ofLaunchBrowser(url);
+    if(launchBrowser)
+    {
+        if(ofThread::isMainThread())
+        {
+            ofLaunchBrowser(url);
+        }
+        else
+        {
+            // the next update() opens it on the main thread.
+            ofScopedLock lock(authStateMutex);
+            pendingBrowserURL = url;
+            _listenToUpdate(true);
+        }
+    }
 
     return url;
 }
@@ -862,66 +1324,81 @@ std::string ofxOAuth::requestUserVerification(std::string additionalAuthParams,
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getApiURL()
 {
-    return apiURL;
+    return getCredentials()->apiURL;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setApiURL(const std::string &v, bool autoSetEndpoints)
 {
-    apiURL = v; 
+    {
+        ofScopedLock lock(credentialsMutex);
+        apiURL = v;
+        _publishCredentials();
+    }
+
     if(autoSetEndpoints)
     {
-        setRequestTokenURL(apiURL + "/oauth/request_token");
-        setAccessTokenURL(apiURL + "/oauth/access_token");
-        setAuthorizationURL(apiURL + "/oauth/authorize");
+        setRequestTokenURL(v + "/oauth/request_token");
+        setAccessTokenURL(v + "/oauth/access_token");
+        setAuthorizationURL(v + "/oauth/authorize");
     }
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getRequestTokenURL()
 {
-    return requestTokenURL;
+    return getCredentials()->requestTokenURL;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setRequestTokenURL(const std::string& v)
 {
+    ofScopedLock lock(credentialsMutex);
     requestTokenURL = appendQuestionMark(v);
+    _publishCredentials();
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getAccessTokenURL()
 {
-    return accessTokenURL;
+    return getCredentials()->accessTokenURL;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setAccessTokenURL(const std::string& v)
 {
+    ofScopedLock lock(credentialsMutex);
     accessTokenURL = appendQuestionMark(v);
+    _publishCredentials();
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getAuthorizationURL()
 {
+    ofScopedLock lock(authStateMutex);
     return authorizationURL;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setAuthorizationURL(const std::string& v)
 {
-    authorizationURL = appendQuestionMark(v);
+    std::string url = appendQuestionMark(v);
+
+    ofScopedLock lock(authStateMutex);
+    authorizationURL = url;
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getVerifierCallbackURL()
 {
+    ofScopedLock lock(authStateMutex);
     return verifierCallbackURL;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setVerifierCallbackURL(const std::string& v)
 {
+    ofScopedLock lock(authStateMutex);
     verifierCallbackURL = v;
 }
 
@@ -953,73 +1430,91 @@ std::string ofxOAuth::getApplicationScope()
 //------------------------------------------------------------------------------
 bool ofxOAuth::isVerifierCallbackServerEnabled()
 {
+    ofScopedLock lock(authStateMutex);
     return enableVerifierCallbackServer;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setVerifierCallbackServerDocRoot(const std::string& v)
 {
+    ofScopedLock lock(authStateMutex);
     verifierCallbackServerDocRoot = v;
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getVerifierCallbackServerDocRoot()
 {
+    ofScopedLock lock(authStateMutex);
     return verifierCallbackServerDocRoot;
 }
 
 //------------------------------------------------------------------------------
 bool ofxOAuth::isVerifierCallbackPortSet() const
 {
+    ofScopedLock lock(authStateMutex);
     return vertifierCallbackServerPort > 0;
 }
 
 //------------------------------------------------------------------------------
 int ofxOAuth::getVerifierCallbackServerPort() const
 {
+    ofScopedLock lock(authStateMutex);
     return vertifierCallbackServerPort;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setVerifierCallbackServerPort(int portNumber)
 {
+    ofScopedLock lock(authStateMutex);
     vertifierCallbackServerPort = portNumber;
 }
 
+//------------------------------------------------------------------------------
+void ofxOAuth::setSharedVerifierCallbackServer(std::shared_ptr<ofxOAuthVerifierCallbackServer> server)
+{
+    ofScopedLock lock(authStateMutex);
+    sharedVerifierCallbackServer = server;
+}
+
 //------------------------------------------------------------------------------
 void ofxOAuth::setEnableVerifierCallbackServer(bool v)
 {
+    ofScopedLock lock(authStateMutex);
     enableVerifierCallbackServer = v;
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getRequestToken()
 {
-    return requestToken;
+    return getCredentials()->requestToken;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setRequestToken(const std::string& v)
 {
+    ofScopedLock lock(credentialsMutex);
     requestToken = v;
+    _publishCredentials();
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getRequestTokenSecret()
 {
-    return requestTokenSecret;
+    return getCredentials()->requestTokenSecret;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setRequestTokenSecret(const std::string& v)
 {
+    ofScopedLock lock(credentialsMutex);
     requestTokenSecret = v;
+    _publishCredentials();
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getRequestTokenVerifier()
 {
-    return requestTokenVerifier;
+    return getCredentials()->requestTokenVerifier;
 }
 
 //------------------------------------------------------------------------------
@@ -1039,115 +1534,154 @@ void ofxOAuth::setRequestTokenVerifier(const std::string& _requestToken,
 //------------------------------------------------------------------------------
 void ofxOAuth::setRequestTokenVerifier(const std::string& v)
 {
-    requestTokenVerifier = v;
+    {
+        ofScopedLock lock(credentialsMutex);
+        requestTokenVerifier = v;
+        _publishCredentials();
+    }
+
+    // wake the authorization thread if it is waiting for this.
+    verifierEvent.set();
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getAccessToken()
 {
-    return accessToken;
+    return getCredentials()->accessToken;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setAccessToken(const std::string& v)
 {
+    ofScopedLock lock(credentialsMutex);
     accessToken = v;
+    _publishCredentials();
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getAccessTokenSecret()
 {
-    return accessTokenSecret;
+    return getCredentials()->accessTokenSecret;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setAccessTokenSecret(const std::string& v)
 {
+    ofScopedLock lock(credentialsMutex);
     accessTokenSecret = v;
+    _publishCredentials();
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getEncodedUserId()
 {
-    return encodedUserId;
+    return getCredentials()->encodedUserId;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setEncodedUserId(const std::string& v)
 {
+    ofScopedLock lock(credentialsMutex);
     encodedUserId = v;
+    _publishCredentials();
+}
+
+//------------------------------------------------------------------------------
+std::string ofxOAuth::getScreenName()
+{
+    return getCredentials()->screenName;
+}
+
+//------------------------------------------------------------------------------
+void ofxOAuth::setScreenName(const std::string& v)
+{
+    ofScopedLock lock(credentialsMutex);
+    screenName = v;
+    _publishCredentials();
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getUserId()
 {
-    return userId;
+    return getCredentials()->userId;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setUserId(const std::string& v)
 {
+    ofScopedLock lock(credentialsMutex);
     userId = v;
+    _publishCredentials();
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getEncodedUserPassword()
 {
-    return encodedUserPassword;
+    return getCredentials()->encodedUserPassword;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setEncodedUserPassword(const std::string& v)
 {
+    ofScopedLock lock(credentialsMutex);
     encodedUserPassword = v;
+    _publishCredentials();
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getUserPassword()
 {
-    return userPassword;
+    return getCredentials()->userPassword;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setUserPassword(const std::string& v)
 {
+    ofScopedLock lock(credentialsMutex);
     userPassword = v;
+    _publishCredentials();
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getConsumerKey()
 {
-    return consumerKey;
+    return getCredentials()->consumerKey;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setConsumerKey(const std::string& v)
 {
+    ofScopedLock lock(credentialsMutex);
     consumerKey = v;
+    _publishCredentials();
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getConsumerSecret()
 {
-    return consumerSecret;
+    return getCredentials()->consumerSecret;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setConsumerSecret(const std::string& v)
 {
+    ofScopedLock lock(credentialsMutex);
     consumerSecret = v;
+    _publishCredentials();
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setApiName(const std::string& v)
 {
+    ofScopedLock lock(credentialsMutex);
     apiName = v;
+    _publishCredentials();
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getApiName()
 {
-    return apiName;
+    return getCredentials()->apiName;
 }
 
 //------------------------------------------------------------------------------
@@ -1207,26 +1741,43 @@ void ofxOAuth::receivedVerifierCallbackPostParams(const Poco::Net::NameValueColl
     {
         ofLogVerbose("ofxOAuth::receivedVerifierCallbackPostParams") << (*iter).first << "=" << (*iter).second;
     }
+
+    // providers using a form_post response mode send them here.
+    if(postParams.has("oauth_token") && postParams.has("oauth_verifier"))
+    {
+        setRequestTokenVerifier(postParams.get("oauth_token"), postParams.get("oauth_verifier"));
+    }
     
-    // does nothing with this, but subclasses might.
+    // subclasses might also want to extract other post parameters.
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getRealm()
 {
-    return realm;
+    return getCredentials()->realm;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setRealm(const std::string& v)
 {
+    ofScopedLock lock(credentialsMutex);
     realm = v;
+    _publishCredentials();
 }
 
 //------------------------------------------------------------------------------
 bool ofxOAuth::isAuthorized()
 {
-    return !accessToken.empty() && !accessTokenSecret.empty();
+    return getCredentials()->isAuthorized();
+}
+
+//------------------------------------------------------------------------------
+ofxOAuthCredentialsPtr ofxOAuth::getCredentials() const
+{
+    // the lock only covers the pointer copy.  the snapshot itself is
+    // immutable and stays alive for as long as anyone holds it.
+    ofScopedLock lock(credentialsMutex);
+    return credentials;
 }
 
 //------------------------------------------------------------------------------
@@ -1234,26 +1785,30 @@ void ofxOAuth::saveCredentials()
 {
     ofxXmlSettings XML;
 
-    XML.getValue("oauth:api_name", apiName);
+    // may run on the authorization thread, so only the snapshot is read.
+    ofxOAuthCredentialsPtr c = getCredentials();
+    std::string pathname = getCredentialsPathname();
+
+    XML.setValue("oauth:api_name", c->apiName);
 
-    XML.setValue("oauth:consumer_key", consumerKey);
-    XML.setValue("oauth:consumer_secret", consumerSecret);
+    XML.setValue("oauth:consumer_key", c->consumerKey);
+    XML.setValue("oauth:consumer_secret", c->consumerSecret);
 
-    XML.setValue("oauth:access_token", accessToken);
+    XML.setValue("oauth:access_token", c->accessToken);
 
-    XML.setValue("oauth:access_secret",accessTokenSecret);
+    XML.setValue("oauth:access_secret",c->accessTokenSecret);
     
-    XML.setValue("oauth:screen_name",screenName);
+    XML.setValue("oauth:screen_name", c->screenName);
     
-    XML.setValue("oauth:user_id", userId);
-    XML.setValue("oauth:user_id_encoded",encodedUserId);
+    XML.setValue("oauth:user_id", c->userId);
+    XML.setValue("oauth:user_id_encoded", c->encodedUserId);
 
-    XML.setValue("oauth:user_password", userPassword);
-    XML.setValue("oauth:user_password_encoded",encodedUserPassword);
+    XML.setValue("oauth:user_password", c->userPassword);
+    XML.setValue("oauth:user_password_encoded", c->encodedUserPassword);
 
-    if(!XML.saveFile(credentialsPathname))
+    if(!XML.saveFile(pathname))
     {
-        ofLogError("ofxOAuth::saveCredentials") << "Failed to save : " << credentialsPathname;
+        ofLogError("ofxOAuth::saveCredentials") << "Failed to save : " << pathname;
     }
 
 }
@@ -1262,8 +1817,9 @@ void ofxOAuth::saveCredentials()
 void ofxOAuth::loadCredentials()
 {
     ofxXmlSettings XML;
+    std::string pathname = getCredentialsPathname();
     
-    if(XML.loadFile(credentialsPathname))
+    if(XML.loadFile(pathname))
     {
 //        <oauth api="GENERIC">
 //          <consumer_secret></consumer_secret>
@@ -1277,10 +1833,12 @@ void ofxOAuth::loadCredentials()
 //        </oauth>
 
 
-        if(XML.getValue("oauth:consumer_key","") != consumerKey ||
-           XML.getValue("oauth:consumer_secret","") != consumerSecret)
+        ofxOAuthCredentialsPtr c = getCredentials();
+
+        if(XML.getValue("oauth:consumer_key","") != c->consumerKey ||
+           XML.getValue("oauth:consumer_secret","") != c->consumerSecret)
         {
-            ofLogError("ofxOAuth::loadCredentials") << "Found a credential file, but did not match the consumer secret / key provided.  Please delete your credentials file: " + ofToDataPath(credentialsPathname) + " and try again.";
+            ofLogError("ofxOAuth::loadCredentials") << "Found a credential file, but did not match the consumer secret / key provided.  Please delete your credentials file: " + ofToDataPath(pathname) + " and try again.";
             return;
         }
 
@@ -1288,10 +1846,12 @@ void ofxOAuth::loadCredentials()
         if(XML.getValue("oauth:access_token", "").empty() ||
            XML.getValue("oauth:access_secret","").empty())
         {
-            ofLogError("ofxOAuth::loadCredentials") << "Found a credential file, but access token / secret were empty.  Please delete your credentials file: " + ofToDataPath(credentialsPathname) + " and try again.";
+            ofLogError("ofxOAuth::loadCredentials") << "Found a credential file, but access token / secret were empty.  Please delete your credentials file: " + ofToDataPath(pathname) + " and try again.";
             return;
         }
 
+        ofScopedLock lock(credentialsMutex);
+
         apiName             = XML.getValue("oauth:api_name", "");
 
         accessToken         = XML.getValue("oauth:access_token", "");
@@ -1303,11 +1863,13 @@ void ofxOAuth::loadCredentials()
         encodedUserId       = XML.getValue("oauth:user_id_encoded","");
 
         userPassword        = XML.getValue("oauth:user_password", "");
-        encodedUserPassword = XML.getValue("oauth:user_password_encoded","");        
+        encodedUserPassword = XML.getValue("oauth:user_password_encoded","");
+
+        _publishCredentials();
     }
     else
     {
-        ofLogNotice("ofxOAuth::loadCredentials") << "Unable to locate credentials file: " << ofToDataPath(credentialsPathname);
+        ofLogNotice("ofxOAuth::loadCredentials") << "Unable to locate credentials file: " << ofToDataPath(pathname);
     }
     
 }
@@ -1315,39 +1877,164 @@ void ofxOAuth::loadCredentials()
 //------------------------------------------------------------------------------
 void ofxOAuth::setCredentialsPathname(const std::string& credentials)
 {
+    ofScopedLock lock(credentialsMutex);
     credentialsPathname = credentials;
 }
 
 //------------------------------------------------------------------------------
 std::string ofxOAuth::getCredentialsPathname()
 {
+    ofScopedLock lock(credentialsMutex);
     return credentialsPathname;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::resetErrors()
 {
-    accessFailed = false;
-    accessFailedReported = false;
+    {
+        ofScopedLock lock(authStateMutex);
+        accessFailed = false;
+        accessFailedReported = false;
+        _listenToUpdate(true);
+    }
+
+    // give a failed flow another go.
+    if(getAuthState() == OFX_AUTH_FAILED)
+    {
+        _startAuthorization();
+    }
 }
 
 //------------------------------------------------------------------------------
 ofxOAuth::AuthMethod ofxOAuth::getOAuthMethod()
 {
+    ofScopedLock lock(credentialsMutex);
     return oauthMethod;
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setOAuthMethod(AuthMethod _oauthMethod)
 {
+    ofScopedLock lock(credentialsMutex);
     oauthMethod = _oauthMethod;
+    _publishCredentials();
 }
 
 //------------------------------------------------------------------------------
 void ofxOAuth::setSSLCACertificateFile(const std::string& pathname)
 {
     SSLCACertificateFile = pathname;
-    setenv("CURLOPT_CAINFO", ofToDataPath(SSLCACertificateFile).c_str(), true);
+    getTransport()->setCACertificateFile(ofToDataPath(SSLCACertificateFile));
+}
+
+//------------------------------------------------------------------------------
+void ofxOAuth::setAcceptCompression(bool v)
+{
+    acceptCompression = v;
+}
+
+//------------------------------------------------------------------------------
+bool ofxOAuth::isAcceptCompression() const
+{
+    return acceptCompression;
+}
+
+//------------------------------------------------------------------------------
+void ofxOAuth::setBodyHashEnabled(bool v)
+{
+    bodyHashEnabled = v;
+}
+
+//------------------------------------------------------------------------------
+bool ofxOAuth::isBodyHashEnabled() const
+{
+    return bodyHashEnabled;
+}
+
+//------------------------------------------------------------------------------
+void ofxOAuth::setRetryPolicy(const ofxOAuthRetryPolicy& policy)
+{
+    ofScopedLock lock(retryPolicyMutex);
+    retryPolicy = policy;
+}
+
+//------------------------------------------------------------------------------
+ofxOAuthRetryPolicy ofxOAuth::getRetryPolicy() const
+{
+    ofScopedLock lock(retryPolicyMutex);
+    return retryPolicy;
+}
+
+//------------------------------------------------------------------------------
+void ofxOAuth::setResponseCache(std::shared_ptr<ofxOAuthResponseCache> cache)
+{
+    ofScopedLock lock(transportMutex);
+    responseCache = cache;
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<ofxOAuthResponseCache> ofxOAuth::getResponseCache()
+{
+    ofScopedLock lock(transportMutex);
+    return responseCache;
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<ofxOAuthTransport> ofxOAuth::getTransport()
+{
+    ofScopedLock lock(transportMutex);
+    return transport;
+}
+
+//------------------------------------------------------------------------------
+void ofxOAuth::setSharedContext(std::shared_ptr<ofxOAuthSharedContext> context)
+{
+    std::shared_ptr<ofxOAuthTransport> sharedTransport = context->getTransport();
+
+    // the first client to attach brings its certificate bundle along.
+    if(sharedTransport->getCACertificateFile().empty())
+    {
+        sharedTransport->setCACertificateFile(getTransport()->getCACertificateFile());
+    }
+
+    std::shared_ptr<ofxOAuthAsyncTransport> sharedAsyncTransport = context->getAsyncTransport();
+
+    ofScopedLock lock(transportMutex);
+    transport = sharedTransport;
+    asyncTransport = sharedAsyncTransport;
+}
+
+//------------------------------------------------------------------------------
+void ofxOAuth::_publishCredentials()
+{
+    // start from a copy of the current snapshot so the HMAC-SHA1 key
+    // schedules are only rebuilt when a secret actually changed.
+    std::shared_ptr<ofxOAuthCredentials> next(credentials == NULL ?
+                                              new ofxOAuthCredentials() :
+                                              new ofxOAuthCredentials(*credentials));
+
+    next->apiURL               = apiURL;
+    next->requestTokenURL      = requestTokenURL;
+    next->accessTokenURL       = accessTokenURL;
+    next->consumerKey          = consumerKey;
+    next->consumerSecret       = consumerSecret;
+    next->requestToken         = requestToken;
+    next->requestTokenSecret   = requestTokenSecret;
+    next->requestTokenVerifier = requestTokenVerifier;
+    next->accessToken          = accessToken;
+    next->accessTokenSecret    = accessTokenSecret;
+    next->realm                = realm;
+    next->signatureMethod      = _getOAuthMethod();
+    next->apiName              = apiName;
+    next->screenName           = screenName;
+    next->userId               = userId;
+    next->encodedUserId        = encodedUserId;
+    next->userPassword         = userPassword;
+    next->encodedUserPassword  = encodedUserPassword;
+
+    next->updateSigningKeys();
+
+    credentials = next;
 }
 
 //------------------------------------------------------------------------------
@@ -1368,16 +2055,16 @@ OAuthMethod ofxOAuth::_getOAuthMethod()
 }
 
 //------------------------------------------------------------------------------
-std::string ofxOAuth::_getHttpMethod()
+std::string ofxOAuth::_getHttpMethod(AuthHttpMethod method)
 {
-    switch (httpMethod)
+    switch (method)
     {
         case OFX_HTTP_GET:
             return "GET";
         case OFX_HTTP_POST:
             return "POST";
         default:
-            ofLogError("ofxOAuth::_getHttpMethod") << "Unknown HttpMethod, defaulting to GET. httpMethod=" << httpMethod;
+            ofLogError("ofxOAuth::_getHttpMethod") << "Unknown HttpMethod, defaulting to GET. httpMethod=" << method;
             return "GET";
     }
 }
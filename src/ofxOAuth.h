@@ -30,15 +30,30 @@
 #include <stdlib.h>
 #include <string.h>
 #include <oauth.h>
+#include "Poco/Event.h"
 #include "Poco/String.h"
 #include "ofMain.h"
 #include "ofxXmlSettings.h"
+#include "ofxOAuthTransport.h"
+#include "ofxOAuthAsyncTransport.h"
+#include "ofxOAuthCredentials.h"
+#include "ofxOAuthMessageSplitter.h"
+#include "ofxOAuthParams.h"
+#include "ofxOAuthResponseCache.h"
+#include "ofxOAuthRetryPolicy.h"
+#include "ofxOAuthSharedContext.h"
+#include "ofxOAuthSigner.h"
 #include "ofxOAuthVerifierCallbackServer.h"
 #include "ofxOAuthVerifierCallbackInterface.h"
 
 
+class ofxOAuthBulkFetch;
+
+
 class ofxOAuth: public ofxOAuthVerifierCallbackInterface
 {
+    friend class ofxOAuthBulkFetch; // signs its items as it sends them
+
 public:
     enum AuthMethod
     {
@@ -53,6 +68,26 @@ public:
         OFX_HTTP_POST
     };
 
+    enum AuthState
+    {
+        OFX_AUTH_UNAUTHORIZED=0,            // the flow has not started
+        OFX_AUTH_REQUESTING_TOKEN,          // obtainRequestToken() is running
+        OFX_AUTH_WAITING_FOR_VERIFIER,      // waiting for the user (callback server or oob)
+        OFX_AUTH_REQUESTING_ACCESS_TOKEN,   // obtainAccessToken() is running
+        OFX_AUTH_AUTHORIZED,
+        OFX_AUTH_FAILED                     // call resetErrors() to try again
+    };
+
+    class AuthStateEventArgs: public ofEventArgs
+    {
+    public:
+        AuthStateEventArgs(AuthState _state): state(_state)
+        {
+        }
+
+        AuthState state;
+    };
+
     ofxOAuth();
 
     virtual ~ofxOAuth();
@@ -68,15 +103,92 @@ public:
                const std::string& consumerKey,
                const std::string& consumerSecret);
 
+    // Starts the authorization flow and opens its browser page on the main
+    // thread.  It is registered with ofEvents().update until the flow has
+    // ended (authorized or failed), so it costs nothing per frame after.
     void update(ofEventArgs& args);
     
     bool isAuthorized();
 
+    AuthState getAuthState() const;
+
+    // Notified whenever the authorization flow changes state.  The token
+    // exchange runs on its own thread, so listeners are called from that
+    // thread, not the main thread.
+    ofEvent<AuthStateEventArgs> authStateChanged;
+
+    // The request methods below can be called from any number of threads
+    // at once.  Each call signs against the credentials snapshot that was
+    // current when it started (see getCredentials()) and never modifies
+    // the client, so a get() is always signed as a GET, and a post() as a
+    // POST, whatever other threads are doing.
     std::string get(const std::string& uri,
                     const std::string& queryParams = "");
 
     std::string post(const std::string& uri,
                      const std::string& queryParams = "");
+
+    // Structured versions of get() / post().  The parameters are signed,
+    // and sent in the URL (GET) or as a form body (POST), without
+    // re-parsing a query string.
+    std::string get(const std::string& uri,
+                    const ofxOAuthParams& params);
+
+    std::string post(const std::string& uri,
+                     const ofxOAuthParams& params);
+
+    // Like get() / post(), but the whole response is handed back: the
+    // status, the headers (ETag, Date, rate limits, ...), the timing and
+    // the body, in the pooled buffer it was received into instead of
+    // being copied into a string.
+    ofxOAuthResponse getResponse(const std::string& uri,
+                                 const std::string& queryParams = "");
+
+    ofxOAuthResponse postResponse(const std::string& uri,
+                                  const std::string& queryParams = "");
+
+    ofxOAuthResponse getResponse(const std::string& uri,
+                                 const ofxOAuthParams& params);
+
+    ofxOAuthResponse postResponse(const std::string& uri,
+                                  const ofxOAuthParams& params);
+
+    // Uploads a multipart/form-data body (fields and files), streamed
+    // from disk while it is sent.  Parameters in the uri's query string
+    // are signed; the form parts are not, as OAuth 1.0 requires.
+    ofxOAuthResponse postMultipart(const std::string& uri,
+                                   std::shared_ptr<ofxOAuthMultipartBody> body);
+
+    // Signs streamed bodies (postMultipart) with an oauth_body_hash, for
+    // servers that require it.  Off by default.  The body is hashed in a
+    // chunked pre-pass, so it is read from disk twice but never buffered.
+    void setBodyHashEnabled(bool v);
+    bool isBodyHashEnabled() const;
+
+    // Non-blocking versions of get() / post().  The request is signed on the
+    // calling thread and then run by a shared background event loop.  Wait
+    // on the returned result and / or pass a listener to be called back
+    // (from the event loop thread) when the request completes.
+    ofxOAuthAsyncResult getAsync(const std::string& uri,
+                                 const std::string& queryParams = "",
+                                 ofxOAuthRequestListener* listener = NULL);
+
+    ofxOAuthAsyncResult postAsync(const std::string& uri,
+                                  const std::string& queryParams = "",
+                                  ofxOAuthRequestListener* listener = NULL);
+
+    // Streaming versions of getAsync() / postAsync() for long-lived
+    // endpoints.  The body is handed to the listener as it arrives and is
+    // never accumulated; see ofxOAuthStreamListener for backpressure and
+    // ofxOAuthMessageStreamListener for splitting it into messages.  The
+    // result completes when the stream ends.
+    ofxOAuthAsyncResult getStream(const std::string& uri,
+                                  const std::string& queryParams,
+                                  ofxOAuthStreamListener* listener);
+
+    ofxOAuthAsyncResult postStream(const std::string& uri,
+                                   const std::string& queryParams,
+                                   ofxOAuthStreamListener* listener);
     
     // getters and setters
     std::string getApiURL();
@@ -108,6 +220,13 @@ public:
     int getVerifierCallbackServerPort() const;
     void setVerifierCallbackServerPort(int portNumber);
 
+    // Takes the redirect through a server shared with other clients, e.g.
+    // ofxOAuthVerifierCallbackServer::getShared(), instead of starting one
+    // of its own.  The redirect is matched to this client by its request
+    // token; the shared server's docRoot and port are used.  Call it
+    // before the authorization starts.
+    void setSharedVerifierCallbackServer(std::shared_ptr<ofxOAuthVerifierCallbackServer> server);
+
     
     // request token / secret
     std::string getRequestToken();
@@ -152,9 +271,46 @@ public:
     // token verifier
     std::string getRealm();
     void setRealm(const std::string& v);
+
+    // The current immutable credentials snapshot.  Every setter above
+    // that affects signing publishes a new one.
+    ofxOAuthCredentialsPtr getCredentials() const;
     
     
+    // The certificate authority bundle for this client's transport,
+    // relative to the data folder.  Clients using the same file share one
+    // parsed copy of it, see ofxOAuthCAStore.
     void setSSLCACertificateFile(const std::string& pathname);
+
+    // Ask for gzip / deflate compressed responses (on by default).  They
+    // are inflated as they arrive; see getTransport()->getStats() for the
+    // bytes saved.
+    void setAcceptCompression(bool v);
+    bool isAcceptCompression() const;
+
+    // How get() / post() and their Response versions retry failed
+    // requests (not at all by default) and hedge slow GETs (off by
+    // default).  Use ofxOAuthRetryPolicy::classify()
+    // on a response to tell a timeout from a 5xx from a 401.
+    void setRetryPolicy(const ofxOAuthRetryPolicy& policy);
+    ofxOAuthRetryPolicy getRetryPolicy() const;
+
+    // Answers repeated GETs from a cache when the server allows it, and
+    // revalidates stale answers with a conditional request.  Off (NULL)
+    // by default; a cache can be shared by several clients.
+    void setResponseCache(std::shared_ptr<ofxOAuthResponseCache> cache);
+    std::shared_ptr<ofxOAuthResponseCache> getResponseCache();
+
+    // the connection pool used for all signed requests
+    std::shared_ptr<ofxOAuthTransport> getTransport();
+    std::shared_ptr<ofxOAuthAsyncTransport> getAsyncTransport();
+
+    // Sends all requests through a context shared with other clients,
+    // e.g. ofxOAuthSharedContext::getDefault(), instead of this client's
+    // own connection pool.  Transport settings (certificates, timeouts)
+    // then apply to every client using the context.  Call it before
+    // issuing requests.
+    void setSharedContext(std::shared_ptr<ofxOAuthSharedContext> context);
     
     
     void setCredentialsPathname(const std::string& credentials);
@@ -178,23 +334,26 @@ protected:
                                         bool launchBrowser = true);
 
     
-    std::string credentialsPathname;
+    std::string credentialsPathname; // guarded by credentialsMutex
     
     // URLS
     std::string apiURL;
     
     std::string requestTokenURL;
     std::string accessTokenURL;
-    std::string authorizationURL;
-    std::string verifierCallbackURL;
+    std::string authorizationURL;    // guarded by authStateMutex
+    std::string verifierCallbackURL; // guarded by authStateMutex
 
     std::string applicationDisplayName;
     std::string applicationScope;
     
     bool callbackConfirmed;
+
+    // shared by the authorization thread and the app, guarded by authStateMutex.
     bool verificationRequested;
     bool accessFailed;
     bool accessFailedReported;
+    bool listeningToUpdate; // update() is registered with ofEvents().update
     
     // keys, secrets and verifiers
     
@@ -215,18 +374,42 @@ protected:
     std::string userId;
     std::string encodedUserPassword;
     std::string userPassword;
-    
+
+    // The fields above that are used for signing, and the identity of the
+    // account, are written under credentialsMutex and then published as a
+    // new snapshot.  Readers only take the lock long enough to copy the
+    // pointer.
+    ofxOAuthCredentialsPtr credentials;
+    mutable ofMutex credentialsMutex;
+
     // other stuff
     
     std::string realm;
     AuthMethod oauthMethod;
-    AuthHttpMethod httpMethod;
+    AuthHttpMethod httpMethod; // used for the request / access token exchange
+    bool acceptCompression;
+    bool bodyHashEnabled;
+
+    ofxOAuthRetryPolicy retryPolicy;
+    mutable ofMutex retryPolicyMutex;
+    ofxOAuthLatencyTracker latencies; // of successful GETs, for the hedge delay
+
     // where is our ssl cert bundles stored?
     std::string SSLCACertificateFile;
 
-    // authorization callback server
+    // keeps curl handles (and their open connections) alive between calls
+    std::shared_ptr<ofxOAuthTransport> transport;
+    std::shared_ptr<ofxOAuthAsyncTransport> asyncTransport; // created on demand
+    std::shared_ptr<ofxOAuthResponseCache> responseCache;
+    ofMutex transportMutex;
+
+    // authorization callback server.  The settings, the url and the server
+    // pointer are guarded by authStateMutex, but the server is only called
+    // without it held, as its requests call back into us.
     bool enableVerifierCallbackServer;
     std::shared_ptr<ofxOAuthVerifierCallbackServer> verifierCallbackServer;
+    std::shared_ptr<ofxOAuthVerifierCallbackServer> sharedVerifierCallbackServer;
+    std::string verifierCallbackRouteToken; // the request token the server routes to us
     std::string verifierCallbackServerDocRoot;
     int vertifierCallbackServerPort;
 
@@ -240,9 +423,137 @@ protected:
     std::string appendQuestionMark(const std::string& url) const;
 
 private:
-    OAuthMethod _getOAuthMethod();
-    std::string _getHttpMethod();
+    ofxOAuthResponse _perform(const std::string& logTag,
+                              AuthHttpMethod method,
+                              const std::string& uri,
+                              const ofxOAuthParams& params,
+                              std::shared_ptr<ofxOAuthBodySource> bodySource = std::shared_ptr<ofxOAuthBodySource>());
+
+    // One copy of a hedged request.  It is sent as a stream so the copy
+    // that loses the race can be cancelled.
+    class HedgeListener: public ofxOAuthStreamListener
+    {
+    public:
+        HedgeListener(Poco::Event& _doneEvent, std::shared_ptr<ofBuffer> _body):
+            doneEvent(_doneEvent),
+            body(_body),
+            done(false)
+        {
+        }
+
+        bool streamData(const char* data, std::size_t size)
+        {
+            body->append(data, size);
+            return true;
+        }
+
+        void requestCompleted(const ofxOAuthTransportResult& _result)
+        {
+            {
+                ofScopedLock lock(mutex);
+                result = _result;
+                done = true;
+            }
+            doneEvent.set();
+        }
+
+        bool isDone()
+        {
+            ofScopedLock lock(mutex);
+            return done;
+        }
+
+        bool isOk()
+        {
+            ofScopedLock lock(mutex);
+            return done && ofxOAuthRetryPolicy::classify(result.curlCode, result.status) == ofxOAuthRetryPolicy::NO_FAILURE;
+        }
+
+        // only once isDone().
+        void getResponse(ofxOAuthResponse& response)
+        {
+            ofScopedLock lock(mutex);
+            response.curlCode = result.curlCode;
+            response.status = result.status;
+            response.error.swap(result.error);
+            response.headers.swap(result.headers);
+            response.timing = result.timing;
+            response.body = body;
+        }
 
-    std::string _old_curlopt_cainfo;
+    private:
+        Poco::Event& doneEvent;
+        std::shared_ptr<ofBuffer> body;
+        ofxOAuthTransportResult result;
+        bool done;
+        ofMutex mutex;
+    };
+
+    void _performHedged(const std::string& logTag,
+                        AuthHttpMethod method,
+                        const std::string& uri,
+                        const ofxOAuthParams& params,
+                        const ofxOAuthTransportRequest& request,
+                        long hedgeDelayMillis,
+                        ofxOAuthResponse& response);
+
+    // Runs the request token / verification / access token exchange off
+    // the main thread, so the network round trips never stall a frame.
+    class AuthThread: public ofThread
+    {
+    public:
+        AuthThread(ofxOAuth& _client): client(_client)
+        {
+        }
+
+        void threadedFunction()
+        {
+            client._runAuthorization();
+        }
+
+    private:
+        ofxOAuth& client;
+    };
+
+    void _startAuthorization();
+    bool _isConfiguredForAuthorization() const;
+    void _listenToUpdate(bool listen); // must be called with authStateMutex held.
+    void _setAccessFailed();
+    void _runAuthorization();
+    void _stopVerifierCallbackServer();
+    void _setAuthState(AuthState state);
+
+    AuthThread authThread;
+    Poco::Event verifierEvent; // set when a verifier arrives, or to stop the thread
+    AuthState authState;
+    std::string pendingBrowserURL; // for update() to open on the main thread
+    mutable ofMutex authStateMutex;
+
+    bool _signRequest(const std::string& logTag,
+                      AuthHttpMethod method,
+                      const std::string& uri,
+                      const std::string& query,
+                      ofxOAuthTransportRequest& request) const;
+
+    bool _signRequest(const std::string& logTag,
+                      AuthHttpMethod method,
+                      const std::string& uri,
+                      const ofxOAuthParams& params,
+                      ofxOAuthTransportRequest& request) const;
+
+    bool _signParams(const std::string& logTag,
+                     const ofxOAuthCredentials& credentials,
+                     AuthHttpMethod method,
+                     const std::string& url,
+                     ofxOAuthParams& params,
+                     const std::string& tokenKey,
+                     const ofxOAuthHMACSHA1& signingKey,
+                     ofxOAuthTransportRequest& request) const;
+
+    // must be called with credentialsMutex held.
+    void _publishCredentials();
+
+    OAuthMethod _getOAuthMethod();
+    static std::string _getHttpMethod(AuthHttpMethod method);
     
 };
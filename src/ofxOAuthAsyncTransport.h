@@ -0,0 +1,748 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <climits>
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+#include <curl/multi.h>
+#include "Poco/ActiveResult.h"
+#include "Poco/Net/DatagramSocket.h"
+#include "Poco/Net/SocketAddress.h"
+#include "ofMain.h"
+#include "ofxOAuthTransport.h"
+
+#ifdef TARGET_WIN32
+#include <winsock2.h>
+#else
+#include <poll.h>
+#endif
+
+
+// A future for an asynchronous request.  Call wait() / available() and
+// data() to collect the result from any thread.
+typedef Poco::ActiveResult<ofxOAuthTransportResult> ofxOAuthAsyncResult;
+
+
+class ofxOAuthAsyncTransport;
+
+
+//------------------------------------------------------------------------------
+// Implement this to be told when an asynchronous request completes.
+// NOTE: requestCompleted is called from the transport's event loop thread,
+// so keep it short and protect any shared state.
+class ofxOAuthRequestListener
+{
+public:
+    ofxOAuthRequestListener()
+    {
+    }
+
+    virtual ~ofxOAuthRequestListener()
+    {
+    }
+
+    virtual void requestCompleted(const ofxOAuthTransportResult& result) = 0;
+
+};
+
+
+//------------------------------------------------------------------------------
+// Implement this to receive a response body piece by piece as it arrives
+// instead of all at once, e.g. for long-lived streaming endpoints.  The
+// body is never accumulated, so memory use does not grow with the length
+// of the stream.  requestCompleted() is called once when the stream ends
+// (result.body is empty).
+//
+// Backpressure: return false from streamData() when the data can't be
+// taken right now.  Nothing more is read from the socket until resume()
+// is called, so the server's send window fills up and it slows down; the
+// refused data is then delivered again.  streamResumed() is called first,
+// whether or not the stream was paused, so data the listener is holding
+// back can be handed on even if nothing more arrives.
+//
+// NOTE: streamData and streamResumed are called from the transport's
+// event loop thread.  resume() and cancel() may be called from any thread;
+// they wake the event loop, so they take effect right away.
+class ofxOAuthStreamListener: public ofxOAuthRequestListener
+{
+public:
+    ofxOAuthStreamListener():
+        resumeRequested(false),
+        cancelRequested(false),
+        transport(NULL)
+    {
+    }
+
+    virtual ~ofxOAuthStreamListener()
+    {
+    }
+
+    virtual bool streamData(const char* data, std::size_t size) = 0;
+
+    // Return false to stay paused until the next resume().
+    virtual bool streamResumed()
+    {
+        return true;
+    }
+
+    void resume();
+
+    // Ends the stream; it completes with CURLE_WRITE_ERROR.
+    void cancel();
+
+    bool isCancelled()
+    {
+        ofScopedLock lock(streamMutex);
+        return cancelRequested;
+    }
+
+    // Used by the transport: true once after each resume().
+    bool takeResumeRequest()
+    {
+        ofScopedLock lock(streamMutex);
+        bool result = resumeRequested;
+        resumeRequested = false;
+        return result;
+    }
+
+    // Used by the transport: the event loop that resume() and cancel()
+    // wake, NULL once the stream has ended.
+    void setTransport(ofxOAuthAsyncTransport* _transport)
+    {
+        ofScopedLock lock(streamMutex);
+        transport = _transport;
+    }
+
+private:
+    bool resumeRequested;
+    bool cancelRequested;
+    ofxOAuthAsyncTransport* transport;
+    ofMutex streamMutex;
+
+};
+
+
+//------------------------------------------------------------------------------
+class ofxOAuthAsyncTransfer: public ofxOAuthTransfer
+{
+public:
+    ofxOAuthAsyncTransfer(const ofxOAuthTransportRequest& request,
+                          ofxOAuthRequestListener* _listener,
+                          ofxOAuthStreamListener* _streamListener = NULL):
+        ofxOAuthTransfer(request),
+        future(new Poco::ActiveResultHolder<ofxOAuthTransportResult>()),
+        listener(_listener),
+        streamListener(_streamListener),
+        paused(false)
+    {
+    }
+
+    std::size_t write(const char* data, std::size_t size)
+    {
+        if(streamListener == NULL)
+        {
+            return ofxOAuthTransfer::write(data, size);
+        }
+
+        if(streamListener->isCancelled())
+        {
+            return 0;
+        }
+
+        if(!streamListener->streamData(data, size))
+        {
+            paused = true;
+            return CURL_WRITEFUNC_PAUSE;
+        }
+
+        return size;
+    }
+
+    // hands the result to the listener and wakes anyone waiting on the future.
+    void complete()
+    {
+        if(streamListener != NULL)
+        {
+            streamListener->setTransport(NULL);
+        }
+
+        if(listener != NULL)
+        {
+            listener->requestCompleted(result);
+        }
+
+        future.data(new ofxOAuthTransportResult(result));
+        future.notify();
+    }
+
+    ofxOAuthAsyncResult future;
+    ofxOAuthRequestListener* listener;
+    ofxOAuthStreamListener* streamListener;
+    bool paused;
+
+};
+
+
+//------------------------------------------------------------------------------
+// Runs any number of signed requests concurrently on a single background
+// thread using one curl multi handle.  Easy handles are borrowed from (and
+// returned to) the owning ofxOAuthTransport's pool.  While a handle is in
+// the multi handle it uses the multi handle's connection cache, not its
+// own, so asynchronous and blocking requests keep separate keep-alive
+// connections unless the transport has a share (see
+// ofxOAuthSharedContext) and libcurl is 7.57 or newer.
+//
+// The thread sleeps in poll() on curl's sockets and a wake-up socket until
+// there is network activity, a curl timer is due or submit() (or a stream
+// listener's resume() / cancel()) sends it a datagram, so an idle
+// transport never wakes up.  Before libcurl 7.28
+// curl's sockets come from curl_multi_fdset, which can't hold sockets
+// numbered FD_SETSIZE or higher; such connections fail instead.
+class ofxOAuthAsyncTransport: public ofThread
+{
+public:
+    ofxOAuthAsyncTransport(std::shared_ptr<ofxOAuthTransport> _transport):
+        transport(_transport),
+        multi(curl_multi_init()),
+        woken(false)
+    {
+        try
+        {
+            wakeSocket = Poco::Net::DatagramSocket(Poco::Net::SocketAddress("127.0.0.1", 0), true);
+        }
+        catch(const Poco::Exception& exc)
+        {
+            ofLogError("ofxOAuthAsyncTransport::ofxOAuthAsyncTransport") << "Could not bind the wake-up socket: " << exc.displayText();
+        }
+    }
+
+    virtual ~ofxOAuthAsyncTransport()
+    {
+        stopThread();
+        wake();
+        waitForThread(false);
+
+        // fail anything that was still queued or in flight.
+        std::set<ofxOAuthAsyncTransfer*>::iterator iter = active.begin();
+        while(iter != active.end())
+        {
+            curl_multi_remove_handle(multi, (*iter)->handle);
+            transport->finishTransfer(**iter, CURLE_ABORTED_BY_CALLBACK);
+            (*iter)->complete();
+            delete *iter;
+            ++iter;
+        }
+
+        active.clear();
+
+        std::multimap<unsigned long long, ofxOAuthAsyncTransfer*>::iterator delayedIter = delayed.begin();
+        while(delayedIter != delayed.end())
+        {
+            pending.push_back((*delayedIter).second);
+            ++delayedIter;
+        }
+
+        delayed.clear();
+
+        while(!pending.empty())
+        {
+            ofxOAuthAsyncTransfer* transfer = pending.front();
+            pending.pop_front();
+
+            // see submitFailed(), those keep their own error.
+            if(transfer->result.curlCode == CURLE_OK)
+            {
+                transfer->result.curlCode = CURLE_ABORTED_BY_CALLBACK;
+                transfer->result.error = "The transport was destroyed.";
+            }
+
+            transfer->complete();
+            delete transfer;
+        }
+
+        curl_multi_cleanup(multi);
+        wakeSocket.close();
+    }
+
+    ofxOAuthAsyncResult submit(const ofxOAuthTransportRequest& request,
+                               ofxOAuthRequestListener* listener = NULL)
+    {
+        return submit(new ofxOAuthAsyncTransfer(request, listener));
+    }
+
+    // Delivers the response body to the listener as it arrives.
+    ofxOAuthAsyncResult submitStream(const ofxOAuthTransportRequest& request,
+                                     ofxOAuthStreamListener* listener)
+    {
+        listener->setTransport(this);
+        return submit(new ofxOAuthAsyncTransfer(request, listener, listener));
+    }
+
+    ofxOAuthAsyncResult submit(ofxOAuthAsyncTransfer* transfer)
+    {
+        ofxOAuthAsyncResult future = transfer->future;
+
+        {
+            ofScopedLock lock(pendingMutex);
+            pending.push_back(transfer);
+
+            if(!isThreadRunning())
+            {
+                startThread(false, false);
+            }
+        }
+
+        wake();
+
+        return future;
+    }
+
+    // For a request that failed before it could be sent, e.g. because it
+    // couldn't be signed.  It completes with the given error on the event
+    // loop thread, like any other request, so the listener is never
+    // called back on the caller's thread.
+    ofxOAuthAsyncResult submitFailed(const std::string& error,
+                                     ofxOAuthRequestListener* listener = NULL)
+    {
+        ofxOAuthAsyncTransfer* transfer = new ofxOAuthAsyncTransfer(ofxOAuthTransportRequest(), listener);
+        transfer->result.curlCode = CURLE_FAILED_INIT;
+        transfer->result.error = error;
+        return submit(transfer);
+    }
+
+    void threadedFunction()
+    {
+        int running = 0;
+
+        while(isThreadRunning())
+        {
+            addPendingTransfers();
+
+            if(active.empty())
+            {
+                // nothing in flight, sleep until submit() or the destructor
+                // wakes us, or a rate limited request may go.
+                long delay = getMillisUntilNextDelayed();
+                if(delay != 0)
+                {
+                    std::vector<pollfd> fds;
+                    waitForSockets(fds, delay);
+                }
+                continue;
+            }
+
+            resumeStreams();
+
+            while(curl_multi_perform(multi, &running) == CURLM_CALL_MULTI_PERFORM);
+
+            collectCompletedTransfers();
+
+            if(!active.empty())
+            {
+                waitForActivity();
+            }
+        }
+    }
+
+    std::size_t getNumActive()
+    {
+        ofScopedLock lock(pendingMutex);
+        return active.size() + pending.size() + delayed.size();
+    }
+
+    // Ends the event loop's current wait.  Wake-ups that arrive while one
+    // is already pending cost nothing more.
+    void wake()
+    {
+        ofScopedLock lock(wakeMutex);
+
+        if(woken) return;
+
+        try
+        {
+            wakeSocket.sendTo("x", 1, wakeSocket.address());
+            woken = true;
+        }
+        catch(const Poco::Exception& exc)
+        {
+            ofLogError("ofxOAuthAsyncTransport::wake") << exc.displayText();
+        }
+    }
+
+protected:
+    void addPendingTransfers()
+    {
+        std::deque<ofxOAuthAsyncTransfer*> transfers;
+
+        {
+            ofScopedLock lock(pendingMutex);
+            transfers.swap(pending);
+
+            // rate limited requests whose wait is over (or that were
+            // cancelled meanwhile) go first.
+            unsigned long long now = ofGetElapsedTimeMillis();
+            std::deque<ofxOAuthAsyncTransfer*> ready;
+
+            std::multimap<unsigned long long, ofxOAuthAsyncTransfer*>::iterator iter = delayed.begin();
+            while(iter != delayed.end())
+            {
+                ofxOAuthAsyncTransfer* transfer = (*iter).second;
+
+                if((*iter).first <= now || (transfer->streamListener != NULL && transfer->streamListener->isCancelled()))
+                {
+                    ready.push_back(transfer);
+                    delayed.erase(iter++);
+                }
+                else
+                {
+                    ++iter;
+                }
+            }
+
+            transfers.insert(transfers.begin(), ready.begin(), ready.end());
+        }
+
+        while(!transfers.empty())
+        {
+            ofxOAuthAsyncTransfer* transfer = transfers.front();
+            transfers.pop_front();
+
+            // failed before it was submitted, see submitFailed().
+            if(transfer->result.curlCode != CURLE_OK)
+            {
+                transfer->complete();
+                delete transfer;
+                continue;
+            }
+
+            if(transfer->streamListener != NULL && transfer->streamListener->isCancelled())
+            {
+                transfer->result.curlCode = CURLE_WRITE_ERROR;
+                transfer->result.error = "The stream was cancelled.";
+                transfer->complete();
+                delete transfer;
+                continue;
+            }
+
+            long wait = transport->reserveRateLimit(*transfer);
+
+            if(wait > 0)
+            {
+                ofScopedLock lock(pendingMutex);
+                delayed.insert(std::make_pair(ofGetElapsedTimeMillis() + wait, transfer));
+                continue;
+            }
+
+            if(wait == 0 && transport->beginTransfer(*transfer))
+            {
+#if LIBCURL_VERSION_NUM < 0x071c00 && !defined(TARGET_WIN32)
+                curl_easy_setopt(transfer->handle, CURLOPT_SOCKOPTFUNCTION, &ofxOAuthAsyncTransport::checkSocket);
+#endif
+                curl_multi_add_handle(multi, transfer->handle);
+                if(transfer->streamListener != NULL) streams.insert(transfer);
+                ofScopedLock lock(pendingMutex);
+                active.insert(transfer);
+            }
+            else
+            {
+                transfer->complete();
+                delete transfer;
+            }
+        }
+    }
+
+    void collectCompletedTransfers()
+    {
+        int messagesLeft = 0;
+        CURLMsg* message = NULL;
+
+        while((message = curl_multi_info_read(multi, &messagesLeft)) != NULL)
+        {
+            if(message->msg != CURLMSG_DONE) continue;
+
+            CURL* handle = message->easy_handle;
+            CURLcode code = message->data.result;
+
+            ofxOAuthTransfer* base = NULL;
+            curl_easy_getinfo(handle, CURLINFO_PRIVATE, (char**)&base);
+
+            completeTransfer(static_cast<ofxOAuthAsyncTransfer*>(base), code);
+        }
+    }
+
+    void completeTransfer(ofxOAuthAsyncTransfer* transfer, CURLcode code)
+    {
+        curl_multi_remove_handle(multi, transfer->handle);
+
+        {
+            ofScopedLock lock(pendingMutex);
+            active.erase(transfer);
+        }
+
+        streams.erase(transfer);
+
+        transport->finishTransfer(*transfer, code);
+        transfer->complete();
+        delete transfer;
+    }
+
+    // Unpauses the streams whose listeners asked to resume and ends the
+    // ones that were cancelled.  A paused transfer's socket is left out of
+    // curl_multi_fdset, so it costs nothing while it waits.  The listener
+    // hears of a resume even if its stream isn't paused, as it may be
+    // holding back data that arrived earlier.
+    void resumeStreams()
+    {
+        std::vector<ofxOAuthAsyncTransfer*> cancelled;
+
+        std::set<ofxOAuthAsyncTransfer*>::iterator iter = streams.begin();
+
+        while(iter != streams.end())
+        {
+            ofxOAuthAsyncTransfer* transfer = *iter;
+
+            if(transfer->streamListener->isCancelled())
+            {
+                cancelled.push_back(transfer);
+            }
+            else if(transfer->streamListener->takeResumeRequest() &&
+                    transfer->streamListener->streamResumed() &&
+                    transfer->paused)
+            {
+                transfer->paused = false;
+                // this may call write() (and pause again) right away.
+                curl_easy_pause(transfer->handle, CURLPAUSE_CONT);
+            }
+
+            ++iter;
+        }
+
+        for(std::size_t i = 0; i < cancelled.size(); ++i)
+        {
+            completeTransfer(cancelled[i], CURLE_WRITE_ERROR);
+        }
+    }
+
+    // -1 if no request is waiting for its rate limit.
+    long getMillisUntilNextDelayed()
+    {
+        ofScopedLock lock(pendingMutex);
+
+        if(delayed.empty()) return -1;
+
+        unsigned long long now = ofGetElapsedTimeMillis();
+        unsigned long long next = (*delayed.begin()).first;
+
+        return next > now ? (long)(next - now) : 0;
+    }
+
+    void waitForActivity()
+    {
+        long timeoutMillis = -1;
+        curl_multi_timeout(multi, &timeoutMillis);
+
+        long delay = getMillisUntilNextDelayed();
+
+        if(delay >= 0 && (timeoutMillis < 0 || delay < timeoutMillis))
+        {
+            timeoutMillis = delay;
+        }
+
+        if(timeoutMillis == 0)
+        {
+            return;
+        }
+
+#if LIBCURL_VERSION_NUM >= 0x071c00
+        curl_waitfd wakeFd;
+        wakeFd.fd = wakeSocket.impl()->sockfd();
+        wakeFd.events = CURL_WAIT_POLLIN;
+        wakeFd.revents = 0;
+
+        int numFds = 0;
+        curl_multi_wait(multi, &wakeFd, 1, timeoutMillis < 0 ? INT_MAX : (int)timeoutMillis, &numFds);
+        takeWake();
+#else
+        fd_set readSet;
+        fd_set writeSet;
+        fd_set errorSet;
+
+        FD_ZERO(&readSet);
+        FD_ZERO(&writeSet);
+        FD_ZERO(&errorSet);
+
+        int maxfd = -1;
+
+        curl_multi_fdset(multi, &readSet, &writeSet, &errorSet, &maxfd);
+
+        // curl has no sockets to wait on yet (e.g. resolving), libcurl
+        // suggests trying again in 100 ms.
+        if(maxfd == -1 && (timeoutMillis < 0 || timeoutMillis > 100))
+        {
+            timeoutMillis = 100;
+        }
+
+        std::vector<pollfd> fds;
+        addSockets(fds, readSet, maxfd, POLLIN);
+        addSockets(fds, writeSet, maxfd, POLLOUT);
+        addSockets(fds, errorSet, maxfd, POLLPRI);
+
+        waitForSockets(fds, timeoutMillis);
+#endif
+    }
+
+    // Waits for one of fds or a wake-up, for at most timeoutMillis (-1
+    // for as long as it takes).
+    void waitForSockets(std::vector<pollfd>& fds, long timeoutMillis)
+    {
+        pollfd wakeFd;
+        wakeFd.fd = wakeSocket.impl()->sockfd();
+        wakeFd.events = POLLIN;
+        wakeFd.revents = 0;
+        fds.push_back(wakeFd);
+
+#ifdef TARGET_WIN32
+        WSAPoll(&fds[0], (ULONG)fds.size(), (INT)timeoutMillis);
+#else
+        ::poll(&fds[0], fds.size(), (int)timeoutMillis);
+#endif
+
+        takeWake();
+    }
+
+    // Reads the pending wake-up datagrams, so the next wait sleeps.
+    void takeWake()
+    {
+        ofScopedLock lock(wakeMutex);
+
+        try
+        {
+            char buffer[16];
+
+            while(wakeSocket.available() > 0)
+            {
+                wakeSocket.receiveBytes(buffer, sizeof(buffer));
+            }
+        }
+        catch(const Poco::Exception& exc)
+        {
+            ofLogError("ofxOAuthAsyncTransport::takeWake") << exc.displayText();
+        }
+
+        woken = false;
+    }
+
+#if LIBCURL_VERSION_NUM < 0x071c00
+    static void addSockets(std::vector<pollfd>& fds, fd_set& set, int maxfd, short events)
+    {
+#ifdef TARGET_WIN32
+        for(u_int i = 0; i < set.fd_count; ++i)
+        {
+            addSocket(fds, set.fd_array[i], events);
+        }
+#else
+        for(int fd = 0; fd <= maxfd; ++fd)
+        {
+            if(FD_ISSET(fd, &set)) addSocket(fds, fd, events);
+        }
+#endif
+    }
+
+    static void addSocket(std::vector<pollfd>& fds, curl_socket_t fd, short events)
+    {
+        for(std::size_t i = 0; i < fds.size(); ++i)
+        {
+            if(fds[i].fd == fd)
+            {
+                fds[i].events |= events;
+                return;
+            }
+        }
+
+        pollfd entry;
+        entry.fd = fd;
+        entry.events = events;
+        entry.revents = 0;
+        fds.push_back(entry);
+    }
+
+#ifndef TARGET_WIN32
+    // curl_multi_fdset can't report sockets that don't fit in an fd_set,
+    // so their connections are refused rather than never polled.
+    static int checkSocket(void*, curl_socket_t fd, curlsocktype)
+    {
+        if(fd >= FD_SETSIZE)
+        {
+            ofLogError("ofxOAuthAsyncTransport::checkSocket") << "Socket " << fd << " is beyond FD_SETSIZE (" << FD_SETSIZE << ").";
+            return CURL_SOCKOPT_ERROR;
+        }
+
+        return CURL_SOCKOPT_OK;
+    }
+#endif
+#endif
+
+    std::shared_ptr<ofxOAuthTransport> transport;
+
+    CURLM* multi;
+
+    std::deque<ofxOAuthAsyncTransfer*> pending;
+    std::set<ofxOAuthAsyncTransfer*> active;
+    std::set<ofxOAuthAsyncTransfer*> streams; // the active streaming transfers, event loop only
+
+    // requests held back by the rate limiter, by the time they may try again.
+    std::multimap<unsigned long long, ofxOAuthAsyncTransfer*> delayed;
+    ofMutex pendingMutex;
+
+    // submit(), the destructor and the stream listeners' resume() and
+    // cancel() send a datagram to it to end a poll().
+    Poco::Net::DatagramSocket wakeSocket;
+    bool woken; // a datagram is pending, guarded by wakeMutex
+    ofMutex wakeMutex;
+
+};
+
+
+//------------------------------------------------------------------------------
+inline void ofxOAuthStreamListener::resume()
+{
+    ofScopedLock lock(streamMutex);
+    resumeRequested = true;
+    if(transport != NULL) transport->wake();
+}
+
+
+//------------------------------------------------------------------------------
+inline void ofxOAuthStreamListener::cancel()
+{
+    ofScopedLock lock(streamMutex);
+    cancelRequested = true;
+    if(transport != NULL) transport->wake();
+}
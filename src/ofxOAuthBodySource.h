@@ -0,0 +1,56 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <stdint.h>
+#include <string>
+#include <curl/curl.h>
+
+
+//------------------------------------------------------------------------------
+// A request body that is produced piece by piece while it is sent, instead
+// of being held in memory (see ofxOAuthTransportRequest::bodySource).
+class ofxOAuthBodySource
+{
+public:
+    virtual ~ofxOAuthBodySource()
+    {
+    }
+
+    // The exact number of bytes read() will produce.
+    virtual uint64_t getSize() const = 0;
+
+    virtual std::string getContentType() const = 0;
+
+    // Starts over from the first byte.  Called before every send.
+    virtual bool rewind() = 0;
+
+    // Fills up to size bytes.  Returns the number written, 0 at the end,
+    // or CURL_READFUNC_ABORT on an error.
+    virtual std::size_t read(char* data, std::size_t size) = 0;
+
+};
@@ -0,0 +1,439 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <deque>
+#include "Poco/Event.h"
+#include "ofMain.h"
+#include "ofxOAuth.h"
+
+
+//------------------------------------------------------------------------------
+// The outcome of one item of a bulk fetch.  index is the position the item
+// was add()ed at.
+class ofxOAuthBulkResult
+{
+public:
+    ofxOAuthBulkResult():
+        index(0)
+    {
+    }
+
+    // true if a response arrived and it was a 2xx.
+    bool isOk() const
+    {
+        return result.isOk() && result.status >= 200 && result.status < 300;
+    }
+
+    std::size_t index;
+    std::string uri;
+    ofxOAuthTransportResult result;
+
+};
+
+
+//------------------------------------------------------------------------------
+// Implement this to be handed each result as soon as its item completes.
+// NOTE: itemCompleted is called from the transport's event loop thread
+// (or from cancel()), so keep it short and protect any shared state.
+class ofxOAuthBulkListener
+{
+public:
+    ofxOAuthBulkListener()
+    {
+    }
+
+    virtual ~ofxOAuthBulkListener()
+    {
+    }
+
+    virtual void itemCompleted(const ofxOAuthBulkResult& result) = 0;
+
+};
+
+
+//------------------------------------------------------------------------------
+// Fetches many signed requests with at most maxConcurrent of them in flight
+// at once, all on the client's async transport (and so its connection
+// pool).  Each item is signed just before it is sent, so the timestamps of
+// a long run stay fresh.  Results come back in completion order, either to
+// a listener or through next():
+//
+//     ofxOAuthBulkFetch bulk(client, 16);
+//     for(...) bulk.add(uri, query);
+//     bulk.start();
+//
+//     ofxOAuthBulkResult r;
+//     while(bulk.next(r))
+//     {
+//         if(!r.isOk()) ofLogWarning() << r.uri << ": " << r.result.status;
+//     }
+//
+// The client must outlive the fetch.  Destroying a running fetch cancels
+// it and waits for the requests in flight.
+class ofxOAuthBulkFetch
+{
+public:
+    ofxOAuthBulkFetch(ofxOAuth& _client, std::size_t _maxConcurrent = 8):
+        client(_client),
+        maxConcurrent(_maxConcurrent > 0 ? _maxConcurrent : 1),
+        listener(NULL),
+        started(false),
+        cancelled(false),
+        reservedIdleHandles(false),
+        nextIndex(0),
+        numInFlight(0),
+        numCompleted(0),
+        numFailed(0)
+    {
+    }
+
+    virtual ~ofxOAuthBulkFetch()
+    {
+        cancel();
+
+        // the items are the transfers' listeners, they must outlive them.
+        while(getNumInFlight() > 0)
+        {
+            completedEvent.tryWait(100);
+        }
+
+        releaseIdleHandles();
+    }
+
+    // Items can only be added before start().
+    void add(const std::string& uri,
+             const std::string& query = "",
+             ofxOAuth::AuthHttpMethod method = ofxOAuth::OFX_HTTP_GET)
+    {
+        ofScopedLock lock(mutex);
+
+        if(started)
+        {
+            ofLogError("ofxOAuthBulkFetch::add") << "Items can't be added after start().";
+            return;
+        }
+
+        items.push_back(Item(*this, items.size(), uri, query, method));
+    }
+
+    // Like add() above, with the parameters signed and sent as they are
+    // instead of parsed from a query string.
+    void add(const std::string& uri,
+             const ofxOAuthParams& params,
+             ofxOAuth::AuthHttpMethod method = ofxOAuth::OFX_HTTP_GET)
+    {
+        ofScopedLock lock(mutex);
+
+        if(started)
+        {
+            ofLogError("ofxOAuthBulkFetch::add") << "Items can't be added after start().";
+            return;
+        }
+
+        items.push_back(Item(*this, items.size(), uri, "", method));
+        items.back().params.reset(new ofxOAuthParams(params));
+    }
+
+    // Starts the first maxConcurrent requests; each completion starts the
+    // next one.  If a listener is given, results go to it instead of next().
+    void start(ofxOAuthBulkListener* _listener = NULL)
+    {
+        {
+            ofScopedLock lock(mutex);
+            if(started) return;
+            started = true;
+            listener = _listener;
+
+            // keep enough idle connections around that the items reuse
+            // them instead of reconnecting once the first wave completes,
+            // but only until the fetch is done; see releaseIdleHandles().
+            if(!items.empty())
+            {
+                transport = client.getTransport();
+                transport->reserveIdleHandles(maxConcurrent);
+                reservedIdleHandles = true;
+            }
+        }
+
+        submitNext();
+        completedEvent.set();
+    }
+
+    // Waits up to timeoutMillis (forever if negative) for the next result
+    // in completion order.  Returns false once every result has been
+    // returned, or on timeout.
+    bool next(ofxOAuthBulkResult& result, long timeoutMillis = -1)
+    {
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        while(true)
+        {
+            {
+                ofScopedLock lock(mutex);
+
+                if(!completed.empty())
+                {
+                    result = completed.front();
+                    completed.pop_front();
+                    return true;
+                }
+
+                if(listener != NULL || numCompleted == items.size())
+                {
+                    return false;
+                }
+            }
+
+            if(timeoutMillis < 0)
+            {
+                completedEvent.wait();
+            }
+            else
+            {
+                long elapsed = (long)(ofGetElapsedTimeMillis() - startTime);
+                if(elapsed >= timeoutMillis || !completedEvent.tryWait(timeoutMillis - elapsed))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Stops starting new requests.  The items that were never sent complete
+    // right away with CURLE_ABORTED_BY_CALLBACK; the ones in flight finish
+    // normally.
+    void cancel()
+    {
+        std::size_t first = 0;
+        std::size_t last = 0;
+
+        {
+            ofScopedLock lock(mutex);
+            if(cancelled) return;
+            cancelled = true;
+            first = nextIndex;
+            last = items.size();
+            nextIndex = last;
+        }
+
+        for(std::size_t i = first; i < last; ++i)
+        {
+            ofxOAuthTransportResult result;
+            result.curlCode = CURLE_ABORTED_BY_CALLBACK;
+            result.error = "The bulk fetch was cancelled.";
+            report(i, result);
+        }
+    }
+
+    bool isDone()
+    {
+        ofScopedLock lock(mutex);
+        return numCompleted == items.size();
+    }
+
+    std::size_t getNumItems()
+    {
+        ofScopedLock lock(mutex);
+        return items.size();
+    }
+
+    std::size_t getNumCompleted()
+    {
+        ofScopedLock lock(mutex);
+        return numCompleted;
+    }
+
+    std::size_t getNumFailed()
+    {
+        ofScopedLock lock(mutex);
+        return numFailed;
+    }
+
+    std::size_t getNumInFlight()
+    {
+        ofScopedLock lock(mutex);
+        return numInFlight;
+    }
+
+    std::size_t getMaxConcurrent() const
+    {
+        return maxConcurrent;
+    }
+
+protected:
+    class Item: public ofxOAuthRequestListener
+    {
+    public:
+        Item(ofxOAuthBulkFetch& _owner,
+             std::size_t _index,
+             const std::string& _uri,
+             const std::string& _query,
+             ofxOAuth::AuthHttpMethod _method):
+            owner(&_owner),
+            index(_index),
+            uri(_uri),
+            query(_query),
+            method(_method)
+        {
+        }
+
+        void requestCompleted(const ofxOAuthTransportResult& result)
+        {
+            ofxOAuthBulkFetch* fetch = owner;
+            fetch->report(index, result);
+            fetch->submitNext();
+
+            // this item and the fetch may be destroyed as soon as this
+            // returns, so it must be the last thing touched.
+            fetch->release();
+        }
+
+        ofxOAuthBulkFetch* owner;
+        std::size_t index;
+        std::string uri;
+        std::string query;
+        std::shared_ptr<ofxOAuthParams> params; // if added as parameters
+        ofxOAuth::AuthHttpMethod method;
+    };
+
+    // Starts items until maxConcurrent are in flight.  Runs on the caller
+    // of start() and then on the event loop thread as items complete.
+    void submitNext()
+    {
+        while(true)
+        {
+            Item* item = NULL;
+
+            {
+                ofScopedLock lock(mutex);
+                if(cancelled || nextIndex >= items.size() || numInFlight >= maxConcurrent) return;
+                item = &items[nextIndex++];
+                numInFlight++;
+            }
+
+            ofxOAuthTransportRequest request;
+            bool isSigned = false;
+
+            if(item->params != NULL)
+            {
+                isSigned = client._signRequest("ofxOAuthBulkFetch::submitNext", item->method, item->uri, *item->params, request);
+            }
+            else
+            {
+                isSigned = client._signRequest("ofxOAuthBulkFetch::submitNext", item->method, item->uri, item->query, request);
+            }
+
+            if(!isSigned)
+            {
+                ofxOAuthTransportResult result;
+                result.curlCode = CURLE_FAILED_INIT;
+                result.error = "Unable to sign the request.";
+                report(item->index, result);
+                release();
+                continue;
+            }
+
+            client.getAsyncTransport()->submit(request, item);
+        }
+    }
+
+    void report(std::size_t index, const ofxOAuthTransportResult& transportResult)
+    {
+        ofxOAuthBulkResult result;
+        result.index = index;
+        result.result = transportResult;
+
+        ofxOAuthBulkListener* l = NULL;
+        bool done = false;
+
+        {
+            ofScopedLock lock(mutex);
+            result.uri = items[index].uri;
+            numCompleted++;
+            if(!result.isOk()) numFailed++;
+            done = (numCompleted == items.size());
+            l = listener;
+            if(l == NULL) completed.push_back(result);
+        }
+
+        // every handle is back in the pool by now, as a transfer gives its
+        // handle back before its listener hears of it.
+        if(done) releaseIdleHandles();
+
+        if(l != NULL) l->itemCompleted(result);
+
+        completedEvent.set();
+    }
+
+    // Gives back the in flight slot taken by submitNext().  The destructor
+    // waits for numInFlight to reach zero, so nothing of the fetch may be
+    // used after this; the event is set under the lock so that the
+    // destructor can't get past it until the lock is released.
+    void release()
+    {
+        ofScopedLock lock(mutex);
+        numInFlight--;
+        completedEvent.set();
+    }
+
+    // Gives back the idle handles reserved by start(), once.
+    void releaseIdleHandles()
+    {
+        std::shared_ptr<ofxOAuthTransport> t;
+
+        {
+            ofScopedLock lock(mutex);
+            if(!reservedIdleHandles) return;
+            reservedIdleHandles = false;
+            t = transport;
+        }
+
+        t->releaseIdleHandles(maxConcurrent);
+    }
+
+    ofxOAuth& client;
+    std::shared_ptr<ofxOAuthTransport> transport; // the one start() reserved idle handles on
+    std::size_t maxConcurrent;
+    ofxOAuthBulkListener* listener;
+
+    // a deque, so the items (the transfers' listeners) never move.
+    std::deque<Item> items;
+    std::deque<ofxOAuthBulkResult> completed;
+
+    bool started;
+    bool cancelled;
+    bool reservedIdleHandles;
+    std::size_t nextIndex;
+    std::size_t numInFlight;
+    std::size_t numCompleted;
+    std::size_t numFailed;
+
+    ofMutex mutex;
+    Poco::Event completedEvent;
+
+};
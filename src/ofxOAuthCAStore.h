@@ -0,0 +1,250 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <curl/curl.h>
+#include "Poco/File.h"
+#include "Poco/Timestamp.h"
+#include "ofMain.h"
+
+// The shared store needs the OpenSSL headers.  Define
+// OFX_OAUTH_NO_OPENSSL_CA_STORE to build without them.
+#if !defined(OFX_OAUTH_NO_OPENSSL_CA_STORE)
+    #define OFX_OAUTH_OPENSSL_CA_STORE
+#endif
+
+#if defined(OFX_OAUTH_OPENSSL_CA_STORE)
+    #include <openssl/crypto.h>
+    #include <openssl/err.h>
+    #include <openssl/ssl.h>
+    #include <openssl/x509.h>
+#endif
+
+
+//------------------------------------------------------------------------------
+// A certificate authority bundle (e.g. cacert.pem) for a transport.
+//
+// Given only a CURLOPT_CAINFO path, curl reads and parses the whole bundle
+// again for every new connection.  Instead, the bundle is parsed once into
+// an X509 store, and each connection gets a reference to that store from a
+// CURLOPT_SSL_CTX_FUNCTION callback.  This needs the curl in use to be
+// built against the same OpenSSL the app links, which is checked at run
+// time; otherwise, or with OFX_OAUTH_NO_OPENSSL_CA_STORE defined, the path
+// is set on each handle as before.
+//
+// Stores are shared by path; get() only parses a bundle again after the
+// file has changed.
+class ofxOAuthCAStore
+{
+public:
+    typedef std::shared_ptr<ofxOAuthCAStore> Ptr;
+
+    static Ptr get(const std::string& pathname)
+    {
+        Poco::Timestamp modified(0);
+        Poco::File::FileSize size = 0;
+        getFileInfo(pathname, modified, size);
+
+        ofScopedLock lock(getRegistryMutex());
+
+        std::map<std::string, std::weak_ptr<ofxOAuthCAStore> >& registry = getRegistry();
+
+        Ptr store = registry[pathname].lock();
+
+        if(store == NULL || store->modified != modified || store->size != size)
+        {
+            store = Ptr(new ofxOAuthCAStore(pathname, modified, size));
+            registry[pathname] = store;
+        }
+
+        return store;
+    }
+
+    virtual ~ofxOAuthCAStore()
+    {
+#if defined(OFX_OAUTH_OPENSSL_CA_STORE)
+        if(x509Store != NULL) X509_STORE_free(x509Store);
+#endif
+    }
+
+    const std::string& getPathname() const
+    {
+        return pathname;
+    }
+
+    // True if the bundle was parsed into a store that is shared by all
+    // connections, false if each connection loads it from the path.
+    bool isParsed() const
+    {
+#if defined(OFX_OAUTH_OPENSSL_CA_STORE)
+        return x509Store != NULL && isOpenSSL();
+#else
+        return false;
+#endif
+    }
+
+    // The store must outlive the handle's transfer.
+    void configure(CURL* handle)
+    {
+#if defined(OFX_OAUTH_OPENSSL_CA_STORE)
+        if(x509Store != NULL && isOpenSSL() &&
+           curl_easy_setopt(handle, CURLOPT_SSL_CTX_FUNCTION, &ofxOAuthCAStore::sslContextCallback) == CURLE_OK)
+        {
+            curl_easy_setopt(handle, CURLOPT_SSL_CTX_DATA, this);
+            // nothing for curl to load, the callback hands over the store.
+            curl_easy_setopt(handle, CURLOPT_CAINFO, (char*)NULL);
+            curl_easy_setopt(handle, CURLOPT_CAPATH, (char*)NULL);
+            return;
+        }
+#endif
+        curl_easy_setopt(handle, CURLOPT_CAINFO, pathname.c_str());
+    }
+
+private:
+    ofxOAuthCAStore(const std::string& _pathname,
+                    Poco::Timestamp _modified,
+                    Poco::File::FileSize _size):
+        pathname(_pathname),
+        modified(_modified),
+        size(_size)
+    {
+#if defined(OFX_OAUTH_OPENSSL_CA_STORE)
+        // there's no use parsing a bundle the handles can't be given.
+        x509Store = isOpenSSL() ? X509_STORE_new() : NULL;
+
+        if(x509Store != NULL && X509_STORE_load_locations(x509Store, pathname.c_str(), NULL) != 1)
+        {
+            ofLogError("ofxOAuthCAStore") << "Could not load the certificate bundle " << pathname << ", curl will try to.";
+            X509_STORE_free(x509Store);
+            x509Store = NULL;
+            ERR_clear_error();
+        }
+#endif
+    }
+
+    ofxOAuthCAStore(const ofxOAuthCAStore&);
+    ofxOAuthCAStore& operator = (const ofxOAuthCAStore&);
+
+    static void getFileInfo(const std::string& pathname,
+                            Poco::Timestamp& modified,
+                            Poco::File::FileSize& size)
+    {
+        try
+        {
+            Poco::File file(pathname);
+
+            if(file.exists())
+            {
+                modified = file.getLastModified();
+                size = file.getSize();
+            }
+        }
+        catch(const Poco::Exception& exc)
+        {
+            ofLogVerbose("ofxOAuthCAStore::getFileInfo") << exc.displayText();
+        }
+    }
+
+    static std::map<std::string, std::weak_ptr<ofxOAuthCAStore> >& getRegistry()
+    {
+        static std::map<std::string, std::weak_ptr<ofxOAuthCAStore> > registry;
+        return registry;
+    }
+
+    static ofMutex& getRegistryMutex()
+    {
+        static ofMutex mutex;
+        return mutex;
+    }
+
+#if defined(OFX_OAUTH_OPENSSL_CA_STORE)
+    // curl can be built against another TLS library, or another OpenSSL
+    // than the one whose headers were found, and an X509_STORE can't be
+    // handed between two of them.
+    static bool isOpenSSL()
+    {
+        static const bool openSSL = checkOpenSSL();
+        return openSSL;
+    }
+
+    static bool checkOpenSSL()
+    {
+        curl_version_info_data* info = curl_version_info(CURLVERSION_NOW);
+
+        if(info == NULL || info->ssl_version == NULL) return false;
+
+        // e.g. "OpenSSL/1.0.1e" or "LibreSSL/2.8.3"
+        std::string curlSSL = info->ssl_version;
+
+        if(curlSSL.compare(0, 8, "OpenSSL/") != 0 &&
+           curlSSL.compare(0, 9, "LibreSSL/") != 0 &&
+           curlSSL.compare(0, 9, "BoringSSL") != 0)
+        {
+            return false;
+        }
+
+        curlSSL = curlSSL.substr(0, curlSSL.find(' '));
+        std::replace(curlSSL.begin(), curlSSL.end(), '/', ' ');
+
+        // e.g. "OpenSSL 1.0.1e 11 Feb 2013"
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+        std::string linkedSSL = OpenSSL_version(OPENSSL_VERSION);
+#else
+        std::string linkedSSL = SSLeay_version(SSLEAY_VERSION);
+#endif
+
+        return linkedSSL.compare(0, curlSSL.size(), curlSSL) == 0 &&
+               (linkedSSL.size() == curlSSL.size() || linkedSSL[curlSSL.size()] == ' ');
+    }
+
+    // Called for each new connection, after curl has set up the context.
+    static CURLcode sslContextCallback(CURL* handle, void* sslContext, void* userdata)
+    {
+        X509_STORE* x509Store = static_cast<ofxOAuthCAStore*>(userdata)->x509Store;
+
+        // the context releases its reference when it is freed.
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+        X509_STORE_up_ref(x509Store);
+#else
+        CRYPTO_add(&x509Store->references, 1, CRYPTO_LOCK_X509_STORE);
+#endif
+        SSL_CTX_set_cert_store(static_cast<SSL_CTX*>(sslContext), x509Store);
+
+        return CURLE_OK;
+    }
+
+    X509_STORE* x509Store;
+#endif
+
+    std::string pathname;
+    Poco::Timestamp modified;
+    Poco::File::FileSize size;
+
+};
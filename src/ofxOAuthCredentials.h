@@ -0,0 +1,97 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string>
+#include <oauth.h>
+#include "ofMain.h"
+#include "ofxOAuthSigner.h"
+
+
+//------------------------------------------------------------------------------
+// Everything needed to sign a request, captured at one point in time.
+// ofxOAuth never modifies a snapshot once it has been published; a setter
+// builds a new one and swaps the pointer.  A request holds on to the
+// snapshot it started with, so it is signed with a consistent set of
+// tokens and secrets even if another thread changes them mid-request.
+class ofxOAuthCredentials
+{
+public:
+    ofxOAuthCredentials():
+        signatureMethod(OA_HMAC)
+    {
+    }
+
+    bool isAuthorized() const
+    {
+        return !accessToken.empty() && !accessTokenSecret.empty();
+    }
+
+    // Brings the HMAC-SHA1 key schedules in line with the secrets.  A
+    // snapshot copied from the previous one only rebuilds the keys whose
+    // secrets actually changed.
+    void updateSigningKeys()
+    {
+        consumerSigningKey.setKey(ofxOAuthSigner::makeKey(consumerSecret, ""));
+        requestSigningKey.setKey(ofxOAuthSigner::makeKey(consumerSecret, requestTokenSecret));
+        accessSigningKey.setKey(ofxOAuthSigner::makeKey(consumerSecret, accessTokenSecret));
+    }
+
+    std::string apiURL;
+    std::string requestTokenURL;
+    std::string accessTokenURL;
+
+    std::string consumerKey;
+    std::string consumerSecret;
+
+    std::string requestToken;
+    std::string requestTokenSecret;
+    std::string requestTokenVerifier;
+
+    std::string accessToken;
+    std::string accessTokenSecret;
+
+    std::string realm;
+    OAuthMethod signatureMethod;
+
+    // who the tokens belong to, as the access token exchange or the
+    // credentials file told; saved along with them, never signed.
+    std::string apiName;
+    std::string screenName;
+    std::string userId;
+    std::string encodedUserId;
+    std::string userPassword;
+    std::string encodedUserPassword;
+
+    ofxOAuthHMACSHA1 consumerSigningKey; // consumerSecret&
+    ofxOAuthHMACSHA1 requestSigningKey;  // consumerSecret&requestTokenSecret
+    ofxOAuthHMACSHA1 accessSigningKey;   // consumerSecret&accessTokenSecret
+
+};
+
+
+typedef std::shared_ptr<const ofxOAuthCredentials> ofxOAuthCredentialsPtr;
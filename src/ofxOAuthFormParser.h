@@ -0,0 +1,362 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string.h>
+#include <string>
+#include "Poco/String.h"
+#include "Poco/Net/MessageHeader.h"
+#include "Poco/Net/NameValueCollection.h"
+#include "ofxOAuthPercentEncoding.h"
+
+
+//------------------------------------------------------------------------------
+// An incremental parser for application/x-www-form-urlencoded and
+// multipart/form-data request bodies.  The body is fed in with write() in
+// pieces of any size, and the fields are added to the collection as they
+// are completed.  Only the field being read (plus, for multipart, a
+// boundary's worth of look-ahead) is held, never the whole body.
+//
+// The parts of a multipart body that are file uploads (they have a
+// filename) are skipped.
+class ofxOAuthFormParser
+{
+public:
+    enum
+    {
+        CHUNK_SIZE = 4 * 1024,                  // what a reader should feed at a time
+        DEFAULT_MAX_BODY_SIZE = 1024 * 1024,
+        MAX_PART_HEADER_SIZE = 8 * 1024
+    };
+
+    // Fails (isOk() is false) once more than maxBodySize bytes are written.
+    ofxOAuthFormParser(const std::string& contentType,
+                       std::size_t _maxBodySize,
+                       Poco::Net::NameValueCollection& _params):
+        params(_params),
+        maxBodySize(_maxBodySize),
+        bodySize(0),
+        multipart(false),
+        state(FAILED),
+        isFilePart(false)
+    {
+        std::string type;
+        Poco::Net::NameValueCollection parameters;
+        Poco::Net::MessageHeader::splitParameters(contentType, type, parameters);
+
+        if(Poco::icompare(type, "application/x-www-form-urlencoded") == 0)
+        {
+            state = URLENCODED;
+        }
+        else if(Poco::icompare(type, "multipart/form-data") == 0 && parameters.has("boundary"))
+        {
+            multipart = true;
+            delimiter = "\r\n--" + parameters.get("boundary");
+            // the first boundary has no CRLF of its own before it.
+            pending = "\r\n";
+            state = PREAMBLE;
+        }
+    }
+
+    static bool canParse(const std::string& contentType)
+    {
+        std::string type;
+        Poco::Net::NameValueCollection parameters;
+        Poco::Net::MessageHeader::splitParameters(contentType, type, parameters);
+
+        return Poco::icompare(type, "application/x-www-form-urlencoded") == 0 ||
+               Poco::icompare(type, "multipart/form-data") == 0;
+    }
+
+    bool write(const char* data, std::size_t size)
+    {
+        if(state == FAILED) return false;
+
+        bodySize += size;
+
+        if(bodySize > maxBodySize)
+        {
+            state = FAILED;
+            return false;
+        }
+
+        if(!multipart)
+        {
+            writeURLEncoded(data, size);
+            return true;
+        }
+
+        pending.append(data, size);
+        parseMultipart();
+
+        return state != FAILED;
+    }
+
+    // Call it at the end of the body.  Returns false if the body was
+    // malformed, cut short or too large.
+    bool finish()
+    {
+        if(state == URLENCODED)
+        {
+            addURLEncodedField();
+            return true;
+        }
+
+        // a multipart body must end with the closing boundary.
+        return state == EPILOGUE;
+    }
+
+    bool isOk() const
+    {
+        return state != FAILED;
+    }
+
+    bool isTooLarge() const
+    {
+        return bodySize > maxBodySize;
+    }
+
+private:
+    enum State
+    {
+        URLENCODED,
+        PREAMBLE,          // before the first boundary
+        AFTER_BOUNDARY,    // "--" ends the body, CRLF starts a part
+        PART_HEADERS,
+        PART_BODY,
+        EPILOGUE,          // after the closing boundary, ignored
+        FAILED
+    };
+
+    void writeURLEncoded(const char* data, std::size_t size)
+    {
+        std::size_t start = 0;
+
+        while(start < size)
+        {
+            const char* amp = static_cast<const char*>(memchr(data + start, '&', size - start));
+
+            if(amp == NULL)
+            {
+                field.append(data + start, size - start);
+                return;
+            }
+
+            field.append(data + start, amp - (data + start));
+            addURLEncodedField();
+            start = (amp - data) + 1;
+        }
+    }
+
+    void addURLEncodedField()
+    {
+        if(!field.empty())
+        {
+            std::size_t equals = field.find('=');
+
+            if(equals == std::string::npos)
+            {
+                params.add(ofxOAuthPercentEncoding::decode(field), "");
+            }
+            else
+            {
+                params.add(ofxOAuthPercentEncoding::decode(field.substr(0, equals)),
+                           ofxOAuthPercentEncoding::decode(field.substr(equals + 1)));
+            }
+        }
+
+        field.clear();
+    }
+
+    void parseMultipart()
+    {
+        // each pass either consumes pending data or waits for more.
+        while(true)
+        {
+            switch(state)
+            {
+                case PREAMBLE:
+                {
+                    std::size_t pos = pending.find(delimiter);
+
+                    if(pos == std::string::npos)
+                    {
+                        keepTail();
+                        return;
+                    }
+
+                    pending.erase(0, pos + delimiter.size());
+                    state = AFTER_BOUNDARY;
+                    break;
+                }
+                case AFTER_BOUNDARY:
+                {
+                    if(pending.size() < 2) return;
+
+                    if(pending.compare(0, 2, "--") == 0)
+                    {
+                        pending.clear();
+                        state = EPILOGUE;
+                        return;
+                    }
+
+                    // the boundary line may end in transport padding.
+                    std::size_t pos = pending.find("\r\n");
+
+                    if(pos == std::string::npos)
+                    {
+                        if(pending.size() > MAX_PART_HEADER_SIZE) fail();
+                        return;
+                    }
+
+                    pending.erase(0, pos + 2);
+                    partName.clear();
+                    isFilePart = false;
+                    state = PART_HEADERS;
+                    break;
+                }
+                case PART_HEADERS:
+                {
+                    std::size_t end = 0;
+
+                    if(pending.compare(0, 2, "\r\n") == 0)
+                    {
+                        end = 0; // no headers at all
+                    }
+                    else
+                    {
+                        end = pending.find("\r\n\r\n");
+
+                        if(end == std::string::npos)
+                        {
+                            if(pending.size() > MAX_PART_HEADER_SIZE) fail();
+                            return;
+                        }
+
+                        parsePartHeaders(pending.substr(0, end));
+                        end += 2;
+                    }
+
+                    pending.erase(0, end + 2);
+                    field.clear();
+                    state = PART_BODY;
+                    break;
+                }
+                case PART_BODY:
+                {
+                    std::size_t pos = pending.find(delimiter);
+
+                    if(pos == std::string::npos)
+                    {
+                        // everything but a possible start of the delimiter.
+                        if(pending.size() >= delimiter.size())
+                        {
+                            std::size_t n = pending.size() - (delimiter.size() - 1);
+                            if(!isFilePart) field.append(pending, 0, n);
+                            pending.erase(0, n);
+                        }
+                        return;
+                    }
+
+                    if(!isFilePart)
+                    {
+                        field.append(pending, 0, pos);
+                        params.add(partName, field);
+                    }
+
+                    field.clear();
+                    pending.erase(0, pos + delimiter.size());
+                    state = AFTER_BOUNDARY;
+                    break;
+                }
+                case EPILOGUE:
+                    pending.clear();
+                    return;
+                default:
+                    return;
+            }
+        }
+    }
+
+    void parsePartHeaders(const std::string& headers)
+    {
+        std::size_t start = 0;
+
+        while(start < headers.size())
+        {
+            std::size_t end = headers.find("\r\n", start);
+            if(end == std::string::npos) end = headers.size();
+
+            std::string line = headers.substr(start, end - start);
+            std::size_t colon = line.find(':');
+
+            if(colon != std::string::npos &&
+               Poco::icompare(Poco::trim(line.substr(0, colon)), "Content-Disposition") == 0)
+            {
+                std::string disposition;
+                Poco::Net::NameValueCollection parameters;
+                Poco::Net::MessageHeader::splitParameters(line.substr(colon + 1), disposition, parameters);
+
+                partName = parameters.get("name", "");
+                isFilePart = parameters.has("filename");
+            }
+
+            start = end + 2;
+        }
+    }
+
+    // Keeps only what could be the start of a delimiter.
+    void keepTail()
+    {
+        if(pending.size() >= delimiter.size())
+        {
+            pending.erase(0, pending.size() - (delimiter.size() - 1));
+        }
+    }
+
+    void fail()
+    {
+        state = FAILED;
+        pending.clear();
+        field.clear();
+    }
+
+    Poco::Net::NameValueCollection& params;
+
+    std::size_t maxBodySize;
+    std::size_t bodySize;
+
+    bool multipart;
+    State state;
+
+    std::string field;     // the field being read
+    std::string pending;   // multipart input that is not parsed yet
+    std::string delimiter; // CRLF "--" boundary
+    std::string partName;
+    bool isFilePart;
+
+};
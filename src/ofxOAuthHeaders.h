@@ -0,0 +1,213 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+
+//------------------------------------------------------------------------------
+// The header fields of a response.  The header block is kept exactly as it
+// was received, line by line, and each field is a pair of offsets (name and
+// trimmed value) into it, so parsing and lookups never allocate and a
+// value is a view, not a copy.  Names are matched case-insensitively.
+class ofxOAuthHeaders
+{
+public:
+    struct Field
+    {
+        std::size_t nameOffset;
+        std::size_t nameLength;
+        std::size_t valueOffset;
+        std::size_t valueLength;
+    };
+
+    // Adds one raw header line (with or without its CRLF).  A status line
+    // starts a new header block, so only the headers of the final response
+    // are kept after a redirect or a 100 Continue.  Folded continuation
+    // lines are ignored.
+    void appendLine(const char* data, std::size_t lineSize)
+    {
+        std::size_t size = lineSize;
+        while(size > 0 && (data[size - 1] == '\r' || data[size - 1] == '\n')) --size;
+
+        if(size > 5 && data[0] == 'H' && data[1] == 'T' && data[2] == 'T' && data[3] == 'P' && data[4] == '/')
+        {
+            clear();
+            arena.append(data, lineSize);
+            return;
+        }
+
+        std::size_t lineOffset = arena.size();
+        arena.append(data, lineSize);
+
+        if(size == 0 || data[0] == ' ' || data[0] == '\t') return;
+
+        std::size_t colon = 0;
+        while(colon < size && data[colon] != ':') ++colon;
+        if(colon == 0 || colon == size) return;
+
+        std::size_t valueStart = colon + 1;
+        while(valueStart < size && (data[valueStart] == ' ' || data[valueStart] == '\t')) ++valueStart;
+
+        std::size_t valueEnd = size;
+        while(valueEnd > valueStart && (data[valueEnd - 1] == ' ' || data[valueEnd - 1] == '\t')) --valueEnd;
+
+        Field f;
+        f.nameOffset = lineOffset;
+        f.nameLength = colon;
+        f.valueOffset = lineOffset + valueStart;
+        f.valueLength = valueEnd - valueStart;
+        fields.push_back(f);
+    }
+
+    // Finds the first field called name.  Returns false if there is none.
+    bool find(const char* name, const char*& value, std::size_t& valueLength) const
+    {
+        std::size_t n = strlen(name);
+
+        for(std::size_t i = 0; i < fields.size(); ++i)
+        {
+            const Field& f = fields[i];
+            if(f.nameLength == n && equalsIgnoreCase(arena.data() + f.nameOffset, name, n))
+            {
+                value = arena.data() + f.valueOffset;
+                valueLength = f.valueLength;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool has(const char* name) const
+    {
+        const char* value = NULL;
+        std::size_t valueLength = 0;
+        return find(name, value, valueLength);
+    }
+
+    std::string get(const char* name, const std::string& defaultValue = "") const
+    {
+        const char* value = NULL;
+        std::size_t valueLength = 0;
+        return find(name, value, valueLength) ? std::string(value, valueLength) : defaultValue;
+    }
+
+    // Parses a numeric field (e.g. Content-Length, x-rate-limit-remaining).
+    long long getNumber(const char* name, long long defaultValue) const
+    {
+        const char* value = NULL;
+        std::size_t valueLength = 0;
+
+        if(!find(name, value, valueLength) || valueLength == 0) return defaultValue;
+
+        long long n = 0;
+        for(std::size_t i = 0; i < valueLength; ++i)
+        {
+            if(value[i] < '0' || value[i] > '9') return i > 0 ? n : defaultValue;
+            n = n * 10 + (value[i] - '0');
+        }
+
+        return n;
+    }
+
+    std::size_t size() const
+    {
+        return fields.size();
+    }
+
+    bool empty() const
+    {
+        return fields.empty();
+    }
+
+    const char* name(std::size_t i) const
+    {
+        return arena.data() + fields[i].nameOffset;
+    }
+
+    std::size_t nameLength(std::size_t i) const
+    {
+        return fields[i].nameLength;
+    }
+
+    const char* value(std::size_t i) const
+    {
+        return arena.data() + fields[i].valueOffset;
+    }
+
+    std::size_t valueLength(std::size_t i) const
+    {
+        return fields[i].valueLength;
+    }
+
+    std::string getName(std::size_t i) const
+    {
+        return std::string(name(i), nameLength(i));
+    }
+
+    std::string getValue(std::size_t i) const
+    {
+        return std::string(value(i), valueLength(i));
+    }
+
+    // The header block of the final response, status line included.
+    const std::string& getRaw() const
+    {
+        return arena;
+    }
+
+    void clear()
+    {
+        arena.clear();
+        fields.clear();
+    }
+
+    void swap(ofxOAuthHeaders& other)
+    {
+        arena.swap(other.arena);
+        fields.swap(other.fields);
+    }
+
+private:
+    static bool equalsIgnoreCase(const char* a, const char* b, std::size_t n)
+    {
+        for(std::size_t i = 0; i < n; ++i)
+        {
+            if(tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) return false;
+        }
+        return true;
+    }
+
+    std::string arena;
+    std::vector<Field> fields;
+
+};
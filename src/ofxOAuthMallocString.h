@@ -0,0 +1,93 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <stdlib.h>
+#include <string>
+
+
+//------------------------------------------------------------------------------
+// Owns a malloc'd C string, such as the ones returned by liboauth
+// (oauth_gen_nonce, oauth_sign_rsa_sha1, oauth_url_escape, ...), and
+// free()s it when it goes out of scope.
+//
+//     ofxOAuthMallocString nonce(oauth_gen_nonce());
+//     params.add("oauth_nonce", nonce.str());
+//
+class ofxOAuthMallocString
+{
+public:
+    explicit ofxOAuthMallocString(char* _data = NULL):
+        data(_data)
+    {
+    }
+
+    ~ofxOAuthMallocString()
+    {
+        free(data);
+    }
+
+    void reset(char* _data = NULL)
+    {
+        if(_data != data)
+        {
+            free(data);
+            data = _data;
+        }
+    }
+
+    // Gives up ownership; the caller must free() the result.
+    char* release()
+    {
+        char* result = data;
+        data = NULL;
+        return result;
+    }
+
+    const char* get() const
+    {
+        return data;
+    }
+
+    bool empty() const
+    {
+        return data == NULL || data[0] == 0;
+    }
+
+    // A copy of the string, or "" if liboauth returned NULL.
+    std::string str() const
+    {
+        return data != NULL ? std::string(data) : std::string();
+    }
+
+private:
+    ofxOAuthMallocString(const ofxOAuthMallocString&);
+    ofxOAuthMallocString& operator = (const ofxOAuthMallocString&);
+
+    char* data;
+
+};
@@ -0,0 +1,93 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string>
+#include "ofMain.h"
+
+#ifndef TARGET_WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+//------------------------------------------------------------------------------
+// A read-only view of a whole file, mapped where mmap is available.  data
+// is NULL if the file could not be read or is empty.
+class ofxOAuthMappedFile
+{
+public:
+    ofxOAuthMappedFile(const std::string& fileName):
+        data(NULL),
+        size(0)
+    {
+#ifndef TARGET_WIN32
+        int fd = open(fileName.c_str(), O_RDONLY);
+        if(fd < 0) return;
+
+        struct stat info;
+
+        if(fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            void* mapped = mmap(NULL, (std::size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if(mapped != MAP_FAILED)
+            {
+                data = static_cast<const char*>(mapped);
+                size = (std::size_t)info.st_size;
+            }
+        }
+
+        close(fd);
+#else
+        if(!ofFile(fileName).exists()) return;
+        buffer = ofBufferFromFile(fileName, true);
+        data = buffer.getBinaryBuffer();
+        size = buffer.size();
+#endif
+    }
+
+    ~ofxOAuthMappedFile()
+    {
+#ifndef TARGET_WIN32
+        if(data != NULL) munmap(const_cast<char*>(data), size);
+#endif
+    }
+
+    const char* data;
+    std::size_t size;
+
+private:
+#ifdef TARGET_WIN32
+    ofBuffer buffer;
+#endif
+    ofxOAuthMappedFile(const ofxOAuthMappedFile&);
+    ofxOAuthMappedFile& operator = (const ofxOAuthMappedFile&);
+
+};
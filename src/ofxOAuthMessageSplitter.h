@@ -0,0 +1,344 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string.h>
+#include <string>
+#include "ofxOAuthAsyncTransport.h"
+#include "ofxOAuthPercentEncoding.h"
+
+
+//------------------------------------------------------------------------------
+// Cuts a byte stream into messages as it arrives.
+//
+// NEWLINE_DELIMITED: each message ends with "\n" (or "\r\n").  Empty lines,
+// like the keep-alive newlines of Twitter's streaming api, are skipped.
+//
+// LENGTH_DELIMITED: each message is preceded by its size in bytes as a
+// decimal number on a line of its own (Twitter's "delimited=length").
+//
+// Only the unconsumed part of the stream is buffered.  write() refuses
+// more data while maxMessageSize bytes of complete messages are waiting
+// to be consumed, and an incomplete message larger than maxMessageSize is
+// an error, so memory use is bounded by maxMessageSize plus one write,
+// however long the stream is.
+class ofxOAuthMessageSplitter
+{
+public:
+    enum Framing
+    {
+        NEWLINE_DELIMITED,
+        LENGTH_DELIMITED
+    };
+
+    enum
+    {
+        DEFAULT_MAX_MESSAGE_SIZE = 1024 * 1024
+    };
+
+    ofxOAuthMessageSplitter(Framing _framing = NEWLINE_DELIMITED,
+                            std::size_t _maxMessageSize = DEFAULT_MAX_MESSAGE_SIZE):
+        framing(_framing),
+        maxMessageSize(_maxMessageSize),
+        start(0),
+        scanned(0),
+        peeked(false),
+        peekedStart(0),
+        peekedSize(0),
+        peekedNext(0),
+        error(false)
+    {
+    }
+
+    // Appends data to the stream.  Returns false, and takes nothing, if
+    // the consumer is behind, i.e. maxMessageSize bytes are buffered and
+    // there is a complete message waiting.  After an error the data is
+    // dropped.
+    bool write(const char* data, std::size_t size)
+    {
+        if(error)
+        {
+            return true;
+        }
+
+        if(getBufferedSize() >= maxMessageSize && hasMessage())
+        {
+            return false;
+        }
+
+        // drop the consumed bytes before growing the buffer.
+        if(start > 0 && start >= buffer.size() / 2)
+        {
+            buffer.erase(0, start);
+            scanned -= start;
+            start = 0;
+        }
+
+        peeked = false; // offsets may have moved
+        buffer.append(data, size);
+        return true;
+    }
+
+    bool hasMessage()
+    {
+        const char* data = NULL;
+        std::size_t size = 0;
+        return peek(data, size);
+    }
+
+    // Finds the next complete message.  data stays valid until the next
+    // call to write(), pop() or clear().
+    bool peek(const char*& data, std::size_t& size)
+    {
+        if(error) return false;
+
+        if(!peeked)
+        {
+            peeked = findMessage(peekedStart, peekedSize, peekedNext);
+            if(!peeked) return false;
+        }
+
+        data = buffer.data() + peekedStart;
+        size = peekedSize;
+        return true;
+    }
+
+    // Consumes the message returned by peek().
+    void pop()
+    {
+        const char* data = NULL;
+        std::size_t size = 0;
+
+        if(peek(data, size))
+        {
+            start = peekedNext;
+            scanned = peekedNext;
+            peeked = false;
+        }
+    }
+
+    // True if the stream can't be split any further: a message was larger
+    // than maxMessageSize or a length prefix was not a number.
+    bool hasError() const
+    {
+        return error;
+    }
+
+    std::size_t getBufferedSize() const
+    {
+        return buffer.size() - start;
+    }
+
+    void clear()
+    {
+        buffer.clear();
+        start = 0;
+        scanned = 0;
+        peeked = false;
+        error = false;
+    }
+
+private:
+    bool findMessage(std::size_t& messageStart, std::size_t& messageSize, std::size_t& next)
+    {
+        while(true)
+        {
+            std::size_t lineStart = start;
+            std::size_t lineEnd = 0;
+
+            if(!findLine(lineEnd))
+            {
+                if(getBufferedSize() > maxMessageSize + 2) error = true;
+                return false;
+            }
+
+            std::size_t lineSize = lineEnd - lineStart;
+            if(lineSize > 0 && buffer[lineEnd - 1] == '\r') --lineSize;
+
+            if(lineSize == 0)
+            {
+                // skip keep-alive blank lines.
+                start = lineEnd + 1;
+                scanned = start;
+                continue;
+            }
+
+            if(framing == NEWLINE_DELIMITED)
+            {
+                if(lineSize > maxMessageSize)
+                {
+                    error = true;
+                    return false;
+                }
+
+                messageStart = lineStart;
+                messageSize = lineSize;
+                next = lineEnd + 1;
+                return true;
+            }
+
+            std::size_t length = 0;
+
+            for(std::size_t i = lineStart; i < lineStart + lineSize; ++i)
+            {
+                char c = buffer[i];
+
+                if(c < '0' || c > '9' || length > maxMessageSize)
+                {
+                    error = true;
+                    return false;
+                }
+
+                length = length * 10 + (c - '0');
+            }
+
+            if(length > maxMessageSize)
+            {
+                error = true;
+                return false;
+            }
+
+            if(buffer.size() - (lineEnd + 1) < length)
+            {
+                // the message itself hasn't fully arrived yet.
+                return false;
+            }
+
+            messageStart = lineEnd + 1;
+            messageSize = length;
+            next = messageStart + length;
+            return true;
+        }
+    }
+
+    // Finds the next '\n' at or after start, without rescanning bytes that
+    // were already searched by an earlier call.
+    bool findLine(std::size_t& lineEnd)
+    {
+        if(scanned < start) scanned = start;
+
+        std::size_t offset = ofxOAuthPercentEncoding::findByte(buffer.data() + scanned,
+                                                              buffer.size() - scanned,
+                                                              '\n', '\n');
+
+        if(scanned + offset >= buffer.size())
+        {
+            scanned = buffer.size();
+            return false;
+        }
+
+        lineEnd = scanned + offset;
+        return true;
+    }
+
+    Framing framing;
+    std::size_t maxMessageSize;
+
+    std::string buffer;
+    std::size_t start;    // the first unconsumed byte
+    std::size_t scanned;  // bytes before this, from start, contain no '\n'
+
+    bool peeked;          // the next message has been found already
+    std::size_t peekedStart;
+    std::size_t peekedSize;
+    std::size_t peekedNext;
+
+    bool error;
+
+};
+
+
+//------------------------------------------------------------------------------
+// A stream listener that hands complete messages to messageReceived().
+// Return false from messageReceived() to stop taking messages: the
+// message is kept, the stream is paused before any more data is taken,
+// and delivery continues, with the held message, after resume().
+class ofxOAuthMessageStreamListener: public ofxOAuthStreamListener
+{
+public:
+    ofxOAuthMessageStreamListener(ofxOAuthMessageSplitter::Framing framing = ofxOAuthMessageSplitter::NEWLINE_DELIMITED,
+                                  std::size_t maxMessageSize = ofxOAuthMessageSplitter::DEFAULT_MAX_MESSAGE_SIZE):
+        splitter(framing, maxMessageSize)
+    {
+    }
+
+    virtual ~ofxOAuthMessageStreamListener()
+    {
+    }
+
+    virtual bool messageReceived(const char* data, std::size_t size) = 0;
+
+    bool streamData(const char* data, std::size_t size)
+    {
+        // messages held back earlier go first, and while one is still
+        // held the stream stays paused.
+        if(!deliverMessages())
+        {
+            return false;
+        }
+
+        if(!splitter.write(data, size))
+        {
+            return false;
+        }
+
+        deliverMessages();
+
+        if(splitter.hasError())
+        {
+            ofLogError("ofxOAuthMessageStreamListener::streamData") << "Unable to split the stream, cancelling it.";
+            cancel();
+        }
+
+        return true;
+    }
+
+    // The held message goes out on resume(), even if the stream is idle.
+    bool streamResumed()
+    {
+        return deliverMessages();
+    }
+
+protected:
+    // Returns false if a message is being held back.
+    bool deliverMessages()
+    {
+        const char* message = NULL;
+        std::size_t messageSize = 0;
+
+        while(splitter.peek(message, messageSize))
+        {
+            if(!messageReceived(message, messageSize)) return false;
+            splitter.pop();
+        }
+
+        return true;
+    }
+
+    ofxOAuthMessageSplitter splitter;
+
+};
@@ -0,0 +1,254 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <curl/curl.h>
+#include "ofMain.h"
+#include "ofxOAuthBodySource.h"
+
+
+//------------------------------------------------------------------------------
+// A multipart/form-data body.  Files are read from disk in small chunks as
+// the body is sent, so memory use stays flat whatever their size:
+//
+//     std::shared_ptr<ofxOAuthMultipartBody> body(new ofxOAuthMultipartBody());
+//     body->addField("status", "hello");
+//     body->addFile("media[]", ofToDataPath("video.mp4"), "video/mp4");
+//     client.postMultipart(url, body);
+//
+// NOTE: as OAuth 1.0 requires, the form parts are not signed.
+class ofxOAuthMultipartBody: public ofxOAuthBodySource
+{
+public:
+    ofxOAuthMultipartBody():
+        segment(0),
+        offset(0),
+        file(NULL)
+    {
+        char b[64];
+        sprintf(b, "----ofxOAuthBoundary%08x%08x", (unsigned int)rand(), (unsigned int)rand());
+        boundary = b;
+        closing.text = "--" + boundary + "--\r\n";
+        closing.size = closing.text.size();
+    }
+
+    virtual ~ofxOAuthMultipartBody()
+    {
+        closeFile();
+    }
+
+    void addField(const std::string& name, const std::string& value)
+    {
+        addText(getPartHeader(name, "", ""));
+        addText(value);
+        addText("\r\n");
+    }
+
+    // The file is only opened while it is sent.  Returns false if it
+    // can't be found.
+    bool addFile(const std::string& name,
+                 const std::string& path,
+                 const std::string& contentType = "application/octet-stream",
+                 const std::string& fileName = "")
+    {
+        ofFile f(path);
+
+        if(!f.exists() || !f.isFile())
+        {
+            ofLogError("ofxOAuthMultipartBody::addFile") << "No such file: " << path;
+            return false;
+        }
+
+        addText(getPartHeader(name, fileName.empty() ? f.getFileName() : fileName, contentType));
+
+        Segment s;
+        s.path = f.getAbsolutePath(); // read with fopen, not relative to data
+        s.size = f.getSize();
+        segments.push_back(s);
+
+        addText("\r\n");
+        return true;
+    }
+
+    uint64_t getSize() const
+    {
+        uint64_t size = closing.size;
+        for(std::size_t i = 0; i < segments.size(); ++i) size += segments[i].size;
+        return size;
+    }
+
+    std::string getContentType() const
+    {
+        return "multipart/form-data; boundary=" + boundary;
+    }
+
+    bool rewind()
+    {
+        closeFile();
+        segment = 0;
+        offset = 0;
+        return true;
+    }
+
+    std::size_t read(char* data, std::size_t size)
+    {
+        std::size_t written = 0;
+
+        while(written < size && segment <= segments.size())
+        {
+            const Segment& s = segment < segments.size() ? segments[segment] : closing;
+            std::size_t n = (std::size_t)std::min<uint64_t>(size - written, s.size - offset);
+
+            if(s.path.empty())
+            {
+                memcpy(data + written, s.text.data() + offset, n);
+            }
+            else
+            {
+                if(file == NULL)
+                {
+                    // the Content-Length was sent with the size the file
+                    // had when it was added.
+                    ofFile f(s.path);
+
+                    if(!f.exists() || f.getSize() != s.size)
+                    {
+                        ofLogError("ofxOAuthMultipartBody::read") << s.path << " changed since it was added.";
+                        return CURL_READFUNC_ABORT;
+                    }
+
+                    if((file = fopen(s.path.c_str(), "rb")) == NULL)
+                    {
+                        ofLogError("ofxOAuthMultipartBody::read") << "Unable to open " << s.path;
+                        return CURL_READFUNC_ABORT;
+                    }
+                }
+
+                if(n > 0 && fread(data + written, 1, n, file) != n)
+                {
+                    // the file changed since it was added.
+                    ofLogError("ofxOAuthMultipartBody::read") << "Unable to read " << s.path;
+                    return CURL_READFUNC_ABORT;
+                }
+            }
+
+            written += n;
+            offset += n;
+
+            if(offset == s.size)
+            {
+                closeFile();
+                segment++;
+                offset = 0;
+            }
+        }
+
+        return written;
+    }
+
+    const std::string& getBoundary() const
+    {
+        return boundary;
+    }
+
+protected:
+    // Literal text, or (if path is set) a whole file.
+    struct Segment
+    {
+        std::string text;
+        std::string path;
+        uint64_t size;
+    };
+
+    std::string getPartHeader(const std::string& name,
+                              const std::string& fileName,
+                              const std::string& contentType) const
+    {
+        std::string header = "--" + boundary + "\r\nContent-Disposition: form-data; name=\"" + escape(name) + "\"";
+        if(!fileName.empty()) header += "; filename=\"" + escape(fileName) + "\"";
+        header += "\r\n";
+        if(!contentType.empty()) header += "Content-Type: " + contentType + "\r\n";
+        header += "\r\n";
+        return header;
+    }
+
+    static std::string escape(const std::string& value)
+    {
+        std::string out;
+        for(std::size_t i = 0; i < value.size(); ++i)
+        {
+            if(value[i] == '"') out += "%22";
+            else if(value[i] == '\r') out += "%0D";
+            else if(value[i] == '\n') out += "%0A";
+            else out += value[i];
+        }
+        return out;
+    }
+
+    // Appends text, merged with the text segment before it.
+    void addText(const std::string& text)
+    {
+        if(segments.empty() || !segments.back().path.empty())
+        {
+            Segment s;
+            s.size = 0;
+            segments.push_back(s);
+        }
+
+        segments.back().text += text;
+        segments.back().size = segments.back().text.size();
+    }
+
+    void closeFile()
+    {
+        if(file != NULL)
+        {
+            fclose(file);
+            file = NULL;
+        }
+    }
+
+    std::string boundary;
+    std::vector<Segment> segments;
+    Segment closing; // the final boundary, sent after the segments
+
+    std::size_t segment;
+    uint64_t offset;
+    FILE* file;
+
+private:
+    ofxOAuthMultipartBody(const ofxOAuthMultipartBody&);
+    ofxOAuthMultipartBody& operator = (const ofxOAuthMultipartBody&);
+
+};
@@ -0,0 +1,327 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "ofxOAuthPercentEncoding.h"
+
+
+//------------------------------------------------------------------------------
+// A list of request parameters, kept in the percent-encoded form they are
+// signed and sent in.  All keys and values live back to back in a single
+// arena string and each parameter is just a pair of offsets into it, so
+// building, sorting and serializing a request touches one buffer instead
+// of allocating a string (or a malloc'd char*) per parameter.  The first
+// INLINE_CAPACITY parameters are stored without any allocation at all.
+class ofxOAuthParams
+{
+public:
+    struct Param
+    {
+        std::size_t keyOffset;
+        std::size_t keyLength;
+        std::size_t valueOffset;
+        std::size_t valueLength;
+    };
+
+    enum
+    {
+        INLINE_CAPACITY = 16,
+        DEFAULT_ARENA_SIZE = 512
+    };
+
+    ofxOAuthParams():
+        count(0)
+    {
+        arena.reserve(DEFAULT_ARENA_SIZE);
+    }
+
+    // Parses an "a=b&c=d" query string (escaped or not).
+    explicit ofxOAuthParams(const std::string& query):
+        count(0)
+    {
+        arena.reserve(DEFAULT_ARENA_SIZE + query.size() * 3);
+        addQuery(query);
+    }
+
+    // Adds an unescaped key / value pair.
+    void add(const std::string& key, const std::string& value)
+    {
+        add(key.data(), key.size(), value.data(), value.size(), false);
+    }
+
+    // Adds a key / value pair that may contain %XX escapes.  It is
+    // decoded and re-encoded canonically.
+    void addEscaped(const std::string& key, const std::string& value)
+    {
+        add(key.data(), key.size(), value.data(), value.size(), true);
+    }
+
+    // Adds every parameter of an "a=b&c=d" query string.
+    void addQuery(const std::string& query)
+    {
+        const char* data = query.data();
+        std::size_t size = query.size();
+        std::size_t start = 0;
+
+        while(start < size)
+        {
+            std::size_t end = start;
+            while(end < size && data[end] != '&') ++end;
+
+            if(end > start)
+            {
+                std::size_t equals = start;
+                while(equals < end && data[equals] != '=') ++equals;
+
+                if(equals < end)
+                {
+                    add(data + start, equals - start, data + equals + 1, end - equals - 1, true);
+                }
+                else
+                {
+                    add(data + start, end - start, data + end, 0, true);
+                }
+            }
+
+            start = end + 1;
+        }
+    }
+
+    // Looks up a key given in its encoded form (e.g. "oauth_nonce").
+    bool has(const std::string& encodedKey) const
+    {
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            const Param& p = at(i);
+            if(p.keyLength == encodedKey.size() &&
+               memcmp(arena.data() + p.keyOffset, encodedKey.data(), p.keyLength) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Sorts by encoded key, then encoded value, as required for the
+    // signature base string (OAuth 1.0 section 9.1.1).
+    void sort()
+    {
+        Param* begin = data();
+        std::sort(begin, begin + count, Compare(arena.data()));
+    }
+
+    void clear()
+    {
+        arena.clear();
+        overflow.clear();
+        count = 0;
+    }
+
+    std::size_t size() const
+    {
+        return count;
+    }
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    const char* key(std::size_t i) const
+    {
+        return arena.data() + at(i).keyOffset;
+    }
+
+    std::size_t keyLength(std::size_t i) const
+    {
+        return at(i).keyLength;
+    }
+
+    const char* value(std::size_t i) const
+    {
+        return arena.data() + at(i).valueOffset;
+    }
+
+    std::size_t valueLength(std::size_t i) const
+    {
+        return at(i).valueLength;
+    }
+
+    std::string getKey(std::size_t i) const
+    {
+        return std::string(key(i), keyLength(i));
+    }
+
+    std::string getValue(std::size_t i) const
+    {
+        return std::string(value(i), valueLength(i));
+    }
+
+    // oauth_* parameters go in the Authorization header, everything else
+    // in the request URL.
+    bool isProtocolParam(std::size_t i) const
+    {
+        return keyLength(i) > 6 && memcmp(key(i), "oauth_", 6) == 0;
+    }
+
+    // Appends "k=v&k=v" for the protocol (or non-protocol) parameters.
+    // Returns the number of parameters written.
+    std::size_t appendQuery(std::string& out, bool protocolParams) const
+    {
+        std::size_t written = 0;
+
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            if(isProtocolParam(i) != protocolParams) continue;
+            if(written > 0) out += '&';
+            out.append(key(i), keyLength(i));
+            out += '=';
+            out.append(value(i), valueLength(i));
+            ++written;
+        }
+
+        return written;
+    }
+
+    // The size appendQuery would add.
+    std::size_t querySize(bool protocolParams) const
+    {
+        std::size_t n = 0;
+
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            if(isProtocolParam(i) != protocolParams) continue;
+            n += keyLength(i) + valueLength(i) + 2;
+        }
+
+        return n;
+    }
+
+    std::string toString() const
+    {
+        std::string out;
+        out.reserve(querySize(false) + querySize(true));
+        appendQuery(out, false);
+        if(!out.empty() && querySize(true) > 0) out += '&';
+        appendQuery(out, true);
+        return out;
+    }
+
+private:
+    class Compare
+    {
+    public:
+        Compare(const char* _arena): arena(_arena)
+        {
+        }
+
+        bool operator () (const Param& a, const Param& b) const
+        {
+            int c = compare(arena + a.keyOffset, a.keyLength, arena + b.keyOffset, b.keyLength);
+            if(c != 0) return c < 0;
+            return compare(arena + a.valueOffset, a.valueLength, arena + b.valueOffset, b.valueLength) < 0;
+        }
+
+    private:
+        static int compare(const char* a, std::size_t na, const char* b, std::size_t nb)
+        {
+            int c = memcmp(a, b, na < nb ? na : nb);
+            if(c != 0) return c;
+            return na < nb ? -1 : (na > nb ? 1 : 0);
+        }
+
+        const char* arena;
+    };
+
+    void add(const char* k, std::size_t kn, const char* v, std::size_t vn, bool escaped)
+    {
+        Param p;
+
+        p.keyOffset = arena.size();
+        if(escaped)
+        {
+            ofxOAuthPercentEncoding::normalize(k, kn, arena);
+        }
+        else
+        {
+            ofxOAuthPercentEncoding::encode(k, kn, arena);
+        }
+        p.keyLength = arena.size() - p.keyOffset;
+
+        p.valueOffset = arena.size();
+        if(escaped)
+        {
+            ofxOAuthPercentEncoding::normalize(v, vn, arena);
+        }
+        else
+        {
+            ofxOAuthPercentEncoding::encode(v, vn, arena);
+        }
+        p.valueLength = arena.size() - p.valueOffset;
+
+        push(p);
+    }
+
+    void push(const Param& p)
+    {
+        if(count < INLINE_CAPACITY)
+        {
+            inlineParams[count] = p;
+        }
+        else
+        {
+            if(count == INLINE_CAPACITY)
+            {
+                // spill everything so data() stays contiguous.
+                overflow.assign(inlineParams, inlineParams + INLINE_CAPACITY);
+            }
+            overflow.push_back(p);
+        }
+
+        ++count;
+    }
+
+    Param* data()
+    {
+        return count > INLINE_CAPACITY ? &overflow[0] : inlineParams;
+    }
+
+    const Param& at(std::size_t i) const
+    {
+        return count > INLINE_CAPACITY ? overflow[i] : inlineParams[i];
+    }
+
+    std::string arena;
+    Param inlineParams[INLINE_CAPACITY];
+    std::vector<Param> overflow;
+    std::size_t count;
+
+};
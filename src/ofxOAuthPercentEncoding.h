@@ -0,0 +1,368 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define OFX_OAUTH_PERCENT_ENCODING_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define OFX_OAUTH_PERCENT_ENCODING_SSE2
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+
+//------------------------------------------------------------------------------
+// RFC 3986 percent-encoding as required by OAuth 1.0 (section 5.1): only
+// ALPHA, DIGIT, '-', '.', '_' and '~' are left as they are.
+//
+// The encoders write to any "sink" with an append(const char*, size_t)
+// method (std::string works), emitting unreserved runs in one call.
+//
+// Runs of bytes that can be copied through untouched are found 32 (AVX2)
+// or 16 (SSE2) bytes at a time; the scalar code only handles the bytes
+// that actually need escaping and the tail.  Define
+// OFX_OAUTH_PERCENT_ENCODING_SCALAR to force the scalar code.
+class ofxOAuthPercentEncoding
+{
+public:
+    static bool isUnreserved(unsigned char c)
+    {
+        return (c >= 'a' && c <= 'z') ||
+               (c >= 'A' && c <= 'Z') ||
+               (c >= '0' && c <= '9') ||
+               c == '-' || c == '.' || c == '_' || c == '~';
+    }
+
+    // The number of bytes encode() will produce.
+    static std::size_t encodedSize(const char* data, std::size_t size)
+    {
+        std::size_t n = size;
+        std::size_t i = 0;
+
+        while(i < size)
+        {
+            i += unreservedPrefix(data + i, size - i);
+
+            if(i < size)
+            {
+                n += 2;
+                ++i;
+            }
+        }
+
+        return n;
+    }
+
+    template<typename Sink>
+    static void encode(const char* data, std::size_t size, Sink& sink)
+    {
+        std::size_t i = 0;
+
+        while(i < size)
+        {
+            std::size_t run = unreservedPrefix(data + i, size - i);
+
+            if(run > 0)
+            {
+                sink.append(data + i, run);
+                i += run;
+            }
+
+            if(i < size)
+            {
+                appendEscaped((unsigned char)data[i], sink);
+                ++i;
+            }
+        }
+    }
+
+    static std::string encode(const std::string& value)
+    {
+        std::string result;
+        result.reserve(encodedSize(value.data(), value.size()));
+        encode(value.data(), value.size(), result);
+        return result;
+    }
+
+    // Decodes %XX sequences (and '+' as a space if plusAsSpace is set).
+    // Malformed escapes are copied through unchanged.
+    template<typename Sink>
+    static void decode(const char* data, std::size_t size, Sink& sink, bool plusAsSpace = true)
+    {
+        std::size_t runStart = 0;
+        std::size_t i = 0;
+
+        while(i < size)
+        {
+            i += findByte(data + i, size - i, '%', plusAsSpace ? '+' : '%');
+
+            if(i >= size) break;
+
+            char c = data[i];
+
+            if(c == '%' && i + 2 < size && isHex(data[i + 1]) && isHex(data[i + 2]))
+            {
+                if(i > runStart) sink.append(data + runStart, i - runStart);
+                char decoded = (char)((hexValue(data[i + 1]) << 4) | hexValue(data[i + 2]));
+                sink.append(&decoded, 1);
+                i += 3;
+                runStart = i;
+            }
+            else if(c == '+' && plusAsSpace)
+            {
+                if(i > runStart) sink.append(data + runStart, i - runStart);
+                sink.append(" ", 1);
+                ++i;
+                runStart = i;
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        if(size > runStart) sink.append(data + runStart, size - runStart);
+    }
+
+    static std::string decode(const std::string& value, bool plusAsSpace = true)
+    {
+        std::string result;
+        result.reserve(value.size());
+        decode(value.data(), value.size(), result, plusAsSpace);
+        return result;
+    }
+
+    // Re-encodes a string that may already contain escapes into canonical
+    // form, i.e. encode(decode(value)), without an intermediate string.
+    template<typename Sink>
+    static void normalize(const char* data, std::size_t size, Sink& sink, bool plusAsSpace = true)
+    {
+        EncodingSink<Sink> encoder(sink);
+        decode(data, size, encoder, plusAsSpace);
+    }
+
+    // Encodes a string that is already percent-encoded a second time.
+    // Canonically encoded strings only contain unreserved characters and
+    // '%', so only the '%' needs escaping.  This is used for the parameter
+    // part of the signature base string.
+    template<typename Sink>
+    static void encodeEncoded(const char* data, std::size_t size, Sink& sink)
+    {
+        std::size_t i = 0;
+
+        while(i < size)
+        {
+            std::size_t run = findByte(data + i, size - i, '%', '%');
+
+            if(run > 0)
+            {
+                sink.append(data + i, run);
+                i += run;
+            }
+
+            if(i < size)
+            {
+                sink.append("%25", 3);
+                ++i;
+            }
+        }
+    }
+
+    // The number of leading bytes that need no escaping.
+    static std::size_t unreservedPrefix(const char* data, std::size_t size)
+    {
+        std::size_t i = 0;
+
+#if !defined(OFX_OAUTH_PERCENT_ENCODING_SCALAR)
+#if defined(OFX_OAUTH_PERCENT_ENCODING_AVX2)
+        while(i + 32 <= size)
+        {
+            __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+
+            // bytes >= 0x80 are negative as signed chars, so they fail every range test.
+            __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+            __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                             _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+            __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)),
+                                             _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+            __m256i mark = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('-')),
+                                                           _mm256_cmpeq_epi8(c, _mm256_set1_epi8('.'))),
+                                           _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('_')),
+                                                           _mm256_cmpeq_epi8(c, _mm256_set1_epi8('~'))));
+
+            unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(alpha, digit), mark));
+
+            if(mask != 0xFFFFFFFFu)
+            {
+                return i + countTrailingZeros(~mask);
+            }
+
+            i += 32;
+        }
+#endif
+#if defined(OFX_OAUTH_PERCENT_ENCODING_SSE2)
+        while(i + 16 <= size)
+        {
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+
+            __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+            __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                          _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+            __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                          _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+            __m128i mark = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('-')),
+                                                     _mm_cmpeq_epi8(c, _mm_set1_epi8('.'))),
+                                        _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('_')),
+                                                     _mm_cmpeq_epi8(c, _mm_set1_epi8('~'))));
+
+            unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), mark));
+
+            if(mask != 0xFFFF)
+            {
+                return i + countTrailingZeros(~mask & 0xFFFF);
+            }
+
+            i += 16;
+        }
+#endif
+#endif
+
+        while(i < size && isUnreserved((unsigned char)data[i])) ++i;
+
+        return i;
+    }
+
+    // The offset of the first a or b byte, or size if there is none.
+    static std::size_t findByte(const char* data, std::size_t size, char a, char b)
+    {
+        std::size_t i = 0;
+
+#if !defined(OFX_OAUTH_PERCENT_ENCODING_SCALAR)
+#if defined(OFX_OAUTH_PERCENT_ENCODING_AVX2)
+        __m256i a32 = _mm256_set1_epi8(a);
+        __m256i b32 = _mm256_set1_epi8(b);
+
+        while(i + 32 <= size)
+        {
+            __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(c, a32),
+                                                                                   _mm256_cmpeq_epi8(c, b32)));
+            if(mask != 0)
+            {
+                return i + countTrailingZeros(mask);
+            }
+
+            i += 32;
+        }
+#endif
+#if defined(OFX_OAUTH_PERCENT_ENCODING_SSE2)
+        __m128i a16 = _mm_set1_epi8(a);
+        __m128i b16 = _mm_set1_epi8(b);
+
+        while(i + 16 <= size)
+        {
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(c, a16),
+                                                                             _mm_cmpeq_epi8(c, b16)));
+            if(mask != 0)
+            {
+                return i + countTrailingZeros(mask);
+            }
+
+            i += 16;
+        }
+#endif
+#endif
+
+        while(i < size && data[i] != a && data[i] != b) ++i;
+
+        return i;
+    }
+
+private:
+    static std::size_t countTrailingZeros(unsigned int v)
+    {
+#if defined(_MSC_VER)
+        unsigned long index = 0;
+        _BitScanForward(&index, v);
+        return index;
+#else
+        return __builtin_ctz(v);
+#endif
+    }
+
+    template<typename Sink>
+    class EncodingSink
+    {
+    public:
+        EncodingSink(Sink& _sink): sink(_sink)
+        {
+        }
+
+        void append(const char* data, std::size_t size)
+        {
+            ofxOAuthPercentEncoding::encode(data, size, sink);
+        }
+
+    private:
+        Sink& sink;
+    };
+
+    template<typename Sink>
+    static void appendEscaped(unsigned char c, Sink& sink)
+    {
+        static const char hex[] = "0123456789ABCDEF";
+        char escaped[3];
+        escaped[0] = '%';
+        escaped[1] = hex[c >> 4];
+        escaped[2] = hex[c & 0x0F];
+        sink.append(escaped, 3);
+    }
+
+    static bool isHex(char c)
+    {
+        return (c >= '0' && c <= '9') ||
+               (c >= 'a' && c <= 'f') ||
+               (c >= 'A' && c <= 'F');
+    }
+
+    static int hexValue(char c)
+    {
+        if(c >= '0' && c <= '9') return c - '0';
+        if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return c - 'A' + 10;
+    }
+
+};
@@ -0,0 +1,476 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include "Poco/Timestamp.h"
+#include "ofMain.h"
+#include "ofxOAuthHeaders.h"
+
+
+//------------------------------------------------------------------------------
+// The rate limit state of one endpoint family of one account, as last
+// reported by the server.  Times are unix times in milliseconds.
+class ofxOAuthRateLimitBudget
+{
+public:
+    ofxOAuthRateLimitBudget():
+        limit(-1),
+        remaining(-1),
+        resetTime(0),
+        blockedUntil(0),
+        lastUsed(0),
+        numInFlight(0),
+        numRejected(0)
+    {
+    }
+
+    // false until a response carried rate limit headers.
+    bool isKnown() const
+    {
+        return limit >= 0;
+    }
+
+    std::string account;    // see ofxOAuthTransportRequest::account
+    std::string family;
+    long long limit;        // requests per window, -1 if unknown
+    long long remaining;    // requests left in the window, less the ones in flight
+    long long resetTime;    // when the window resets, 0 if unknown
+    long long blockedUntil; // set by a 429 / 503 with Retry-After
+    long long lastUsed;     // when a request last took or gave back a token
+    std::size_t numInFlight;
+    std::size_t numRejected; // requests failed because the wait was too long
+
+};
+
+
+//------------------------------------------------------------------------------
+// Keeps a request budget per account and endpoint family from the rate
+// limit headers of the responses, so a request that would be refused with
+// a 429 waits for the window to reset instead of being sent.
+//
+// Understood headers:
+//   Twitter  x-rate-limit-limit / -remaining / -reset (unix seconds)
+//   Fitbit   Fitbit-Rate-Limit-Limit / -Remaining / -Reset (seconds from now)
+//   Retry-After (seconds) on a 429 or 503
+//
+// Servers count their limits per user, so the budgets of clients that share
+// a transport (and so a limiter) are kept apart by the account of each
+// request, its consumer key and token.
+//
+// By default each url (without its query) is its own family, which is how
+// Twitter counts.  Use addFamily() to group urls that share a limit, e.g.
+// all of Fitbit's api for one user, or paths that contain ids.
+//
+// A budget is a bucket of remaining tokens: each request takes one before
+// it is sent, each response refills it with what the server says is left
+// (less the requests still in flight) and it refills to the limit when the
+// window resets.  A budget is only created once the server reports limits
+// for it, so families that are never limited cost nothing, and budgets
+// that have been idle for maxIdleMillis past their window are dropped.
+class ofxOAuthRateLimiter
+{
+public:
+    ofxOAuthRateLimiter():
+        defaultRetryAfterMillis(1000),
+        maxIdleMillis(DEFAULT_MAX_IDLE_MILLIS),
+        nextPruneTime(0)
+    {
+    }
+
+    virtual ~ofxOAuthRateLimiter()
+    {
+    }
+
+    enum
+    {
+        DEFAULT_MAX_IDLE_MILLIS = 15 * 60 * 1000,
+        PRUNE_INTERVAL_MILLIS = 60 * 1000
+    };
+
+    // Counts every url starting with urlPrefix against family.  The longest
+    // matching prefix wins.
+    void addFamily(const std::string& family, const std::string& urlPrefix)
+    {
+        ofScopedLock lock(mutex);
+        prefixes[urlPrefix] = family;
+    }
+
+    std::string getFamily(const std::string& url)
+    {
+        ofScopedLock lock(mutex);
+        return findFamily(url);
+    }
+
+    // Takes a token for a request to url made as account.  Returns 0 if it
+    // may be sent now, otherwise the milliseconds until it should ask
+    // again, or -1 if that is longer than maxWaitMillis (negative for no
+    // limit).
+    long tryAcquire(const std::string& url,
+                    long maxWaitMillis = -1,
+                    const std::string& account = "")
+    {
+        ofScopedLock lock(mutex);
+
+        long long now = getTime();
+        Key key(account, findFamily(url));
+
+        Buckets::iterator iter = buckets.find(key);
+
+        if(iter != buckets.end())
+        {
+            ofxOAuthRateLimitBudget& b = (*iter).second;
+
+            refill(b, getNumInFlight(key), now);
+
+            long long wait = 0;
+
+            if(b.blockedUntil > now)
+            {
+                wait = b.blockedUntil - now;
+            }
+            else if(b.isKnown() && b.remaining <= 0)
+            {
+                if(b.resetTime > now)
+                {
+                    wait = b.resetTime - now;
+                }
+                else if(getNumInFlight(key) > 0)
+                {
+                    // the response of a request in flight will say more.
+                    wait = defaultRetryAfterMillis;
+                }
+                else
+                {
+                    // without a known reset, a single request probes the
+                    // budget once the retry delay is over; the others wait
+                    // for its response or another delay.
+                    b.blockedUntil = now + defaultRetryAfterMillis;
+                }
+            }
+
+            if(wait > 0)
+            {
+                if(maxWaitMillis >= 0 && wait > maxWaitMillis)
+                {
+                    b.numRejected++;
+                    return -1;
+                }
+                return (long)wait;
+            }
+
+            if(b.remaining > 0) b.remaining--;
+            b.lastUsed = now;
+        }
+
+        inFlight[key]++;
+
+        return 0;
+    }
+
+    // Blocks until a token is taken.  Returns false without waiting if it
+    // can't be had within maxWaitMillis (negative for no limit).
+    bool acquire(const std::string& url,
+                 long maxWaitMillis = -1,
+                 const std::string& account = "")
+    {
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        while(true)
+        {
+            long waited = (long)(ofGetElapsedTimeMillis() - startTime);
+            long wait = tryAcquire(url, maxWaitMillis < 0 ? -1 : std::max(0L, maxWaitMillis - waited), account);
+
+            if(wait == 0) return true;
+            if(wait < 0) return false;
+
+            // responses to other requests may change the budget meanwhile.
+            ofSleepMillis((int)std::min(wait, 1000L));
+        }
+    }
+
+    // Returns the token taken by tryAcquire() / acquire() once the request
+    // is done, and updates the budget from the response (status is 0 and
+    // headers are empty if none arrived).
+    void release(const std::string& url,
+                 long status,
+                 const ofxOAuthHeaders& headers,
+                 const std::string& account = "")
+    {
+        ofScopedLock lock(mutex);
+
+        long long now = getTime();
+        Key key(account, findFamily(url));
+
+        InFlight::iterator inFlightIter = inFlight.find(key);
+        if(inFlightIter != inFlight.end() && --(*inFlightIter).second == 0)
+        {
+            inFlight.erase(inFlightIter);
+        }
+
+        long long limit = -1;
+        long long remaining = -1;
+        long long resetTime = 0;
+
+        if(headers.has("x-rate-limit-remaining"))
+        {
+            limit = headers.getNumber("x-rate-limit-limit", -1);
+            remaining = headers.getNumber("x-rate-limit-remaining", -1);
+            long long reset = headers.getNumber("x-rate-limit-reset", -1);
+            if(reset >= 0) resetTime = reset * 1000;
+        }
+        else if(headers.has("Fitbit-Rate-Limit-Remaining"))
+        {
+            limit = headers.getNumber("Fitbit-Rate-Limit-Limit", -1);
+            remaining = headers.getNumber("Fitbit-Rate-Limit-Remaining", -1);
+            long long reset = headers.getNumber("Fitbit-Rate-Limit-Reset", -1);
+            if(reset >= 0) resetTime = now + reset * 1000;
+        }
+
+        bool refused = (status == 429 || status == 503);
+
+        Buckets::iterator iter = buckets.find(key);
+
+        if(iter == buckets.end())
+        {
+            // nothing to remember about a family that isn't limited.
+            if(remaining < 0 && !refused)
+            {
+                prune(now);
+                return;
+            }
+
+            iter = buckets.insert(std::make_pair(key, ofxOAuthRateLimitBudget())).first;
+            (*iter).second.account = account;
+            (*iter).second.family = key.second;
+        }
+
+        ofxOAuthRateLimitBudget& b = (*iter).second;
+
+        b.lastUsed = now;
+
+        if(remaining >= 0)
+        {
+            b.limit = limit >= 0 ? limit : std::max(b.limit, remaining);
+            b.remaining = std::max(0LL, remaining - (long long)getNumInFlight(key));
+            b.resetTime = resetTime;
+
+            // used up, with no reset to wait for: probe after the retry delay.
+            if(remaining == 0 && resetTime <= now)
+            {
+                b.blockedUntil = std::max(b.blockedUntil, now + defaultRetryAfterMillis);
+            }
+        }
+        else if(status >= 200 && status < 300 && b.isKnown() && b.remaining <= 0 && b.resetTime <= now)
+        {
+            // a probe went through without saying what is left, so the
+            // window has reset.
+            b.remaining = std::max(0LL, b.limit - (long long)getNumInFlight(key));
+        }
+
+        if(refused)
+        {
+            long long retryAfter = headers.getNumber("Retry-After", -1);
+
+            if(retryAfter >= 0)
+            {
+                b.blockedUntil = now + retryAfter * 1000;
+            }
+            else if(status == 429 && (remaining < 0 || resetTime <= now))
+            {
+                // refused without saying for how long.
+                b.blockedUntil = now + defaultRetryAfterMillis;
+            }
+
+            if(status == 429 && b.isKnown()) b.remaining = 0;
+        }
+
+        prune(now);
+    }
+
+    // Returns an unknown budget if the server never reported limits for
+    // family (or they have been dropped since).
+    ofxOAuthRateLimitBudget getBudget(const std::string& family,
+                                      const std::string& account = "")
+    {
+        ofScopedLock lock(mutex);
+
+        Key key(account, family);
+        ofxOAuthRateLimitBudget b;
+
+        Buckets::iterator iter = buckets.find(key);
+        if(iter != buckets.end())
+        {
+            refill((*iter).second, getNumInFlight(key), getTime());
+            b = (*iter).second;
+        }
+        else
+        {
+            b.account = account;
+            b.family = family;
+        }
+
+        b.numInFlight = getNumInFlight(key);
+        return b;
+    }
+
+    std::vector<ofxOAuthRateLimitBudget> getBudgets()
+    {
+        ofScopedLock lock(mutex);
+
+        long long now = getTime();
+        std::vector<ofxOAuthRateLimitBudget> budgets;
+
+        Buckets::iterator iter = buckets.begin();
+        while(iter != buckets.end())
+        {
+            std::size_t numInFlight = getNumInFlight((*iter).first);
+            refill((*iter).second, numInFlight, now);
+            budgets.push_back((*iter).second);
+            budgets.back().numInFlight = numInFlight;
+            ++iter;
+        }
+
+        return budgets;
+    }
+
+    std::size_t getNumBudgets()
+    {
+        ofScopedLock lock(mutex);
+        return buckets.size();
+    }
+
+    // Forgets what the servers reported (the requests in flight still count).
+    void reset()
+    {
+        ofScopedLock lock(mutex);
+        buckets.clear();
+    }
+
+    // How long a request waits after a 429 that did not say, and between
+    // the probes of a used up budget whose reset is unknown.
+    void setDefaultRetryAfterMillis(long v)
+    {
+        ofScopedLock lock(mutex);
+        defaultRetryAfterMillis = v;
+    }
+
+    // How long a budget is kept once it is unused, its window has reset and
+    // nothing blocks it.
+    void setMaxIdleMillis(long v)
+    {
+        ofScopedLock lock(mutex);
+        maxIdleMillis = v;
+        nextPruneTime = 0;
+    }
+
+    static long long getTime()
+    {
+        return Poco::Timestamp().epochMicroseconds() / 1000;
+    }
+
+protected:
+    // (account, family)
+    typedef std::pair<std::string, std::string> Key;
+    typedef std::map<Key, ofxOAuthRateLimitBudget> Buckets;
+    typedef std::map<Key, std::size_t> InFlight;
+
+    std::string findFamily(const std::string& url) const
+    {
+        std::map<std::string, std::string>::const_iterator best = prefixes.end();
+
+        std::map<std::string, std::string>::const_iterator iter = prefixes.begin();
+        while(iter != prefixes.end())
+        {
+            if(url.compare(0, (*iter).first.size(), (*iter).first) == 0 &&
+               (best == prefixes.end() || (*iter).first.size() > (*best).first.size()))
+            {
+                best = iter;
+            }
+            ++iter;
+        }
+
+        if(best != prefixes.end()) return (*best).second;
+
+        return url.substr(0, url.find_first_of("?#"));
+    }
+
+    std::size_t getNumInFlight(const Key& key) const
+    {
+        InFlight::const_iterator iter = inFlight.find(key);
+        return iter != inFlight.end() ? (*iter).second : 0;
+    }
+
+    // Drops the budgets that no longer hold anything back.  Runs at most
+    // once per PRUNE_INTERVAL_MILLIS.
+    void prune(long long now)
+    {
+        if(now < nextPruneTime) return;
+
+        nextPruneTime = now + PRUNE_INTERVAL_MILLIS;
+
+        Buckets::iterator iter = buckets.begin();
+        while(iter != buckets.end())
+        {
+            const ofxOAuthRateLimitBudget& b = (*iter).second;
+
+            if(b.blockedUntil <= now &&
+               b.resetTime <= now &&
+               now - b.lastUsed >= maxIdleMillis &&
+               getNumInFlight((*iter).first) == 0)
+            {
+                buckets.erase(iter++);
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+    }
+
+    static void refill(ofxOAuthRateLimitBudget& b, std::size_t numInFlight, long long now)
+    {
+        if(b.isKnown() && b.resetTime > 0 && now >= b.resetTime)
+        {
+            b.remaining = std::max(0LL, b.limit - (long long)numInFlight);
+            b.resetTime = 0;
+        }
+    }
+
+    std::map<std::string, std::string> prefixes;
+    Buckets buckets;
+    InFlight inFlight;
+    long long defaultRetryAfterMillis;
+    long long maxIdleMillis;
+    long long nextPruneTime;
+
+    ofMutex mutex;
+
+};
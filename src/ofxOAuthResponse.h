@@ -0,0 +1,280 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string>
+#include <vector>
+#include <curl/curl.h>
+#include "ofMain.h"
+#include "ofxOAuthHeaders.h"
+#include "ofxOAuthMappedFile.h"
+
+
+//------------------------------------------------------------------------------
+// Where the time of a request went, in milliseconds from its start, as
+// measured by curl.  Each phase includes the ones before it, so e.g. the
+// time to first byte minus the pretransfer time is the server's think time.
+class ofxOAuthTiming
+{
+public:
+    ofxOAuthTiming():
+        nameLookup(0),
+        connect(0),
+        tlsHandshake(0),
+        pretransfer(0),
+        firstByte(0),
+        total(0),
+        redirect(0)
+    {
+    }
+
+    double nameLookup;   // dns resolved, 0 if the connection was reused
+    double connect;      // tcp connected
+    double tlsHandshake; // tls done, 0 for plain http
+    double pretransfer;  // about to send the request
+    double firstByte;    // first byte of the response received
+    double total;
+    double redirect;     // spent following redirects, before the final request
+
+};
+
+
+//------------------------------------------------------------------------------
+// A pool of response body buffers.  A buffer handed out by acquire() goes
+// back to the pool when the last shared_ptr to it is released, and keeps
+// its allocated memory, so in steady state a response is written into
+// memory that is already there instead of growing a new string.  Buffers
+// that grew beyond maxRecycledSize are freed rather than kept.
+class ofxOAuthBufferPool
+{
+public:
+    enum
+    {
+        DEFAULT_MAX_IDLE_BUFFERS = 8,
+        DEFAULT_MAX_RECYCLED_SIZE = 4 * 1024 * 1024
+    };
+
+    ofxOAuthBufferPool(std::size_t maxIdleBuffers = DEFAULT_MAX_IDLE_BUFFERS,
+                       std::size_t maxRecycledSize = DEFAULT_MAX_RECYCLED_SIZE):
+        store(new Store(maxIdleBuffers, maxRecycledSize))
+    {
+    }
+
+    std::shared_ptr<ofBuffer> acquire()
+    {
+        return std::shared_ptr<ofBuffer>(store->take(), Recycler(store));
+    }
+
+    // the number of buffers that had to be allocated / were reused.
+    std::size_t getNumAllocated() const
+    {
+        ofScopedLock lock(store->mutex);
+        return store->numAllocated;
+    }
+
+    std::size_t getNumReused() const
+    {
+        ofScopedLock lock(store->mutex);
+        return store->numReused;
+    }
+
+private:
+    class Store
+    {
+    public:
+        Store(std::size_t _maxIdleBuffers, std::size_t _maxRecycledSize):
+            maxIdleBuffers(_maxIdleBuffers),
+            maxRecycledSize(_maxRecycledSize),
+            numAllocated(0),
+            numReused(0)
+        {
+        }
+
+        ~Store()
+        {
+            for(std::size_t i = 0; i < idle.size(); ++i) delete idle[i];
+        }
+
+        ofBuffer* take()
+        {
+            ofScopedLock lock(mutex);
+
+            if(idle.empty())
+            {
+                ++numAllocated;
+                return new ofBuffer();
+            }
+
+            ++numReused;
+            ofBuffer* buffer = idle.back();
+            idle.pop_back();
+            return buffer;
+        }
+
+        void give(ofBuffer* buffer)
+        {
+            if(buffer->size() <= maxRecycledSize)
+            {
+                buffer->clear(); // keeps the memory
+
+                ofScopedLock lock(mutex);
+
+                if(idle.size() < maxIdleBuffers)
+                {
+                    idle.push_back(buffer);
+                    return;
+                }
+            }
+
+            delete buffer;
+        }
+
+        std::vector<ofBuffer*> idle;
+        std::size_t maxIdleBuffers;
+        std::size_t maxRecycledSize;
+        std::size_t numAllocated;
+        std::size_t numReused;
+        ofMutex mutex;
+    };
+
+    // the shared_ptr deleter; it keeps the store alive for as long as any
+    // of its buffers are still in use.
+    class Recycler
+    {
+    public:
+        Recycler(std::shared_ptr<Store> _store): store(_store)
+        {
+        }
+
+        void operator () (ofBuffer* buffer)
+        {
+            store->give(buffer);
+        }
+
+    private:
+        std::shared_ptr<Store> store;
+    };
+
+    std::shared_ptr<Store> store;
+
+};
+
+
+//------------------------------------------------------------------------------
+// The response to a blocking request.  The body is the pooled buffer curl
+// wrote into; it is never copied, and copying a response only copies a
+// reference to it.  The buffer returns to its pool when the last copy of
+// the response is destroyed.  A response read from the disk tier of an
+// ofxOAuthResponseCache has no buffer; its body is a view into the mapped
+// cache file instead, which stays mapped while any copy of it exists.
+class ofxOAuthResponse
+{
+public:
+    ofxOAuthResponse():
+        curlCode(CURLE_OK),
+        status(0),
+        attempts(0),
+        fromCache(false),
+        mappedOffset(0),
+        mappedSize(0)
+    {
+    }
+
+    bool isOk() const
+    {
+        return curlCode == CURLE_OK;
+    }
+
+    // The body as a view; valid for as long as this response (or a copy).
+    const char* data() const
+    {
+        if(mappedFile != NULL) return mappedFile->data + mappedOffset;
+        return body != NULL && body->size() > 0 ? body->getBinaryBuffer() : "";
+    }
+
+    std::size_t size() const
+    {
+        if(mappedFile != NULL) return mappedSize;
+        return body != NULL ? (std::size_t)body->size() : 0;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    // The body as an ofBuffer, without copying it.  A mapped body (see
+    // above) can't be an ofBuffer, so it is copied into one the first time;
+    // use data() and size() to avoid that.
+    const ofBuffer& getBuffer() const
+    {
+        static const ofBuffer emptyBuffer;
+
+        if(mappedFile != NULL && body == NULL)
+        {
+            body = std::shared_ptr<ofBuffer>(new ofBuffer(data(), size()));
+        }
+
+        return body != NULL ? *body : emptyBuffer;
+    }
+
+    // true for a 2xx answer.
+    bool isSuccess() const
+    {
+        return curlCode == CURLE_OK && status >= 200 && status < 300;
+    }
+
+    // e.g. getHeader("ETag"), "" if the response had none.
+    std::string getHeader(const char* name) const
+    {
+        return headers.get(name);
+    }
+
+    // Copies the body into a string.
+    std::string toString() const
+    {
+        return std::string(data(), size());
+    }
+
+    CURLcode curlCode;  // transport level result
+    long status;        // http status code, 0 if none was received
+    std::string error;  // human readable curl error, if any
+    int attempts;       // how often the request was sent, see ofxOAuthRetryPolicy
+    bool fromCache;     // answered (or revalidated) by the ofxOAuthResponseCache
+
+    ofxOAuthHeaders headers;
+    ofxOAuthTiming timing;
+
+    // mutable only so getBuffer() can copy a mapped body into it.
+    mutable std::shared_ptr<ofBuffer> body;
+
+    // the range of the mapped cache file that is the body, if set.
+    std::shared_ptr<const ofxOAuthMappedFile> mappedFile;
+    std::size_t mappedOffset;
+    std::size_t mappedSize;
+
+};
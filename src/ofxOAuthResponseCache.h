@@ -0,0 +1,732 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include "Poco/DateTime.h"
+#include "Poco/DateTimeParser.h"
+#include "Poco/DirectoryIterator.h"
+#include "Poco/Exception.h"
+#include "Poco/File.h"
+#include "Poco/String.h"
+#include "Poco/Timestamp.h"
+#include "ofMain.h"
+#include "ofxOAuthMappedFile.h"
+#include "ofxOAuthParams.h"
+#include "ofxOAuthResponse.h"
+
+
+//------------------------------------------------------------------------------
+// One cached response.  Entries are never modified once they are in the
+// cache (a revalidation stores a new one), so they are shared by pointer.
+class ofxOAuthCacheEntry
+{
+public:
+    ofxOAuthCacheEntry():
+        status(0),
+        mappedOffset(0),
+        mappedSize(0),
+        storedAt(0),
+        freshUntil(0),
+        mustRevalidate(false)
+    {
+    }
+
+    bool isFresh(long long now) const
+    {
+        return !mustRevalidate && now < freshUntil;
+    }
+
+    bool canRevalidate() const
+    {
+        return headers.has("ETag") || headers.has("Last-Modified");
+    }
+
+    // Answers a request from this entry.
+    void getResponse(ofxOAuthResponse& response) const
+    {
+        response.curlCode = CURLE_OK;
+        response.status = status;
+        response.error.clear();
+        response.headers = headers;
+        response.body = body;
+        response.mappedFile = mappedFile;
+        response.mappedOffset = mappedOffset;
+        response.mappedSize = mappedSize;
+        response.fromCache = true;
+    }
+
+    const char* getBodyData() const
+    {
+        if(mappedFile != NULL) return mappedFile->data + mappedOffset;
+        return body != NULL && body->size() > 0 ? body->getBinaryBuffer() : "";
+    }
+
+    std::size_t getBodySize() const
+    {
+        if(mappedFile != NULL) return mappedSize;
+        return body != NULL ? (std::size_t)body->size() : 0;
+    }
+
+    std::size_t getSize() const
+    {
+        return key.size() + headers.getRaw().size() + getBodySize();
+    }
+
+    std::string key;
+    long status;
+    ofxOAuthHeaders headers;
+
+    // the body is either a buffer or, once read back from the disk tier, a
+    // range of the mapped file.
+    std::shared_ptr<ofBuffer> body;
+    std::shared_ptr<const ofxOAuthMappedFile> mappedFile;
+    std::size_t mappedOffset;
+    std::size_t mappedSize;
+
+    long long storedAt;   // unix time in milliseconds
+    long long freshUntil; // unix time in milliseconds
+    bool mustRevalidate;  // no-cache: always ask the server first
+
+};
+
+
+typedef std::shared_ptr<const ofxOAuthCacheEntry> ofxOAuthCacheEntryPtr;
+
+
+//------------------------------------------------------------------------------
+class ofxOAuthCacheStats
+{
+public:
+    ofxOAuthCacheStats():
+        hits(0),
+        diskHits(0),
+        misses(0),
+        revalidations(0),
+        stores(0),
+        evictions(0)
+    {
+    }
+
+    uint64_t hits;          // answered without asking the server
+    uint64_t diskHits;      // ... of which were read from the disk tier
+    uint64_t misses;        // nothing cached
+    uint64_t revalidations; // stale, and the server answered 304
+    uint64_t stores;
+    uint64_t evictions;
+
+};
+
+
+//------------------------------------------------------------------------------
+// An optional cache for signed GET responses, see ofxOAuth::setResponseCache.
+// Requests are keyed on the method, the url and the non-oauth parameters,
+// so the nonce, timestamp and signature that change with every request
+// don't defeat it, plus the access token, so clients that share a cache
+// never see each other's responses.
+//
+// Responses are kept in a memory tier, evicted least recently used first,
+// and optionally written through to a disk tier that is read back with
+// mmap.  Cache-Control (no-store, no-cache, max-age) and Expires decide
+// how long an entry is fresh; a stale entry with an ETag or Last-Modified
+// is revalidated with If-None-Match / If-Modified-Since, so an unchanged
+// response costs a 304 without a body.
+//
+// NOTE: cached bodies are shared with every response served from them, so
+// treat response bodies as read only.
+class ofxOAuthResponseCache
+{
+public:
+    enum
+    {
+        DEFAULT_MAX_MEMORY_BYTES = 8 * 1024 * 1024,
+        DEFAULT_MAX_DISK_BYTES = 64 * 1024 * 1024
+    };
+
+    ofxOAuthResponseCache(std::size_t _maxMemoryBytes = DEFAULT_MAX_MEMORY_BYTES):
+        maxMemoryBytes(_maxMemoryBytes),
+        memoryBytes(0),
+        maxDiskBytes(DEFAULT_MAX_DISK_BYTES),
+        diskBytes(0)
+    {
+    }
+
+    virtual ~ofxOAuthResponseCache()
+    {
+    }
+
+    // Enables the disk tier in the given (existing) directory.  The files
+    // a previous run left there count towards maxDiskBytes, the least
+    // recently written are evicted first.
+    void setDiskPath(const std::string& path, std::size_t _maxDiskBytes = DEFAULT_MAX_DISK_BYTES)
+    {
+        ofScopedLock lock(mutex);
+        diskPath = path;
+        maxDiskBytes = _maxDiskBytes;
+        diskLRU.clear();
+        diskFiles.clear();
+        diskBytes = 0;
+        scanDisk();
+    }
+
+    std::size_t getDiskBytes()
+    {
+        ofScopedLock lock(mutex);
+        return diskBytes;
+    }
+
+    static std::string makeKey(const std::string& method,
+                               const std::string& url,
+                               const ofxOAuthParams& params,
+                               const std::string& accessToken)
+    {
+        ofxOAuthParams sorted(params);
+        sorted.sort();
+
+        std::string key;
+        key.reserve(method.size() + url.size() + sorted.querySize(false) + accessToken.size() + 3);
+        key += method;
+        key += ' ';
+        key += url;
+        key += '?';
+        sorted.appendQuery(key, false);
+        key += ' ';
+        key += accessToken;
+        return key;
+    }
+
+    // Looks in memory, then on disk.  A disk hit is moved into memory.
+    ofxOAuthCacheEntryPtr lookup(const std::string& key)
+    {
+        ofScopedLock lock(mutex);
+
+        std::map<std::string, MemoryItem>::iterator iter = memory.find(key);
+
+        if(iter != memory.end())
+        {
+            memoryLRU.splice(memoryLRU.begin(), memoryLRU, (*iter).second.lru);
+            return (*iter).second.entry;
+        }
+
+        ofxOAuthCacheEntryPtr entry = readFromDisk(key);
+
+        if(entry != NULL)
+        {
+            stats.diskHits++;
+            insertInMemory(entry);
+        }
+
+        return entry;
+    }
+
+    // Counts the outcome of a lookup.
+    void countHit()
+    {
+        ofScopedLock lock(mutex);
+        stats.hits++;
+    }
+
+    void countMiss()
+    {
+        ofScopedLock lock(mutex);
+        stats.misses++;
+    }
+
+    // Stores a fresh 200 response, if Cache-Control allows it and it can
+    // be used later, i.e. it is fresh for a while or can be revalidated.
+    ofxOAuthCacheEntryPtr store(const std::string& key, const ofxOAuthResponse& response)
+    {
+        if(!response.isOk() || response.status != 200) return ofxOAuthCacheEntryPtr();
+
+        long long now = getTime();
+
+        std::shared_ptr<ofxOAuthCacheEntry> entry(new ofxOAuthCacheEntry());
+        entry->key = key;
+        entry->status = response.status;
+        entry->headers = response.headers;
+        entry->storedAt = now;
+
+        if(!getFreshness(entry->headers, now, entry->freshUntil, entry->mustRevalidate)) return ofxOAuthCacheEntryPtr();
+        if(entry->freshUntil <= now && !entry->canRevalidate()) return ofxOAuthCacheEntryPtr();
+
+        // a copy, so the response's pooled buffer goes back to its pool.
+        entry->body = std::shared_ptr<ofBuffer>(new ofBuffer(response.data(), response.size()));
+
+        ofScopedLock lock(mutex);
+        stats.stores++;
+        insertInMemory(entry);
+        writeToDisk(*entry);
+
+        return entry;
+    }
+
+    // The server answered a conditional request with 304: the entry is
+    // fresh again, with the freshness of the 304.  Returns the new entry.
+    ofxOAuthCacheEntryPtr revalidated(ofxOAuthCacheEntryPtr stale, const ofxOAuthResponse& notModified)
+    {
+        long long now = getTime();
+
+        std::shared_ptr<ofxOAuthCacheEntry> entry(new ofxOAuthCacheEntry(*stale));
+        entry->storedAt = now;
+
+        // a 304 without caching headers keeps the original policy.
+        const ofxOAuthHeaders& headers = notModified.headers.has("Cache-Control") || notModified.headers.has("Expires") ? notModified.headers : stale->headers;
+
+        if(!getFreshness(headers, now, entry->freshUntil, entry->mustRevalidate))
+        {
+            remove(stale->key);
+            return stale;
+        }
+
+        ofScopedLock lock(mutex);
+        stats.revalidations++;
+        insertInMemory(entry);
+        writeToDisk(*entry);
+
+        return entry;
+    }
+
+    void remove(const std::string& key)
+    {
+        ofScopedLock lock(mutex);
+
+        std::map<std::string, MemoryItem>::iterator iter = memory.find(key);
+
+        if(iter != memory.end())
+        {
+            memoryBytes -= (*iter).second.entry->getSize();
+            memoryLRU.erase((*iter).second.lru);
+            memory.erase(iter);
+        }
+
+        if(!diskPath.empty())
+        {
+            removeFile(getFileName(key));
+        }
+    }
+
+    // Empties the memory tier (the disk tier is left alone).
+    void clear()
+    {
+        ofScopedLock lock(mutex);
+        memory.clear();
+        memoryLRU.clear();
+        memoryBytes = 0;
+    }
+
+    ofxOAuthCacheStats getStats()
+    {
+        ofScopedLock lock(mutex);
+        return stats;
+    }
+
+    std::size_t getMemoryBytes()
+    {
+        ofScopedLock lock(mutex);
+        return memoryBytes;
+    }
+
+    // Fills the conditional request headers for a stale entry.
+    static void addConditionalHeaders(const ofxOAuthCacheEntry& entry, std::vector<std::string>& requestHeaders)
+    {
+        std::string etag = entry.headers.get("ETag");
+        std::string lastModified = entry.headers.get("Last-Modified");
+
+        if(!etag.empty()) requestHeaders.push_back("If-None-Match: " + etag);
+        if(!lastModified.empty()) requestHeaders.push_back("If-Modified-Since: " + lastModified);
+    }
+
+    // Works out until when a response with these headers is fresh.
+    // Returns false if it must not be stored (no-store).
+    static bool getFreshness(const ofxOAuthHeaders& headers,
+                             long long now,
+                             long long& freshUntil,
+                             bool& mustRevalidate)
+    {
+        freshUntil = now;
+        mustRevalidate = false;
+
+        long long maxAge = -1;
+
+        const char* value = NULL;
+        std::size_t size = 0;
+
+        if(headers.find("Cache-Control", value, size))
+        {
+            std::size_t start = 0;
+
+            while(start < size)
+            {
+                std::size_t end = start;
+                while(end < size && value[end] != ',') ++end;
+
+                std::size_t a = start;
+                std::size_t b = end;
+                while(a < b && value[a] == ' ') ++a;
+                while(b > a && value[b - 1] == ' ') --b;
+
+                std::string directive = Poco::toLower(std::string(value + a, b - a));
+
+                if(directive == "no-store")
+                {
+                    return false;
+                }
+                else if(directive == "no-cache")
+                {
+                    mustRevalidate = true;
+                }
+                else if(directive.compare(0, 8, "max-age=") == 0)
+                {
+                    maxAge = atoll(directive.c_str() + 8);
+                }
+
+                start = end + 1;
+            }
+        }
+
+        if(maxAge < 0 && headers.has("Expires"))
+        {
+            // measured against the server's own Date, so clock skew doesn't matter.
+            long long expires = parseDate(headers.get("Expires"));
+            long long date = headers.has("Date") ? parseDate(headers.get("Date")) : now;
+            if(expires > 0 && date > 0) maxAge = (expires - date) / 1000;
+        }
+
+        if(maxAge > 0)
+        {
+            maxAge -= headers.getNumber("Age", 0);
+            if(maxAge > 0) freshUntil = now + maxAge * 1000;
+        }
+
+        return true;
+    }
+
+    // An HTTP date as unix time in milliseconds, 0 if it can't be parsed.
+    static long long parseDate(const std::string& date)
+    {
+        Poco::DateTime dateTime;
+        int tzd = 0;
+
+        if(!Poco::DateTimeParser::tryParse(date, dateTime, tzd)) return 0;
+
+        return dateTime.timestamp().epochMicroseconds() / 1000 - (long long)tzd * 1000;
+    }
+
+    static long long getTime()
+    {
+        return Poco::Timestamp().epochMicroseconds() / 1000;
+    }
+
+protected:
+    struct MemoryItem
+    {
+        ofxOAuthCacheEntryPtr entry;
+        std::list<std::string>::iterator lru;
+    };
+
+    struct DiskItem
+    {
+        std::size_t size;
+        std::list<std::string>::iterator lru;
+    };
+
+    // must be called with mutex held.
+    void insertInMemory(ofxOAuthCacheEntryPtr entry)
+    {
+        std::size_t size = entry->getSize();
+        if(size > maxMemoryBytes) return;
+
+        std::map<std::string, MemoryItem>::iterator iter = memory.find(entry->key);
+
+        if(iter != memory.end())
+        {
+            memoryBytes -= (*iter).second.entry->getSize();
+            (*iter).second.entry = entry;
+            memoryLRU.splice(memoryLRU.begin(), memoryLRU, (*iter).second.lru);
+        }
+        else
+        {
+            memoryLRU.push_front(entry->key);
+            MemoryItem& item = memory[entry->key];
+            item.entry = entry;
+            item.lru = memoryLRU.begin();
+        }
+
+        memoryBytes += size;
+
+        while(memoryBytes > maxMemoryBytes && !memoryLRU.empty())
+        {
+            std::map<std::string, MemoryItem>::iterator oldest = memory.find(memoryLRU.back());
+            memoryBytes -= (*oldest).second.entry->getSize();
+            memory.erase(oldest);
+            memoryLRU.pop_back();
+            stats.evictions++;
+        }
+    }
+
+    // FNV-1a, as a file name.
+    std::string getFileName(const std::string& key) const
+    {
+        uint64_t hash = 14695981039346656037ULL;
+
+        for(std::size_t i = 0; i < key.size(); ++i)
+        {
+            hash ^= (unsigned char)key[i];
+            hash *= 1099511628211ULL;
+        }
+
+        char name[32];
+        sprintf(name, "%016llx.cache", (unsigned long long)hash);
+        return ofFilePath::join(diskPath, name);
+    }
+
+    // The file is a one line text header, then the key, the header block
+    // and the body.  It is written to a temporary file and renamed, so a
+    // reader never sees half of it.  Must be called with mutex held.
+    void writeToDisk(const ofxOAuthCacheEntry& entry)
+    {
+        if(diskPath.empty()) return;
+
+        std::string fileName = getFileName(entry.key);
+        std::string tempName = fileName + ".tmp";
+
+        const std::string& headerBlock = entry.headers.getRaw();
+        std::size_t bodySize = entry.getBodySize();
+        std::size_t fileSize = 0;
+
+        {
+            std::ofstream out(tempName.c_str(), std::ios::binary | std::ios::trunc);
+            if(!out) return;
+
+            out << "ofxOAuthCache1 " << entry.key.size() << " " << entry.status << " "
+                << entry.storedAt << " " << entry.freshUntil << " " << (entry.mustRevalidate ? 1 : 0) << " "
+                << headerBlock.size() << " " << bodySize << "\n";
+            out.write(entry.key.data(), entry.key.size());
+            out.write(headerBlock.data(), headerBlock.size());
+            if(bodySize > 0) out.write(entry.getBodyData(), bodySize);
+
+            fileSize = (std::size_t)out.tellp();
+
+            if(!out)
+            {
+                ::remove(tempName.c_str());
+                return;
+            }
+        }
+
+        // the file being replaced stays readable to whoever has it mapped.
+        if(rename(tempName.c_str(), fileName.c_str()) != 0)
+        {
+            ::remove(tempName.c_str());
+            return;
+        }
+
+        addDiskFile(fileName, fileSize);
+    }
+
+    // must be called with mutex held.
+    ofxOAuthCacheEntryPtr readFromDisk(const std::string& key)
+    {
+        if(diskPath.empty()) return ofxOAuthCacheEntryPtr();
+
+        std::string fileName = getFileName(key);
+
+        // the mapping is kept as the entry's body.
+        std::shared_ptr<const ofxOAuthMappedFile> mapping(new ofxOAuthMappedFile(fileName));
+        const ofxOAuthMappedFile& file = *mapping;
+        if(file.data == NULL) return ofxOAuthCacheEntryPtr();
+
+        // the first line is short, parse it from a bounded copy.
+        std::size_t lineEnd = 0;
+        while(lineEnd < file.size && lineEnd < 256 && file.data[lineEnd] != '\n') ++lineEnd;
+        if(lineEnd == file.size || file.data[lineEnd] != '\n') return ofxOAuthCacheEntryPtr();
+
+        std::string line(file.data, lineEnd);
+
+        unsigned long keySize = 0;
+        long status = 0;
+        long long storedAt = 0;
+        long long freshUntil = 0;
+        int mustRevalidate = 0;
+        unsigned long headerSize = 0;
+        unsigned long bodySize = 0;
+
+        if(sscanf(line.c_str(), "ofxOAuthCache1 %lu %ld %lld %lld %d %lu %lu",
+                  &keySize, &status, &storedAt, &freshUntil, &mustRevalidate, &headerSize, &bodySize) != 7 ||
+           lineEnd + 1 + keySize + headerSize + bodySize != file.size)
+        {
+            return ofxOAuthCacheEntryPtr();
+        }
+
+        const char* p = file.data + lineEnd + 1;
+
+        // a different key with the same hash.
+        if(keySize != key.size() || key.compare(0, keySize, p, keySize) != 0) return ofxOAuthCacheEntryPtr();
+        p += keySize;
+
+        std::shared_ptr<ofxOAuthCacheEntry> entry(new ofxOAuthCacheEntry());
+        entry->key = key;
+        entry->status = status;
+        entry->storedAt = storedAt;
+        entry->freshUntil = freshUntil;
+        entry->mustRevalidate = mustRevalidate != 0;
+
+        const char* headerEnd = p + headerSize;
+        while(p < headerEnd)
+        {
+            const char* eol = p;
+            while(eol < headerEnd && *eol != '\n') ++eol;
+            if(eol < headerEnd) ++eol;
+            entry->headers.appendLine(p, eol - p);
+            p = eol;
+        }
+
+        entry->mappedFile = mapping;
+        entry->mappedOffset = p - file.data;
+        entry->mappedSize = bodySize;
+
+        addDiskFile(fileName, file.size);
+
+        return entry;
+    }
+
+    // Lists the cache files already in diskPath, oldest last, and removes
+    // the temporary files of writes that never finished.  Must be called
+    // with mutex held.
+    void scanDisk()
+    {
+        if(diskPath.empty()) return;
+
+        std::vector<std::pair<Poco::Timestamp, std::string> > files;
+
+        try
+        {
+            Poco::DirectoryIterator end;
+
+            for(Poco::DirectoryIterator iter(diskPath); iter != end; ++iter)
+            {
+                const std::string& name = iter.name();
+
+                if(name.size() > 4 && name.compare(name.size() - 4, 4, ".tmp") == 0)
+                {
+                    ::remove(iter->path().c_str());
+                }
+                else if(name.size() > 6 && name.compare(name.size() - 6, 6, ".cache") == 0 && iter->isFile())
+                {
+                    files.push_back(std::make_pair(iter->getLastModified(), ofFilePath::join(diskPath, name)));
+                }
+            }
+        }
+        catch(const Poco::Exception& exc)
+        {
+            ofLogError("ofxOAuthResponseCache::scanDisk") << exc.displayText();
+        }
+
+        // oldest first, so the newest end up at the front of the LRU list.
+        std::sort(files.begin(), files.end());
+
+        for(std::size_t i = 0; i < files.size(); ++i)
+        {
+            try
+            {
+                addDiskFile(files[i].second, (std::size_t)Poco::File(files[i].second).getSize());
+            }
+            catch(const Poco::Exception& exc)
+            {
+                ofLogVerbose("ofxOAuthResponseCache::scanDisk") << exc.displayText();
+            }
+        }
+    }
+
+    // must be called with mutex held.
+    void addDiskFile(const std::string& fileName, std::size_t size)
+    {
+        std::map<std::string, DiskItem>::iterator iter = diskFiles.find(fileName);
+
+        if(iter != diskFiles.end())
+        {
+            diskBytes -= (*iter).second.size;
+            (*iter).second.size = size;
+            diskLRU.splice(diskLRU.begin(), diskLRU, (*iter).second.lru);
+        }
+        else
+        {
+            diskLRU.push_front(fileName);
+            DiskItem& item = diskFiles[fileName];
+            item.size = size;
+            item.lru = diskLRU.begin();
+        }
+
+        diskBytes += size;
+
+        while(diskBytes > maxDiskBytes && !diskLRU.empty())
+        {
+            std::string oldest = diskLRU.back();
+            removeFile(oldest);
+            stats.evictions++;
+        }
+    }
+
+    // must be called with mutex held.
+    void removeFile(const std::string& fileName)
+    {
+        ::remove(fileName.c_str());
+
+        std::map<std::string, DiskItem>::iterator iter = diskFiles.find(fileName);
+
+        if(iter != diskFiles.end())
+        {
+            diskBytes -= (*iter).second.size;
+            diskLRU.erase((*iter).second.lru);
+            diskFiles.erase(iter);
+        }
+    }
+
+    std::map<std::string, MemoryItem> memory;
+    std::list<std::string> memoryLRU; // most recently used first
+    std::size_t maxMemoryBytes;
+    std::size_t memoryBytes;
+
+    std::string diskPath;
+    std::map<std::string, DiskItem> diskFiles;
+    std::list<std::string> diskLRU;
+    std::size_t maxDiskBytes;
+    std::size_t diskBytes;
+
+    ofxOAuthCacheStats stats;
+
+    ofMutex mutex;
+
+};
@@ -0,0 +1,256 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <vector>
+#include <curl/curl.h>
+#include "ofMain.h"
+#include "ofxOAuthResponse.h"
+
+
+//------------------------------------------------------------------------------
+// Decides whether, and after how long, a failed signed request is sent
+// again.  Every retry is signed again, so it gets a fresh nonce and
+// timestamp and is never refused as a replay.
+//
+// Retrying is off by default (maxAttempts is 1), so get() and post() make
+// exactly one attempt unless a policy with more is set.
+//
+// Idempotent requests (GET) are retried after timeouts, dropped
+// connections, 5xx and 429 responses.  Other requests (POST) are only
+// retried if they never reached the server.  The wait between attempts
+// is "full jitter" exponential backoff: a random delay between 0 and
+// baseDelayMillis * 2^(attempt - 1), capped at maxDelayMillis, but never
+// shorter than a Retry-After the server sent.  If the server asks for a
+// longer wait than maxDelayMillis the request is not retried at all, so
+// the calling thread never sleeps for longer than maxDelayMillis at a
+// time, nor for longer than deadlineMillis in all if that is set.
+//
+// With hedgeGets set, a GET that hasn't been answered after
+// hedgeDelayMillis (or, once enough requests were timed, the 95th
+// percentile of recent GET latencies) is sent a second time, and the
+// first answer wins.
+class ofxOAuthRetryPolicy
+{
+public:
+    enum Failure
+    {
+        NO_FAILURE=0,
+        TIMEOUT,            // the request or the deadline timed out (or a 408)
+        CONNECTION_FAILED,  // dns or connect failed, nothing was sent
+        NETWORK_ERROR,      // the connection broke during the exchange
+        SERVER_ERROR,       // 5xx
+        RATE_LIMITED,       // 429
+        UNAUTHORIZED,       // 401 / 403, e.g. a revoked token or a bad signature
+        CLIENT_ERROR,       // any other 4xx
+        CANCELLED,          // aborted locally, e.g. used up rate limit
+        OTHER_FAILURE       // tls, bad url, ...
+    };
+
+    ofxOAuthRetryPolicy():
+        maxAttempts(1),
+        baseDelayMillis(250),
+        maxDelayMillis(5000),
+        deadlineMillis(0),
+        hedgeGets(false),
+        hedgeDelayMillis(500),
+        minHedgeDelayMillis(50)
+    {
+    }
+
+    static Failure classify(CURLcode curlCode, long status)
+    {
+        switch(curlCode)
+        {
+            case CURLE_OK:
+                break;
+            case CURLE_OPERATION_TIMEDOUT:
+                return TIMEOUT;
+            case CURLE_COULDNT_RESOLVE_PROXY:
+            case CURLE_COULDNT_RESOLVE_HOST:
+            case CURLE_COULDNT_CONNECT:
+                return CONNECTION_FAILED;
+            case CURLE_SEND_ERROR:
+            case CURLE_RECV_ERROR:
+            case CURLE_GOT_NOTHING:
+            case CURLE_PARTIAL_FILE:
+            case CURLE_SSL_CONNECT_ERROR:
+                return NETWORK_ERROR;
+            case CURLE_ABORTED_BY_CALLBACK:
+            case CURLE_WRITE_ERROR:
+                return CANCELLED;
+            default:
+                return OTHER_FAILURE;
+        }
+
+        if(status >= 200 && status < 400) return NO_FAILURE;
+        if(status == 401 || status == 403) return UNAUTHORIZED;
+        if(status == 408) return TIMEOUT;
+        if(status == 429) return RATE_LIMITED;
+        if(status >= 400 && status < 500) return CLIENT_ERROR;
+        if(status >= 500) return SERVER_ERROR;
+
+        return OTHER_FAILURE;
+    }
+
+    static Failure classify(const ofxOAuthResponse& response)
+    {
+        return classify(response.curlCode, response.status);
+    }
+
+    static const char* toString(Failure failure)
+    {
+        switch(failure)
+        {
+            case NO_FAILURE:        return "no failure";
+            case TIMEOUT:           return "timeout";
+            case CONNECTION_FAILED: return "connection failed";
+            case NETWORK_ERROR:     return "network error";
+            case SERVER_ERROR:      return "server error";
+            case RATE_LIMITED:      return "rate limited";
+            case UNAUTHORIZED:      return "unauthorized";
+            case CLIENT_ERROR:      return "client error";
+            case CANCELLED:         return "cancelled";
+            default:                return "failed";
+        }
+    }
+
+    // attempt is the 1-based number of the attempt that just failed.
+    bool shouldRetry(Failure failure, bool idempotent, int attempt) const
+    {
+        if(attempt >= maxAttempts) return false;
+
+        switch(failure)
+        {
+            case CONNECTION_FAILED:
+                return true;
+            case TIMEOUT:
+            case NETWORK_ERROR:
+            case SERVER_ERROR:
+            case RATE_LIMITED:
+                return idempotent;
+            default:
+                return false;
+        }
+    }
+
+    // The wait before the attempt after the given (failed) one, or -1 if
+    // the server's Retry-After is longer than maxDelayMillis and the
+    // request should not be retried.
+    long getBackoffMillis(int attempt, const ofxOAuthHeaders& headers) const
+    {
+        long cap = baseDelayMillis;
+        for(int i = 1; i < attempt && cap < maxDelayMillis; ++i) cap *= 2;
+        cap = std::min(cap, maxDelayMillis);
+
+        long delay = (long)ofRandom(0, (float)cap);
+
+        long long retryAfter = headers.getNumber("Retry-After", -1);
+
+        if(retryAfter > 0)
+        {
+            if(retryAfter * 1000 > maxDelayMillis) return -1;
+            delay = std::max(delay, (long)(retryAfter * 1000));
+        }
+
+        return delay;
+    }
+
+    int maxAttempts;            // including the first, 1 (the default) turns retrying off
+    long baseDelayMillis;
+    long maxDelayMillis;        // the longest single wait, Retry-After included
+    long deadlineMillis;        // for all attempts together, 0 for none
+    bool hedgeGets;
+    long hedgeDelayMillis;      // used until there are enough latency samples
+    long minHedgeDelayMillis;
+
+};
+
+
+//------------------------------------------------------------------------------
+// The latencies of the most recent successful requests, for picking the
+// hedge delay.
+class ofxOAuthLatencyTracker
+{
+public:
+    enum
+    {
+        DEFAULT_CAPACITY = 128,
+        MIN_SAMPLES = 20
+    };
+
+    ofxOAuthLatencyTracker(std::size_t _capacity = DEFAULT_CAPACITY):
+        capacity(_capacity > 0 ? _capacity : 1),
+        next(0)
+    {
+    }
+
+    void add(long millis)
+    {
+        ofScopedLock lock(mutex);
+
+        if(samples.size() < capacity)
+        {
+            samples.push_back(millis);
+        }
+        else
+        {
+            samples[next] = millis;
+            next = (next + 1) % capacity;
+        }
+    }
+
+    // e.g. 0.95 for the 95th percentile.  -1 until there are MIN_SAMPLES.
+    long getPercentile(float p)
+    {
+        std::vector<long> sorted;
+
+        {
+            ofScopedLock lock(mutex);
+            if(samples.size() < MIN_SAMPLES) return -1;
+            sorted = samples;
+        }
+
+        std::size_t n = std::min(sorted.size() - 1, (std::size_t)(p * sorted.size()));
+        std::nth_element(sorted.begin(), sorted.begin() + n, sorted.end());
+        return sorted[n];
+    }
+
+    std::size_t size()
+    {
+        ofScopedLock lock(mutex);
+        return samples.size();
+    }
+
+private:
+    std::vector<long> samples;
+    std::size_t capacity;
+    std::size_t next;
+    ofMutex mutex;
+
+};
@@ -0,0 +1,85 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <curl/curl.h>
+#include "ofMain.h"
+
+
+//------------------------------------------------------------------------------
+// A curl share handle.  Every easy handle attached to it uses one DNS cache
+// and one TLS session id cache, so a host is resolved and fully handshaken
+// once per process instead of once per handle.  With libcurl 7.57 or newer
+// the connection cache is shared as well.
+//
+// curl calls back into lock() / unlock() around every access to the shared
+// data; each kind of data has its own mutex.
+class ofxOAuthShare
+{
+public:
+    ofxOAuthShare():
+        share(curl_share_init())
+    {
+        curl_share_setopt(share, CURLSHOPT_LOCKFUNC, &ofxOAuthShare::lock);
+        curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, &ofxOAuthShare::unlock);
+        curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+    }
+
+    virtual ~ofxOAuthShare()
+    {
+        curl_share_cleanup(share);
+    }
+
+    CURLSH* getHandle()
+    {
+        return share;
+    }
+
+private:
+    ofxOAuthShare(const ofxOAuthShare&);
+    ofxOAuthShare& operator = (const ofxOAuthShare&);
+
+    static void lock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userdata)
+    {
+        static_cast<ofxOAuthShare*>(userdata)->mutexes[data < CURL_LOCK_DATA_LAST ? data : 0].lock();
+    }
+
+    static void unlock(CURL* handle, curl_lock_data data, void* userdata)
+    {
+        static_cast<ofxOAuthShare*>(userdata)->mutexes[data < CURL_LOCK_DATA_LAST ? data : 0].unlock();
+    }
+
+    CURLSH* share;
+    ofMutex mutexes[CURL_LOCK_DATA_LAST];
+
+};
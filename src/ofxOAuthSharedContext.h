@@ -0,0 +1,99 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include "ofMain.h"
+#include "ofxOAuthAsyncTransport.h"
+#include "ofxOAuthShare.h"
+#include "ofxOAuthTransport.h"
+
+
+//------------------------------------------------------------------------------
+// A transport, an event loop and a curl share handle that any number of
+// ofxOAuth clients can use together (see ofxOAuth::setSharedContext()).
+// Clients talking to the same host then share one pool of keep-alive
+// connections, one DNS cache and one TLS session cache, and all of their
+// asynchronous requests run on a single background thread.
+class ofxOAuthSharedContext
+{
+public:
+    ofxOAuthSharedContext():
+        share(new ofxOAuthShare()),
+        transport(new ofxOAuthTransport())
+    {
+        transport->setShare(share);
+    }
+
+    virtual ~ofxOAuthSharedContext()
+    {
+    }
+
+    // The process-wide context, created on first use.
+    static std::shared_ptr<ofxOAuthSharedContext> getDefault()
+    {
+        static ofMutex mutex;
+        static std::shared_ptr<ofxOAuthSharedContext> context;
+
+        ofScopedLock lock(mutex);
+
+        if(context == NULL)
+        {
+            context = std::shared_ptr<ofxOAuthSharedContext>(new ofxOAuthSharedContext());
+        }
+
+        return context;
+    }
+
+    std::shared_ptr<ofxOAuthTransport> getTransport()
+    {
+        return transport;
+    }
+
+    std::shared_ptr<ofxOAuthAsyncTransport> getAsyncTransport()
+    {
+        ofScopedLock lock(mutex);
+
+        if(asyncTransport == NULL)
+        {
+            asyncTransport = std::shared_ptr<ofxOAuthAsyncTransport>(new ofxOAuthAsyncTransport(transport));
+        }
+
+        return asyncTransport;
+    }
+
+    std::shared_ptr<ofxOAuthShare> getShare()
+    {
+        return share;
+    }
+
+protected:
+    std::shared_ptr<ofxOAuthShare> share;
+    std::shared_ptr<ofxOAuthTransport> transport;
+    std::shared_ptr<ofxOAuthAsyncTransport> asyncTransport; // created on demand
+    ofMutex mutex;
+
+};
@@ -0,0 +1,590 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <oauth.h>
+#include "ofxOAuthBodySource.h"
+#include "ofxOAuthMallocString.h"
+#include "ofxOAuthParams.h"
+#include "ofxOAuthPercentEncoding.h"
+
+
+//------------------------------------------------------------------------------
+// A small, copyable SHA-1.  Being able to copy the running state is what
+// lets ofxOAuthHMACSHA1 keep the keyed inner and outer states around.
+class ofxOAuthSHA1
+{
+public:
+    enum
+    {
+        BLOCK_SIZE = 64,
+        DIGEST_SIZE = 20
+    };
+
+    ofxOAuthSHA1()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        state[0] = 0x67452301;
+        state[1] = 0xEFCDAB89;
+        state[2] = 0x98BADCFE;
+        state[3] = 0x10325476;
+        state[4] = 0xC3D2E1F0;
+        length = 0;
+        bufferSize = 0;
+    }
+
+    void update(const void* data, std::size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+        length += size;
+
+        if(bufferSize > 0)
+        {
+            std::size_t n = BLOCK_SIZE - bufferSize;
+            if(n > size) n = size;
+            memcpy(buffer + bufferSize, bytes, n);
+            bufferSize += n;
+            bytes += n;
+            size -= n;
+
+            if(bufferSize < BLOCK_SIZE) return;
+
+            transform(buffer);
+            bufferSize = 0;
+        }
+
+        while(size >= BLOCK_SIZE)
+        {
+            transform(bytes);
+            bytes += BLOCK_SIZE;
+            size -= BLOCK_SIZE;
+        }
+
+        if(size > 0)
+        {
+            memcpy(buffer, bytes, size);
+            bufferSize = size;
+        }
+    }
+
+    void finish(unsigned char digest[DIGEST_SIZE])
+    {
+        uint64_t bits = length * 8;
+
+        unsigned char pad = 0x80;
+        update(&pad, 1);
+
+        pad = 0;
+        while(bufferSize != BLOCK_SIZE - 8)
+        {
+            update(&pad, 1);
+        }
+
+        unsigned char lengthBytes[8];
+        for(int i = 0; i < 8; ++i)
+        {
+            lengthBytes[i] = (unsigned char)(bits >> (56 - 8 * i));
+        }
+        update(lengthBytes, 8);
+
+        for(int i = 0; i < 5; ++i)
+        {
+            digest[4 * i + 0] = (unsigned char)(state[i] >> 24);
+            digest[4 * i + 1] = (unsigned char)(state[i] >> 16);
+            digest[4 * i + 2] = (unsigned char)(state[i] >> 8);
+            digest[4 * i + 3] = (unsigned char)(state[i]);
+        }
+    }
+
+private:
+    static uint32_t rol(uint32_t v, int bits)
+    {
+        return (v << bits) | (v >> (32 - bits));
+    }
+
+    void transform(const unsigned char block[BLOCK_SIZE])
+    {
+        uint32_t w[80];
+
+        for(int i = 0; i < 16; ++i)
+        {
+            w[i] = ((uint32_t)block[4 * i] << 24) |
+                   ((uint32_t)block[4 * i + 1] << 16) |
+                   ((uint32_t)block[4 * i + 2] << 8) |
+                   ((uint32_t)block[4 * i + 3]);
+        }
+
+        for(int i = 16; i < 80; ++i)
+        {
+            w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        uint32_t a = state[0];
+        uint32_t b = state[1];
+        uint32_t c = state[2];
+        uint32_t d = state[3];
+        uint32_t e = state[4];
+
+        for(int i = 0; i < 80; ++i)
+        {
+            uint32_t f = 0;
+            uint32_t k = 0;
+
+            if(i < 20)
+            {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            }
+            else if(i < 40)
+            {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if(i < 60)
+            {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+
+            uint32_t t = rol(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rol(b, 30);
+            b = a;
+            a = t;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+
+    uint32_t state[5];
+    uint64_t length;
+    unsigned char buffer[BLOCK_SIZE];
+    std::size_t bufferSize;
+
+};
+
+
+//------------------------------------------------------------------------------
+// HMAC-SHA1 with a precomputed key schedule.  setKey() hashes the ipad and
+// opad blocks once and keeps the resulting SHA-1 states; sign() starts from
+// copies of them, so each signature costs only the message blocks plus one
+// block for the outer hash.
+class ofxOAuthHMACSHA1
+{
+public:
+    ofxOAuthHMACSHA1():
+        hasKey(false)
+    {
+    }
+
+    // Returns true if the key schedule had to be rebuilt.
+    bool setKey(const std::string& _key)
+    {
+        if(hasKey && _key == key)
+        {
+            return false;
+        }
+
+        key = _key;
+        hasKey = true;
+
+        unsigned char block[ofxOAuthSHA1::BLOCK_SIZE];
+        memset(block, 0, sizeof(block));
+
+        if(key.size() > ofxOAuthSHA1::BLOCK_SIZE)
+        {
+            ofxOAuthSHA1 sha;
+            sha.update(key.data(), key.size());
+            sha.finish(block);
+        }
+        else
+        {
+            memcpy(block, key.data(), key.size());
+        }
+
+        unsigned char pad[ofxOAuthSHA1::BLOCK_SIZE];
+
+        for(int i = 0; i < ofxOAuthSHA1::BLOCK_SIZE; ++i) pad[i] = block[i] ^ 0x36;
+        inner.reset();
+        inner.update(pad, sizeof(pad));
+
+        for(int i = 0; i < ofxOAuthSHA1::BLOCK_SIZE; ++i) pad[i] = block[i] ^ 0x5c;
+        outer.reset();
+        outer.update(pad, sizeof(pad));
+
+        return true;
+    }
+
+    const std::string& getKey() const
+    {
+        return key;
+    }
+
+    // For signing a message in pieces: update the returned state with the
+    // message and pass it to finish().
+    ofxOAuthSHA1 begin() const
+    {
+        return inner;
+    }
+
+    void finish(ofxOAuthSHA1& innerState,
+                unsigned char digest[ofxOAuthSHA1::DIGEST_SIZE]) const
+    {
+        unsigned char innerDigest[ofxOAuthSHA1::DIGEST_SIZE];
+        innerState.finish(innerDigest);
+
+        ofxOAuthSHA1 sha = outer;
+        sha.update(innerDigest, sizeof(innerDigest));
+        sha.finish(digest);
+    }
+
+    void sign(const void* message,
+              std::size_t size,
+              unsigned char digest[ofxOAuthSHA1::DIGEST_SIZE]) const
+    {
+        ofxOAuthSHA1 sha = begin();
+        sha.update(message, size);
+        finish(sha, digest);
+    }
+
+private:
+    std::string key;
+    bool hasKey;
+
+    ofxOAuthSHA1 inner;
+    ofxOAuthSHA1 outer;
+
+};
+
+
+//------------------------------------------------------------------------------
+class ofxOAuthSigner
+{
+public:
+    enum
+    {
+        BODY_HASH_CHUNK_SIZE = 64 * 1024
+    };
+
+    // Builds the HMAC-SHA1 key "escape(consumerSecret)&escape(tokenSecret)".
+    static std::string makeKey(const std::string& consumerSecret,
+                               const std::string& tokenSecret)
+    {
+        return ofxOAuthPercentEncoding::encode(consumerSecret) + "&" +
+               ofxOAuthPercentEncoding::encode(tokenSecret);
+    }
+
+    // Adds the oauth_* protocol parameters to params, signs the request and
+    // writes the request URL (base URL plus non-oauth parameters) and the
+    // complete "Authorization: OAuth ..." header line.
+    //
+    // For HMAC-SHA1 the signature base string is never materialized; it is
+    // streamed straight from the parameter arena into the keyed SHA-1.
+    static bool signRequest(ofxOAuthParams& params,
+                            const std::string& httpMethod,
+                            const std::string& baseURL,
+                            OAuthMethod signatureMethod,
+                            const std::string& consumerKey,
+                            const std::string& consumerSecret,
+                            const std::string& tokenKey,
+                            const ofxOAuthHMACSHA1& signingKey,
+                            const std::string& realm,
+                            std::string& url,
+                            std::string& header)
+    {
+        std::string normalizedURL = normalizeURL(baseURL);
+
+        if(!params.has("oauth_nonce"))
+        {
+            ofxOAuthMallocString nonce(oauth_gen_nonce());
+            params.add("oauth_nonce", nonce.str());
+        }
+
+        if(!params.has("oauth_timestamp"))
+        {
+            char timestamp[32];
+            snprintf(timestamp, sizeof(timestamp), "%li", (long int)time(NULL));
+            params.add("oauth_timestamp", timestamp);
+        }
+
+        if(!tokenKey.empty())
+        {
+            params.add("oauth_token", tokenKey);
+        }
+
+        params.add("oauth_consumer_key", consumerKey);
+        params.add("oauth_signature_method", getSignatureMethodName(signatureMethod));
+
+        if(!params.has("oauth_version"))
+        {
+            params.add("oauth_version", "1.0");
+        }
+
+        params.sort();
+
+        std::string signature;
+
+        if(signatureMethod == OA_HMAC)
+        {
+            ofxOAuthSHA1 sha = signingKey.begin();
+            SHA1Sink sink(sha);
+            writeBaseString(sink, httpMethod, normalizedURL, params);
+
+            unsigned char digest[ofxOAuthSHA1::DIGEST_SIZE];
+            signingKey.finish(sha, digest);
+            signature = encodeBase64(digest, sizeof(digest));
+        }
+        else if(signatureMethod == OA_PLAINTEXT)
+        {
+            signature = signingKey.getKey();
+        }
+        else
+        {
+            std::string base;
+            writeBaseString(base, httpMethod, normalizedURL, params);
+
+            // liboauth signs RSA-SHA1 with the consumer secret as the private key.
+            ofxOAuthMallocString rsa(oauth_sign_rsa_sha1(base.c_str(), consumerSecret.c_str()));
+            if(rsa.empty())
+            {
+                return false;
+            }
+            signature = rsa.str();
+        }
+
+        params.add("oauth_signature", signature);
+
+        // the request url: base url plus all of the non-oauth parameters.
+        url.clear();
+        url.reserve(normalizedURL.size() + 1 + params.querySize(false));
+        url += normalizedURL;
+        if(params.querySize(false) > 0)
+        {
+            url += '?';
+            params.appendQuery(url, false);
+        }
+
+        // the Authorization header: the quoted oauth parameters.
+        // Note that (optional) 'realm' is not to be included in the oauth
+        // signed parameters and thus only added here.
+        // see 9.1.1 in http://oauth.net/core/1.0/#anchor14
+        header.clear();
+        header.reserve(32 + realm.size() + params.querySize(true) * 2);
+        header += "Authorization: OAuth ";
+
+        bool first = true;
+
+        if(!realm.empty())
+        {
+            header += "realm=\"";
+            header += realm;
+            header += "\"";
+            first = false;
+        }
+
+        for(std::size_t i = 0; i < params.size(); ++i)
+        {
+            if(!params.isProtocolParam(i)) continue;
+            if(!first) header += ", ";
+            header.append(params.key(i), params.keyLength(i));
+            header += "=\"";
+            header.append(params.value(i), params.valueLength(i));
+            header += "\"";
+            first = false;
+        }
+
+        return true;
+    }
+
+    // METHOD&encode(url)&encode(k=v&k=v...), see 9.1.3 in
+    // http://oauth.net/core/1.0/#anchor14.  The parameters must be sorted.
+    template<typename Sink>
+    static void writeBaseString(Sink& sink,
+                                const std::string& httpMethod,
+                                const std::string& normalizedURL,
+                                const ofxOAuthParams& params)
+    {
+        const std::string& method = httpMethod.empty() ? std::string("GET") : httpMethod;
+
+        ofxOAuthPercentEncoding::encode(method.data(), method.size(), sink);
+        sink.append("&", 1);
+        ofxOAuthPercentEncoding::encode(normalizedURL.data(), normalizedURL.size(), sink);
+        sink.append("&", 1);
+
+        for(std::size_t i = 0; i < params.size(); ++i)
+        {
+            if(i > 0) sink.append("%26", 3);
+            ofxOAuthPercentEncoding::encodeEncoded(params.key(i), params.keyLength(i), sink);
+            sink.append("%3D", 3);
+            ofxOAuthPercentEncoding::encodeEncoded(params.value(i), params.valueLength(i), sink);
+        }
+    }
+
+    // Lowercases the scheme and host and drops the query, fragment and
+    // default ports, see 9.1.2 in http://oauth.net/core/1.0/#anchor14
+    static std::string normalizeURL(const std::string& url)
+    {
+        std::string result = url.substr(0, url.find_first_of("?#"));
+
+        std::size_t schemeEnd = result.find("://");
+        if(schemeEnd == std::string::npos) return result;
+
+        std::size_t hostEnd = result.find('/', schemeEnd + 3);
+        if(hostEnd == std::string::npos) hostEnd = result.size();
+
+        // the path is case sensitive, so it is left as it is.
+        for(std::size_t i = 0; i < hostEnd; ++i)
+        {
+            result[i] = (char)tolower((unsigned char)result[i]);
+        }
+
+        std::string scheme = result.substr(0, schemeEnd);
+        std::string defaultPort = scheme == "https" ? ":443" : ":80";
+
+        if(hostEnd >= defaultPort.size() &&
+           result.compare(hostEnd - defaultPort.size(), defaultPort.size(), defaultPort) == 0)
+        {
+            result.erase(hostEnd - defaultPort.size(), defaultPort.size());
+        }
+
+        return result;
+    }
+
+    static const char* getSignatureMethodName(OAuthMethod signatureMethod)
+    {
+        switch (signatureMethod)
+        {
+            case OA_RSA:
+                return "RSA-SHA1";
+            case OA_PLAINTEXT:
+                return "PLAINTEXT";
+            case OA_HMAC:
+            default:
+                return "HMAC-SHA1";
+        }
+    }
+
+    // The oauth_body_hash of a streamed body (OAuth Request Body Hash 1.0):
+    // the base64 SHA-1 of its bytes.  It goes into the signed header, so it
+    // must be known before the body is sent; the body is read once ahead of
+    // time in fixed size chunks and then rewound, so it is never held in
+    // memory.
+    static bool computeBodyHash(ofxOAuthBodySource& body, std::string& hash)
+    {
+        if(!body.rewind())
+        {
+            return false;
+        }
+
+        ofxOAuthSHA1 sha;
+        std::vector<char> chunk(BODY_HASH_CHUNK_SIZE);
+        uint64_t total = 0;
+
+        while(true)
+        {
+            std::size_t n = body.read(&chunk[0], chunk.size());
+            if(n == CURL_READFUNC_ABORT) return false;
+            if(n == 0) break;
+            sha.update(&chunk[0], n);
+            total += n;
+        }
+
+        if(total != body.getSize())
+        {
+            return false;
+        }
+
+        unsigned char digest[ofxOAuthSHA1::DIGEST_SIZE];
+        sha.finish(digest);
+        hash = encodeBase64(digest, sizeof(digest));
+
+        return body.rewind();
+    }
+
+    static std::string encodeBase64(const unsigned char* data, std::size_t size)
+    {
+        static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        std::string result;
+        result.reserve(((size + 2) / 3) * 4);
+
+        for(std::size_t i = 0; i < size; i += 3)
+        {
+            uint32_t n = (uint32_t)data[i] << 16;
+            if(i + 1 < size) n |= (uint32_t)data[i + 1] << 8;
+            if(i + 2 < size) n |= (uint32_t)data[i + 2];
+
+            result += table[(n >> 18) & 0x3F];
+            result += table[(n >> 12) & 0x3F];
+            result += i + 1 < size ? table[(n >> 6) & 0x3F] : '=';
+            result += i + 2 < size ? table[n & 0x3F] : '=';
+        }
+
+        return result;
+    }
+
+private:
+    class SHA1Sink
+    {
+    public:
+        SHA1Sink(ofxOAuthSHA1& _sha): sha(_sha)
+        {
+        }
+
+        void append(const char* data, std::size_t size)
+        {
+            sha.update(data, size);
+        }
+
+    private:
+        ofxOAuthSHA1& sha;
+    };
+
+};
@@ -0,0 +1,223 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "Poco/DateTime.h"
+#include "Poco/DateTimeFormat.h"
+#include "Poco/DateTimeFormatter.h"
+#include "Poco/DateTimeParser.h"
+#include "Poco/Exception.h"
+#include "Poco/File.h"
+#include "Poco/Path.h"
+#include "Poco/String.h"
+#include "Poco/Timestamp.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include "ofMain.h"
+#include "ofxOAuthMappedFile.h"
+
+
+//------------------------------------------------------------------------------
+// A file from the callback server's docRoot, mapped into memory together
+// with what is needed to answer for it: its content type, its length and
+// its ETag / Last-Modified validators.
+class ofxOAuthStaticFile
+{
+public:
+    ofxOAuthStaticFile(const std::string& pathname,
+                       Poco::Timestamp _modified,
+                       Poco::File::FileSize _size):
+        file(pathname),
+        modified(_modified),
+        contentType(getContentType(Poco::Path(pathname).getExtension())),
+        etag(makeETag(_modified, _size))
+    {
+        lastModified = Poco::DateTimeFormatter::format(modified, Poco::DateTimeFormat::HTTP_FORMAT);
+    }
+
+    const char* getData() const
+    {
+        return file.data;
+    }
+
+    std::size_t getSize() const
+    {
+        return file.size;
+    }
+
+    const std::string& getContentType() const
+    {
+        return contentType;
+    }
+
+    const std::string& getETag() const
+    {
+        return etag;
+    }
+
+    const std::string& getLastModified() const
+    {
+        return lastModified;
+    }
+
+    // True if the request's If-None-Match (or, without one, its
+    // If-Modified-Since) shows the client already has this version.
+    bool isNotModified(const Poco::Net::HTTPServerRequest& request) const
+    {
+        if(request.has("If-None-Match"))
+        {
+            std::vector<std::string> tags = ofSplitString(request.get("If-None-Match"), ",", true, true);
+
+            for(std::size_t i = 0; i < tags.size(); ++i)
+            {
+                std::string tag = tags[i];
+                if(tag.compare(0, 2, "W/") == 0) tag.erase(0, 2);
+                if(tag == "*" || tag == etag) return true;
+            }
+
+            return false;
+        }
+
+        if(request.has("If-Modified-Since"))
+        {
+            Poco::DateTime since;
+            int tzd = 0;
+
+            if(Poco::DateTimeParser::tryParse(request.get("If-Modified-Since"), since, tzd))
+            {
+                // http dates only have whole seconds.
+                return modified.epochTime() <= since.timestamp().epochTime();
+            }
+        }
+
+        return false;
+    }
+
+    // "size-mtime", so it changes whenever the file does.
+    static std::string makeETag(Poco::Timestamp modified, Poco::File::FileSize size)
+    {
+        char tag[64];
+        snprintf(tag, sizeof(tag), "\"%llx-%llx\"",
+                 (unsigned long long)size,
+                 (unsigned long long)modified.epochMicroseconds());
+        return tag;
+    }
+
+    // By file extension; the table is built once.
+    static const std::string& getContentType(const std::string& extension)
+    {
+        static const std::map<std::string, std::string> types = makeContentTypes();
+        static const std::string defaultType = "text/html";
+
+        std::map<std::string, std::string>::const_iterator iter = types.find(Poco::toLower(extension));
+
+        return iter != types.end() ? iter->second : defaultType;
+    }
+
+private:
+    ofxOAuthStaticFile(const ofxOAuthStaticFile&);
+    ofxOAuthStaticFile& operator = (const ofxOAuthStaticFile&);
+
+    static std::map<std::string, std::string> makeContentTypes()
+    {
+        std::map<std::string, std::string> types;
+        types["html"] = "text/html";
+        types["htm"] = "text/html";
+        types["css"] = "text/css";
+        types["txt"] = "text/plain";
+        types["js"] = "application/javascript";
+        types["json"] = "application/json";
+        types["jpg"] = "image/jpeg";
+        types["jpeg"] = "image/jpeg";
+        types["jpe"] = "image/jpeg";
+        types["png"] = "image/png";
+        types["gif"] = "image/gif";
+        types["svg"] = "image/svg+xml";
+        types["ico"] = "image/vnd.microsoft.icon";
+        return types;
+    }
+
+    ofxOAuthMappedFile file;
+    Poco::Timestamp modified;
+    std::string contentType;
+    std::string etag;
+    std::string lastModified;
+
+};
+
+
+//------------------------------------------------------------------------------
+// Mapped files by path.  A file is mapped again only after its
+// modification time or size has changed.
+class ofxOAuthStaticFileCache
+{
+public:
+    // NULL if the file does not exist.
+    std::shared_ptr<const ofxOAuthStaticFile> get(const std::string& pathname)
+    {
+        Poco::Timestamp modified(0);
+        Poco::File::FileSize size = 0;
+
+        try
+        {
+            Poco::File file(pathname);
+            if(!file.exists() || !file.isFile()) return std::shared_ptr<const ofxOAuthStaticFile>();
+            modified = file.getLastModified();
+            size = file.getSize();
+        }
+        catch(const Poco::Exception& exc)
+        {
+            ofLogError("ofxOAuthStaticFileCache::get") << exc.displayText();
+            return std::shared_ptr<const ofxOAuthStaticFile>();
+        }
+
+        ofScopedLock lock(mutex);
+
+        std::shared_ptr<const ofxOAuthStaticFile>& entry = files[pathname];
+
+        if(entry == NULL || entry->getETag() != ofxOAuthStaticFile::makeETag(modified, size))
+        {
+            entry = std::shared_ptr<const ofxOAuthStaticFile>(new ofxOAuthStaticFile(pathname, modified, size));
+        }
+
+        return entry;
+    }
+
+    void clear()
+    {
+        ofScopedLock lock(mutex);
+        files.clear();
+    }
+
+private:
+    std::map<std::string, std::shared_ptr<const ofxOAuthStaticFile> > files;
+    ofMutex mutex;
+
+};
@@ -0,0 +1,260 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string.h>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Poco/Exception.h"
+#include "Poco/File.h"
+#include "Poco/Timestamp.h"
+#include "ofMain.h"
+
+
+//------------------------------------------------------------------------------
+// A callback server page with {@QUERY}, {@GET_PARAMS}, {@POST_PARAMS},
+// {@HEADERS} and {@COOKIES} placeholders.  The text is split once into
+// literal runs and slots; render() writes them out in one pass, so a
+// value is never scanned for placeholders itself.
+class ofxOAuthTemplate
+{
+public:
+    enum Slot
+    {
+        QUERY = 0,
+        GET_PARAMS,
+        POST_PARAMS,
+        HEADERS,
+        COOKIES,
+        NUM_SLOTS
+    };
+
+    ofxOAuthTemplate(const std::string& _text):
+        text(_text),
+        literalSize(0)
+    {
+        for(int i = 0; i < NUM_SLOTS; ++i) used[i] = false;
+
+        std::size_t literalStart = 0;
+        std::size_t pos = text.find("{@");
+
+        while(pos != std::string::npos)
+        {
+            int slot = matchSlot(pos);
+
+            if(slot < 0)
+            {
+                pos = text.find("{@", pos + 2);
+                continue;
+            }
+
+            addLiteral(literalStart, pos);
+
+            Segment segment;
+            segment.offset = pos;
+            segment.length = 0;
+            segment.slot = slot;
+            segments.push_back(segment);
+            used[slot] = true;
+
+            literalStart = pos + 3 + strlen(getSlotName((Slot)slot));
+            pos = text.find("{@", literalStart);
+        }
+
+        addLiteral(literalStart, text.size());
+    }
+
+    // Whether the value for the slot is needed at all.
+    bool uses(Slot slot) const
+    {
+        return used[slot];
+    }
+
+    std::size_t getRenderedSize(const std::string values[NUM_SLOTS]) const
+    {
+        std::size_t size = literalSize;
+
+        for(std::size_t i = 0; i < segments.size(); ++i)
+        {
+            if(segments[i].slot >= 0) size += values[segments[i].slot].size();
+        }
+
+        return size;
+    }
+
+    void render(std::ostream& out, const std::string values[NUM_SLOTS]) const
+    {
+        for(std::size_t i = 0; i < segments.size(); ++i)
+        {
+            const Segment& segment = segments[i];
+
+            if(segment.slot < 0)
+            {
+                out.write(text.data() + segment.offset, segment.length);
+            }
+            else
+            {
+                const std::string& value = values[segment.slot];
+                out.write(value.data(), value.size());
+            }
+        }
+    }
+
+    static const char* getSlotName(Slot slot)
+    {
+        switch(slot)
+        {
+            case QUERY:
+                return "QUERY";
+            case GET_PARAMS:
+                return "GET_PARAMS";
+            case POST_PARAMS:
+                return "POST_PARAMS";
+            case HEADERS:
+                return "HEADERS";
+            case COOKIES:
+                return "COOKIES";
+            default:
+                return "";
+        }
+    }
+
+private:
+    struct Segment
+    {
+        std::size_t offset;
+        std::size_t length;
+        int slot; // -1 for literal text
+    };
+
+    // The slot of the "{@NAME}" at pos, or -1.
+    int matchSlot(std::size_t pos) const
+    {
+        for(int i = 0; i < NUM_SLOTS; ++i)
+        {
+            const char* name = getSlotName((Slot)i);
+            std::size_t length = strlen(name);
+
+            if(text.compare(pos + 2, length, name) == 0 &&
+               pos + 2 + length < text.size() &&
+               text[pos + 2 + length] == '}')
+            {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    void addLiteral(std::size_t begin, std::size_t end)
+    {
+        if(end <= begin) return;
+
+        Segment segment;
+        segment.offset = begin;
+        segment.length = end - begin;
+        segment.slot = -1;
+        segments.push_back(segment);
+        literalSize += segment.length;
+    }
+
+    std::string text;
+    std::vector<Segment> segments;
+    std::size_t literalSize;
+    bool used[NUM_SLOTS];
+
+};
+
+
+//------------------------------------------------------------------------------
+// Compiled templates by file.  A file is read and parsed again only after
+// its modification time or size has changed.
+class ofxOAuthTemplateCache
+{
+public:
+    // NULL if the file does not exist.
+    std::shared_ptr<const ofxOAuthTemplate> get(const std::string& pathname)
+    {
+        Poco::Timestamp modified(0);
+        Poco::File::FileSize size = 0;
+
+        try
+        {
+            Poco::File file(pathname);
+            if(!file.exists()) return std::shared_ptr<const ofxOAuthTemplate>();
+            modified = file.getLastModified();
+            size = file.getSize();
+        }
+        catch(const Poco::Exception& exc)
+        {
+            ofLogError("ofxOAuthTemplateCache::get") << exc.displayText();
+            return std::shared_ptr<const ofxOAuthTemplate>();
+        }
+
+        {
+            ofScopedLock lock(mutex);
+            std::map<std::string, Entry>::iterator iter = entries.find(pathname);
+
+            if(iter != entries.end() && iter->second.modified == modified && iter->second.size == size)
+            {
+                return iter->second.page;
+            }
+        }
+
+        // parse outside of the lock, a second reader would just parse it too.
+        ofBuffer buffer = ofBufferFromFile(pathname);
+        std::shared_ptr<const ofxOAuthTemplate> page(new ofxOAuthTemplate(buffer.getText()));
+
+        ofScopedLock lock(mutex);
+        Entry& entry = entries[pathname];
+        entry.modified = modified;
+        entry.size = size;
+        entry.page = page;
+
+        return page;
+    }
+
+    void clear()
+    {
+        ofScopedLock lock(mutex);
+        entries.clear();
+    }
+
+private:
+    struct Entry
+    {
+        Poco::Timestamp modified;
+        Poco::File::FileSize size;
+        std::shared_ptr<const ofxOAuthTemplate> page;
+    };
+
+    std::map<std::string, Entry> entries;
+    ofMutex mutex;
+
+};
@@ -0,0 +1,794 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <stdint.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <curl/curl.h>
+#include <oauth.h>
+#include "Poco/String.h"
+#include "ofMain.h"
+#include "ofxOAuthCAStore.h"
+#include "ofxOAuthHeaders.h"
+#include "ofxOAuthMultipartBody.h"
+#include "ofxOAuthRateLimiter.h"
+#include "ofxOAuthResponse.h"
+#include "ofxOAuthShare.h"
+
+
+//------------------------------------------------------------------------------
+class ofxOAuthTransportRequest
+{
+public:
+    ofxOAuthTransportRequest():
+        method("GET"),
+        hasBody(false),
+        acceptCompression(true),
+        timeoutMillis(0)
+    {
+    }
+
+    std::string method;  // GET, POST, ...
+    std::string url;     // the fully signed request url
+    std::string header;  // the Authorization header line
+    std::vector<std::string> extraHeaders; // more "Name: value" lines, e.g. If-None-Match
+    std::string body;    // only sent if hasBody is true
+    bool hasBody;
+
+    // if set, the body is read from here while it is sent instead.
+    std::shared_ptr<ofxOAuthBodySource> bodySource;
+
+    // send Accept-Encoding (gzip, deflate) and have curl inflate the body
+    // as it arrives, before it reaches the write callback.
+    bool acceptCompression;
+
+    // overrides the transport's timeout if > 0.
+    long timeoutMillis;
+
+    // who the request is made as (the consumer key and token), so that the
+    // rate limiter keeps the budgets of different users apart.
+    std::string account;
+
+};
+
+
+//------------------------------------------------------------------------------
+class ofxOAuthTransportResult
+{
+public:
+    ofxOAuthTransportResult():
+        curlCode(CURLE_OK),
+        status(0)
+    {
+    }
+
+    bool isOk() const
+    {
+        return curlCode == CURLE_OK;
+    }
+
+    CURLcode curlCode;  // transport level result
+    long status;        // http status code, 0 if none was received
+    std::string body;   // the response body
+    std::string error;  // human readable curl error, if any
+
+    ofxOAuthHeaders headers;
+    ofxOAuthTiming timing;
+
+};
+
+
+//------------------------------------------------------------------------------
+// Byte counts over all requests of a transport.  bytesReceived is what
+// came over the wire, bytesDecoded what was handed to the application
+// after decompression.
+class ofxOAuthTransportStats
+{
+public:
+    ofxOAuthTransportStats():
+        numResponses(0),
+        numCompressedResponses(0),
+        bytesReceived(0),
+        bytesDecoded(0)
+    {
+    }
+
+    uint64_t getBytesSaved() const
+    {
+        return bytesDecoded > bytesReceived ? bytesDecoded - bytesReceived : 0;
+    }
+
+    uint64_t numResponses;
+    uint64_t numCompressedResponses;
+    uint64_t bytesReceived;
+    uint64_t bytesDecoded;
+
+};
+
+
+//------------------------------------------------------------------------------
+// The state of one request while it is bound to a curl easy handle.  It is
+// used both by the blocking ofxOAuthTransport::perform and by the
+// ofxOAuthAsyncTransport event loop.
+class ofxOAuthTransfer
+{
+public:
+    ofxOAuthTransfer(const ofxOAuthTransportRequest& _request):
+        request(_request),
+        bytesDecoded(0),
+        handle(NULL),
+        headers(NULL)
+    {
+        errorBuffer[0] = 0;
+    }
+
+    virtual ~ofxOAuthTransfer()
+    {
+        curl_slist_free_all(headers);
+    }
+
+    // Called from curl's write callback with each piece of the body.
+    // Return size to accept it, CURL_WRITEFUNC_PAUSE to pause the
+    // transfer (the same data is delivered again once it is unpaused)
+    // or anything else to abort it.
+    virtual std::size_t write(const char* data, std::size_t size)
+    {
+        if(bodyBuffer != NULL)
+        {
+            bodyBuffer->append(data, size);
+        }
+        else
+        {
+            result.body.append(data, size);
+        }
+
+        return size;
+    }
+
+    ofxOAuthTransportRequest request;
+    ofxOAuthTransportResult result;
+
+    // if set, the body is written here instead of result.body.
+    std::shared_ptr<ofBuffer> bodyBuffer;
+
+    uint64_t bytesDecoded; // body bytes delivered to write()
+
+    // the limiter a token was taken from, it is given back when the transfer finishes.
+    std::shared_ptr<ofxOAuthRateLimiter> rateLimiter;
+
+    // the handle may point at it until the transfer finishes.
+    std::shared_ptr<ofxOAuthCAStore> caStore;
+
+    std::string host;
+    CURL* handle;
+    struct curl_slist* headers;
+    char errorBuffer[CURL_ERROR_SIZE];
+
+private:
+    ofxOAuthTransfer(const ofxOAuthTransfer&);
+    ofxOAuthTransfer& operator = (const ofxOAuthTransfer&);
+
+};
+
+
+//------------------------------------------------------------------------------
+// The transport keeps a small pool of curl easy handles per api host
+// (scheme://host:port).  Each easy handle owns its own connection cache,
+// DNS cache and TLS session id cache, so handing the same handle back out
+// for the next request to the same host lets curl reuse the open
+// keep-alive connection instead of paying for DNS, TCP and a full TLS
+// handshake every time, which is what oauth_http_get2 / oauth_http_post2 do.
+class ofxOAuthTransport
+{
+public:
+    ofxOAuthTransport():
+        maxIdleHandlesPerHost(4),
+        numReservedIdleHandles(0),
+        timeout(0),
+        connectTimeout(30),
+        rateLimiter(new ofxOAuthRateLimiter()),
+        maxRateLimitWaitMillis(15 * 60 * 1000),
+        bufferPool(new ofxOAuthBufferPool())
+    {
+    }
+
+    virtual ~ofxOAuthTransport()
+    {
+        closeIdleConnections();
+    }
+
+    bool get(const std::string& url,
+             const std::string& header,
+             ofxOAuthTransportResult& result)
+    {
+        ofxOAuthTransportRequest request;
+        request.method = "GET";
+        request.url = url;
+        request.header = header;
+        return perform(request, result);
+    }
+
+    bool post(const std::string& url,
+              const std::string& body,
+              const std::string& header,
+              ofxOAuthTransportResult& result)
+    {
+        ofxOAuthTransportRequest request;
+        request.method = "POST";
+        request.url = url;
+        request.header = header;
+        request.body = body;
+        request.hasBody = true;
+        return perform(request, result);
+    }
+
+    bool perform(const ofxOAuthTransportRequest& request,
+                 ofxOAuthTransportResult& result)
+    {
+        ofxOAuthTransfer transfer(request);
+
+        if(!waitForRateLimit(transfer) || !beginTransfer(transfer))
+        {
+            result = transfer.result;
+            return false;
+        }
+
+        finishTransfer(transfer, curl_easy_perform(transfer.handle));
+
+        result = transfer.result;
+        return result.isOk();
+    }
+
+    // Like perform() above, but the body is written straight into a pooled
+    // buffer that the response then owns, so it is never copied.
+    bool perform(const ofxOAuthTransportRequest& request,
+                 ofxOAuthResponse& response)
+    {
+        ofxOAuthTransfer transfer(request);
+        transfer.bodyBuffer = bufferPool->acquire();
+
+        if(waitForRateLimit(transfer) && beginTransfer(transfer))
+        {
+            finishTransfer(transfer, curl_easy_perform(transfer.handle));
+        }
+
+        response.curlCode = transfer.result.curlCode;
+        response.status = transfer.result.status;
+        response.error.swap(transfer.result.error);
+        response.headers.swap(transfer.result.headers);
+        response.timing = transfer.result.timing;
+        response.body = transfer.bodyBuffer;
+
+        return response.isOk();
+    }
+
+    // Takes a token from the rate limiter for the transfer.  Returns 0 if
+    // it may be sent now, or the milliseconds to wait before asking again.
+    // Returns -1 and fails the transfer if the wait would be longer than
+    // the max rate limit wait.
+    long reserveRateLimit(ofxOAuthTransfer& transfer)
+    {
+        std::shared_ptr<ofxOAuthRateLimiter> limiter;
+        long maxWait = 0;
+
+        {
+            ofScopedLock lock(mutex);
+            limiter = rateLimiter;
+            maxWait = maxRateLimitWaitMillis;
+        }
+
+        if(limiter == NULL || transfer.rateLimiter != NULL) return 0;
+
+        long wait = limiter->tryAcquire(transfer.request.url, maxWait, transfer.request.account);
+
+        if(wait == 0)
+        {
+            transfer.rateLimiter = limiter;
+        }
+        else if(wait < 0)
+        {
+            failRateLimited(transfer, limiter);
+        }
+
+        return wait;
+    }
+
+    // Like reserveRateLimit(), but sleeps until the token is available.
+    bool waitForRateLimit(ofxOAuthTransfer& transfer)
+    {
+        std::shared_ptr<ofxOAuthRateLimiter> limiter;
+        long maxWait = 0;
+
+        {
+            ofScopedLock lock(mutex);
+            limiter = rateLimiter;
+            maxWait = maxRateLimitWaitMillis;
+        }
+
+        if(limiter == NULL) return true;
+
+        if(!limiter->acquire(transfer.request.url, maxWait, transfer.request.account))
+        {
+            failRateLimited(transfer, limiter);
+            return false;
+        }
+
+        transfer.rateLimiter = limiter;
+        return true;
+    }
+
+    // Binds a pooled easy handle to the transfer and configures it.
+    bool beginTransfer(ofxOAuthTransfer& transfer)
+    {
+        // a streamed body may have been (partly) sent by an earlier attempt.
+        if(transfer.request.bodySource != NULL && !transfer.request.bodySource->rewind())
+        {
+            transfer.result.curlCode = CURLE_READ_ERROR;
+            transfer.result.error = "Unable to rewind the request body.";
+            releaseRateLimit(transfer);
+            return false;
+        }
+
+        transfer.host = getHostKey(transfer.request.url);
+        transfer.handle = acquireHandle(transfer.host);
+
+        if(transfer.handle == NULL)
+        {
+            transfer.result.curlCode = CURLE_FAILED_INIT;
+            transfer.result.error = "Unable to create a curl handle.";
+            releaseRateLimit(transfer);
+            return false;
+        }
+
+        const ofxOAuthTransportRequest& request = transfer.request;
+
+        CURL* handle = transfer.handle;
+
+        if(!request.header.empty())
+        {
+            transfer.headers = curl_slist_append(transfer.headers, request.header.c_str());
+        }
+
+        for(std::size_t i = 0; i < request.extraHeaders.size(); ++i)
+        {
+            transfer.headers = curl_slist_append(transfer.headers, request.extraHeaders[i].c_str());
+        }
+
+        if(request.bodySource != NULL)
+        {
+            std::string contentType = "Content-Type: " + request.bodySource->getContentType();
+            transfer.headers = curl_slist_append(transfer.headers, contentType.c_str());
+        }
+
+        configureHandle(transfer);
+
+        if(request.timeoutMillis > 0)
+        {
+            curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, request.timeoutMillis);
+        }
+
+        curl_easy_setopt(handle, CURLOPT_URL, request.url.c_str());
+        curl_easy_setopt(handle, CURLOPT_HTTPHEADER, transfer.headers);
+        curl_easy_setopt(handle, CURLOPT_ERRORBUFFER, transfer.errorBuffer);
+        curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, &ofxOAuthTransport::writeCallback);
+        curl_easy_setopt(handle, CURLOPT_WRITEDATA, &transfer);
+        curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, &ofxOAuthTransport::headerCallback);
+        curl_easy_setopt(handle, CURLOPT_HEADERDATA, &transfer);
+        curl_easy_setopt(handle, CURLOPT_PRIVATE, &transfer);
+
+        if(request.bodySource != NULL)
+        {
+            curl_easy_setopt(handle, CURLOPT_POST, 1L);
+            curl_easy_setopt(handle, CURLOPT_READFUNCTION, &ofxOAuthTransport::readCallback);
+            curl_easy_setopt(handle, CURLOPT_READDATA, &transfer);
+            curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)request.bodySource->getSize());
+        }
+        else if(request.hasBody)
+        {
+            curl_easy_setopt(handle, CURLOPT_POST, 1L);
+            curl_easy_setopt(handle, CURLOPT_POSTFIELDS, request.body.c_str());
+            curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE, (long)request.body.size());
+        }
+
+        if(request.acceptCompression)
+        {
+            // "" offers every encoding this libcurl was built with.
+#if LIBCURL_VERSION_NUM >= 0x071506
+            curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, "");
+#else
+            curl_easy_setopt(handle, CURLOPT_ENCODING, "");
+#endif
+        }
+
+        if(request.method != "GET" && request.method != "POST")
+        {
+            curl_easy_setopt(handle, CURLOPT_CUSTOMREQUEST, request.method.c_str());
+        }
+
+        return true;
+    }
+
+    // Collects the result and hands the easy handle back to the pool.
+    void finishTransfer(ofxOAuthTransfer& transfer, CURLcode code)
+    {
+        ofxOAuthTransportResult& result = transfer.result;
+
+        result.curlCode = code;
+
+        curl_easy_getinfo(transfer.handle, CURLINFO_RESPONSE_CODE, &result.status);
+
+        getTiming(transfer.handle, result.timing);
+
+        // the download size counts the body as it came over the wire.
+        double bytesReceived = 0;
+        curl_easy_getinfo(transfer.handle, CURLINFO_SIZE_DOWNLOAD, &bytesReceived);
+
+        {
+            ofScopedLock lock(mutex);
+            stats.numResponses++;
+            stats.bytesReceived += (uint64_t)bytesReceived;
+            stats.bytesDecoded += transfer.bytesDecoded;
+            if(transfer.bytesDecoded > (uint64_t)bytesReceived) stats.numCompressedResponses++;
+        }
+
+        releaseRateLimit(transfer);
+
+        if(result.curlCode != CURLE_OK)
+        {
+            result.error = transfer.errorBuffer[0] != 0 ? transfer.errorBuffer : curl_easy_strerror(result.curlCode);
+            ofLogVerbose("ofxOAuthTransport::finishTransfer") << transfer.request.method << " " << transfer.request.url << " failed: " << result.error;
+        }
+
+        // a handle that failed at the transport level may hold a broken
+        // connection, so it is not put back in the pool.
+        if(result.curlCode == CURLE_OK)
+        {
+            releaseHandle(transfer.host, transfer.handle);
+        }
+        else
+        {
+            curl_easy_cleanup(transfer.handle);
+        }
+
+        transfer.handle = NULL;
+    }
+    void closeIdleConnections()
+    {
+        ofScopedLock lock(mutex);
+
+        std::map<std::string, std::vector<CURL*> >::iterator iter = idleHandles.begin();
+
+        while(iter != idleHandles.end())
+        {
+            for(std::size_t i = 0; i < (*iter).second.size(); ++i)
+            {
+                curl_easy_cleanup((*iter).second[i]);
+            }
+            ++iter;
+        }
+
+        idleHandles.clear();
+    }
+
+    // The bundle is shared with every other transport that uses the same
+    // file, see ofxOAuthCAStore.  An empty pathname leaves curl's default.
+    void setCACertificateFile(const std::string& pathname)
+    {
+        std::shared_ptr<ofxOAuthCAStore> store;
+        if(!pathname.empty()) store = ofxOAuthCAStore::get(pathname);
+
+        ofScopedLock lock(mutex);
+        caStore = store;
+    }
+
+    std::string getCACertificateFile()
+    {
+        ofScopedLock lock(mutex);
+        return caStore != NULL ? caStore->getPathname() : std::string();
+    }
+
+    std::shared_ptr<ofxOAuthCAStore> getCAStore()
+    {
+        ofScopedLock lock(mutex);
+        return caStore;
+    }
+
+    void setMaxIdleHandlesPerHost(std::size_t v)
+    {
+        ofScopedLock lock(mutex);
+        maxIdleHandlesPerHost = v;
+    }
+
+    std::size_t getMaxIdleHandlesPerHost()
+    {
+        ofScopedLock lock(mutex);
+        return maxIdleHandlesPerHost;
+    }
+
+    // Keeps up to n more idle handles per host while the reservation is
+    // held, e.g. by a bulk fetch with n requests in flight, without
+    // touching the limit set above.  The pool keeps the larger of the two
+    // limits; the handles beyond it are closed once the reservations are
+    // given back.
+    void reserveIdleHandles(std::size_t n)
+    {
+        ofScopedLock lock(mutex);
+        numReservedIdleHandles += n;
+    }
+
+    void releaseIdleHandles(std::size_t n)
+    {
+        ofScopedLock lock(mutex);
+
+        numReservedIdleHandles -= std::min(n, numReservedIdleHandles);
+
+        std::size_t limit = getIdleHandleLimit();
+        std::map<std::string, std::vector<CURL*> >::iterator iter = idleHandles.begin();
+
+        while(iter != idleHandles.end())
+        {
+            while((*iter).second.size() > limit)
+            {
+                curl_easy_cleanup((*iter).second.back());
+                (*iter).second.pop_back();
+            }
+            ++iter;
+        }
+    }
+
+    // Attaches every handle to a curl share, so DNS results and TLS
+    // sessions are shared with other transports using the same share.
+    void setShare(std::shared_ptr<ofxOAuthShare> _share)
+    {
+        ofScopedLock lock(mutex);
+        share = _share;
+    }
+
+    std::shared_ptr<ofxOAuthShare> getShare()
+    {
+        ofScopedLock lock(mutex);
+        return share;
+    }
+
+    // total request timeout in seconds, 0 for none.
+    void setTimeout(long seconds)
+    {
+        ofScopedLock lock(mutex);
+        timeout = seconds;
+    }
+
+    void setConnectTimeout(long seconds)
+    {
+        ofScopedLock lock(mutex);
+        connectTimeout = seconds;
+    }
+
+    ofxOAuthTransportStats getStats()
+    {
+        ofScopedLock lock(mutex);
+        return stats;
+    }
+
+    void resetStats()
+    {
+        ofScopedLock lock(mutex);
+        stats = ofxOAuthTransportStats();
+    }
+
+    // Requests are held back when the rate limit headers of earlier
+    // responses say they would be refused.  NULL turns this off.
+    void setRateLimiter(std::shared_ptr<ofxOAuthRateLimiter> limiter)
+    {
+        ofScopedLock lock(mutex);
+        rateLimiter = limiter;
+    }
+
+    std::shared_ptr<ofxOAuthRateLimiter> getRateLimiter()
+    {
+        ofScopedLock lock(mutex);
+        return rateLimiter;
+    }
+
+    // Requests that would have to wait longer than this for their rate
+    // limit fail right away instead.  Negative waits as long as needed.
+    void setMaxRateLimitWaitMillis(long v)
+    {
+        ofScopedLock lock(mutex);
+        maxRateLimitWaitMillis = v;
+    }
+
+    std::shared_ptr<ofxOAuthBufferPool> getBufferPool()
+    {
+        return bufferPool;
+    }
+
+    // returns scheme://host[:port] for a url, used as the pool key.
+    static std::string getHostKey(const std::string& url)
+    {
+        std::size_t schemeEnd = url.find("://");
+        std::size_t hostStart = schemeEnd == std::string::npos ? 0 : schemeEnd + 3;
+        std::size_t hostEnd = url.find_first_of("/?#", hostStart);
+        return Poco::toLower(url.substr(0, hostEnd));
+    }
+
+protected:
+    CURL* acquireHandle(const std::string& host)
+    {
+        {
+            ofScopedLock lock(mutex);
+
+            std::vector<CURL*>& handles = idleHandles[host];
+
+            if(!handles.empty())
+            {
+                CURL* handle = handles.back();
+                handles.pop_back();
+                // curl_easy_reset clears the options, but keeps the
+                // live connections, dns cache and tls session ids.
+                curl_easy_reset(handle);
+                return handle;
+            }
+        }
+
+        return curl_easy_init();
+    }
+
+    void releaseHandle(const std::string& host, CURL* handle)
+    {
+        ofScopedLock lock(mutex);
+
+        std::vector<CURL*>& handles = idleHandles[host];
+
+        if(handles.size() < getIdleHandleLimit())
+        {
+            handles.push_back(handle);
+        }
+        else
+        {
+            curl_easy_cleanup(handle);
+        }
+    }
+
+    // must be called with mutex held.
+    std::size_t getIdleHandleLimit() const
+    {
+        return std::max(maxIdleHandlesPerHost, numReservedIdleHandles);
+    }
+
+    static void getTiming(CURL* handle, ofxOAuthTiming& timing)
+    {
+        double seconds = 0;
+        curl_easy_getinfo(handle, CURLINFO_NAMELOOKUP_TIME, &seconds);
+        timing.nameLookup = seconds * 1000;
+        curl_easy_getinfo(handle, CURLINFO_CONNECT_TIME, &seconds);
+        timing.connect = seconds * 1000;
+        curl_easy_getinfo(handle, CURLINFO_APPCONNECT_TIME, &seconds);
+        timing.tlsHandshake = seconds * 1000;
+        curl_easy_getinfo(handle, CURLINFO_PRETRANSFER_TIME, &seconds);
+        timing.pretransfer = seconds * 1000;
+        curl_easy_getinfo(handle, CURLINFO_STARTTRANSFER_TIME, &seconds);
+        timing.firstByte = seconds * 1000;
+        curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME, &seconds);
+        timing.total = seconds * 1000;
+        curl_easy_getinfo(handle, CURLINFO_REDIRECT_TIME, &seconds);
+        timing.redirect = seconds * 1000;
+    }
+
+    void releaseRateLimit(ofxOAuthTransfer& transfer)
+    {
+        if(transfer.rateLimiter != NULL)
+        {
+            transfer.rateLimiter->release(transfer.request.url,
+                                          transfer.result.status,
+                                          transfer.result.headers,
+                                          transfer.request.account);
+            transfer.rateLimiter.reset();
+        }
+    }
+
+    static void failRateLimited(ofxOAuthTransfer& transfer, std::shared_ptr<ofxOAuthRateLimiter> limiter)
+    {
+        transfer.result.curlCode = CURLE_ABORTED_BY_CALLBACK;
+        transfer.result.error = "The rate limit for " + limiter->getFamily(transfer.request.url) + " is used up.";
+        ofLogVerbose("ofxOAuthTransport::failRateLimited") << transfer.result.error;
+    }
+
+    void configureHandle(ofxOAuthTransfer& transfer)
+    {
+        CURL* handle = transfer.handle;
+        long _timeout = 0;
+        long _connectTimeout = 0;
+        std::shared_ptr<ofxOAuthShare> _share;
+
+        {
+            ofScopedLock lock(mutex);
+            transfer.caStore = caStore;
+            _timeout = timeout;
+            _connectTimeout = connectTimeout;
+            _share = share;
+        }
+
+        curl_easy_setopt(handle, CURLOPT_USERAGENT, "liboauth-agent/" LIBOAUTH_VERSION);
+        curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(handle, CURLOPT_TIMEOUT, _timeout);
+        curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT, _connectTimeout);
+
+        if(transfer.caStore != NULL)
+        {
+            transfer.caStore->configure(handle);
+        }
+
+        if(_share != NULL)
+        {
+            curl_easy_setopt(handle, CURLOPT_SHARE, _share->getHandle());
+        }
+    }
+
+    static size_t writeCallback(char* ptr, size_t size, size_t nmemb, void* userdata)
+    {
+        ofxOAuthTransfer* transfer = static_cast<ofxOAuthTransfer*>(userdata);
+        std::size_t written = transfer->write(ptr, size * nmemb);
+        if(written == size * nmemb) transfer->bytesDecoded += written;
+        return written;
+    }
+
+    static size_t readCallback(char* ptr, size_t size, size_t nmemb, void* userdata)
+    {
+        return static_cast<ofxOAuthTransfer*>(userdata)->request.bodySource->read(ptr, size * nmemb);
+    }
+
+    static size_t headerCallback(char* ptr, size_t size, size_t nmemb, void* userdata)
+    {
+        static_cast<ofxOAuthTransfer*>(userdata)->result.headers.appendLine(ptr, size * nmemb);
+        return size * nmemb;
+    }
+
+    std::map<std::string, std::vector<CURL*> > idleHandles;
+    std::size_t maxIdleHandlesPerHost;
+    std::size_t numReservedIdleHandles; // by bulk fetches, see reserveIdleHandles()
+
+    std::shared_ptr<ofxOAuthCAStore> caStore;
+    long timeout;
+    long connectTimeout;
+
+    // idle handles are closed in the destructor, before this is released.
+    std::shared_ptr<ofxOAuthShare> share;
+
+    std::shared_ptr<ofxOAuthRateLimiter> rateLimiter;
+    long maxRateLimitWaitMillis;
+
+    std::shared_ptr<ofxOAuthBufferPool> bufferPool;
+
+    ofxOAuthTransportStats stats;
+
+    ofMutex mutex;
+
+};
@@ -0,0 +1,160 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include "Poco/RWLock.h"
+#include "ofMain.h"
+#include "ofxOAuthVerifierCallbackInterface.h"
+
+
+//------------------------------------------------------------------------------
+// Which client a verifier callback belongs to, by the oauth_token in the
+// redirect.  Lets one callback server take the redirects of any number of
+// authorization flows at once.
+//
+// The tokens are spread over SHARD_COUNT maps, each behind its own
+// read / write lock, so lookups from the server's workers only contend
+// with each other for a registration in the same shard.
+class ofxOAuthVerifierCallbackRouter
+{
+public:
+    enum
+    {
+        SHARD_COUNT = 16
+    };
+
+    void add(const std::string& token, ofxOAuthVerifierCallbackInterface* callback)
+    {
+        Shard& shard = getShard(token);
+        Poco::ScopedWriteRWLock lock(shard.lock);
+        shard.callbacks[token] = callback;
+    }
+
+    void remove(const std::string& token)
+    {
+        Shard& shard = getShard(token);
+        Poco::ScopedWriteRWLock lock(shard.lock);
+        shard.callbacks.erase(token);
+    }
+
+    // Removes every token of the callback.  Once it returns, no worker is
+    // calling into the callback any more (see Lookup), so the callback can
+    // be destroyed.
+    void remove(ofxOAuthVerifierCallbackInterface* callback)
+    {
+        for(std::size_t i = 0; i < SHARD_COUNT; ++i)
+        {
+            Poco::ScopedWriteRWLock lock(shards[i].lock);
+
+            std::map<std::string, ofxOAuthVerifierCallbackInterface*>::iterator iter = shards[i].callbacks.begin();
+
+            while(iter != shards[i].callbacks.end())
+            {
+                if(iter->second == callback)
+                {
+                    shards[i].callbacks.erase(iter++);
+                }
+                else
+                {
+                    ++iter;
+                }
+            }
+        }
+    }
+
+    std::size_t size()
+    {
+        std::size_t n = 0;
+
+        for(std::size_t i = 0; i < SHARD_COUNT; ++i)
+        {
+            Poco::ScopedReadRWLock lock(shards[i].lock);
+            n += shards[i].callbacks.size();
+        }
+
+        return n;
+    }
+
+    class Shard
+    {
+    public:
+        std::map<std::string, ofxOAuthVerifierCallbackInterface*> callbacks;
+        Poco::RWLock lock;
+    };
+
+    // The callback for a token, or NULL.  The token cannot be removed
+    // while the Lookup exists, so keep it for as long as the callback is
+    // being called and no longer.
+    class Lookup
+    {
+    public:
+        Lookup(ofxOAuthVerifierCallbackRouter& router, const std::string& token):
+            shard(router.getShard(token)),
+            lock(shard.lock),
+            callback(NULL)
+        {
+            std::map<std::string, ofxOAuthVerifierCallbackInterface*>::const_iterator iter = shard.callbacks.find(token);
+            if(iter != shard.callbacks.end()) callback = iter->second;
+        }
+
+        ofxOAuthVerifierCallbackInterface* get() const
+        {
+            return callback;
+        }
+
+    private:
+        Lookup(const Lookup&);
+        Lookup& operator = (const Lookup&);
+
+        Shard& shard;
+        Poco::ScopedReadRWLock lock;
+        ofxOAuthVerifierCallbackInterface* callback;
+    };
+
+private:
+    friend class Lookup;
+
+    // FNV-1a.
+    Shard& getShard(const std::string& token)
+    {
+        uint32_t hash = 2166136261u;
+
+        for(std::size_t i = 0; i < token.size(); ++i)
+        {
+            hash ^= (unsigned char)token[i];
+            hash *= 16777619u;
+        }
+
+        return shards[hash % SHARD_COUNT];
+    }
+
+    Shard shards[SHARD_COUNT];
+
+};
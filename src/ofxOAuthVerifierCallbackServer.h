@@ -27,12 +27,18 @@
 
 
 #include <set>
+#include "Poco/Exception.h"
+#include "Poco/Runnable.h"
 #include "Poco/String.h"
 #include "Poco/SharedPtr.h"
+#include "Poco/ThreadPool.h"
 #include "Poco/URI.h"
+#include "Poco/Net/DatagramSocket.h"
+#include "Poco/Net/HTTPServerConnection.h"
 #include "Poco/Net/HTTPServerParams.h"
-#include "Poco/Net/HTTPServer.h"
 #include "Poco/Net/ServerSocket.h"
+#include "Poco/Net/Socket.h"
+#include "Poco/Net/SocketAddress.h"
 #include "Poco/Net/HTTPRequestHandlerFactory.h"
 #include "Poco/Net/HTTPRequestHandler.h"
 #include "Poco/Net/HTTPServerRequest.h"
@@ -40,6 +46,11 @@
 #include "Poco/Net/NameValueCollection.h"
 #include "ofMain.h"
 #include "ofxOAuthVerifierCallbackInterface.h"
+#include "ofxOAuthFormParser.h"
+#include "ofxOAuthPercentEncoding.h"
+#include "ofxOAuthStaticFile.h"
+#include "ofxOAuthTemplate.h"
+#include "ofxOAuthVerifierCallbackRouter.h"
 
 
 //------------------------------------------------------------------------------
@@ -47,9 +58,17 @@ class ofxOAuthAuthReqHandler: public Poco::Net::HTTPRequestHandler
 {
 public:
     ofxOAuthAuthReqHandler(ofxOAuthVerifierCallbackInterface* _callback,
-                           const std::string& _docRoot):
+                           std::shared_ptr<ofxOAuthVerifierCallbackRouter> _router,
+                           const std::string& _docRoot,
+                           std::shared_ptr<ofxOAuthTemplateCache> _templates,
+                           std::shared_ptr<ofxOAuthStaticFileCache> _files,
+                           std::size_t _maxPostBodySize):
         callback(_callback),
-        docRoot(_docRoot)
+        router(_router),
+        docRoot(_docRoot),
+        templates(_templates),
+        files(_files),
+        maxPostBodySize(_maxPostBodySize)
     {
     }
 
@@ -68,52 +87,39 @@ public:
 
         ofLogVerbose("ofxOAuthAuthReqHandler::handleRequest") << "request: " << request.getURI();
 
-        // send raw request
-        callback->receivedVerifierCallbackRequest(request);
-        
-        // send the cookies
         Poco::Net::NameValueCollection cookies;
         request.getCookies(cookies);
-        if(!cookies.empty())
-        {
-            callback->receivedVerifierCallbackCookies(cookies);
-        }
-        else
-        {
-            ofLogVerbose("ofxOAuthAuthReqHandler::handleRequest") << "Cookies are empty.";
-        }
 
-        // send the headers
-        if(!request.empty())
-        {
-            callback->receivedVerifierCallbackHeaders(request);
-        }
-        else
-        {
-            ofLogVerbose("ofxOAuthAuthReqHandler::handleRequest") << "Headers are empty.";
-        }
-        
         Poco::Net::NameValueCollection queryParams;
         parseQuery(uri.getQuery(),queryParams);
-        if(!queryParams.empty())
-        {
-            callback->receivedVerifierCallbackGetParams(queryParams);
-        }
-        else
-        {
-            ofLogVerbose("ofxOAuthAuthReqHandler::handleRequest") << "Get Query params are empty.";
-        }
-                
-        // TODO: we currently don't parse POST data.
+
         Poco::Net::NameValueCollection postParams;
-        // Parse them here ...
-        if(!postParams.empty())
+
+        if(isMatch(request.getMethod(), "POST") && ofxOAuthFormParser::canParse(request.getContentType()))
         {
-            callback->receivedVerifierCallbackPostParams(postParams);
+            Poco::Net::HTTPResponse::HTTPStatus status = readPostParams(request, postParams);
+
+            if(status != Poco::Net::HTTPResponse::HTTP_OK)
+            {
+                response.setStatusAndReason(status);
+                response.send();
+                return;
+            }
         }
-        else
+
         {
-            ofLogVerbose("ofxOAuthAuthReqHandler::handleRequest") << "Post Query params are empty.";
+            // the client whose request token this is (form_post responses
+            // carry it in the body).  Requests without a known token
+            // (images, favicon.ico, ...) go to the server's own callback,
+            // if it has one.
+            std::string token = queryParams.has("oauth_token") ? queryParams.get("oauth_token") : postParams.get("oauth_token", "");
+            ofxOAuthVerifierCallbackRouter::Lookup route(*router, token);
+            ofxOAuthVerifierCallbackInterface* target = route.get() != NULL ? route.get() : callback;
+
+            if(target != NULL)
+            {
+                notify(target, request, cookies, queryParams, postParams);
+            }
         }
 
         std::string path = uri.getPath();
@@ -125,47 +131,13 @@ public:
 
         ofFile file(docRoot+path);
         ofBuffer outputBuffer;
+        std::shared_ptr<const ofxOAuthTemplate> page;
         
         if(file.exists())
         {
-            // text types
             std::string ext = file.getExtension();
-            bool doReplacements = false;
-            
-            if(isMatch(ext, "html") || isMatch(ext, "htm"))
-            {
-                response.setContentType("text/html");
-                doReplacements = true;
-            }
-            else if(isMatch(ext, "json"))
-            {
-                response.setContentType("application/json");
-                // image types
-            }
-            else if(isMatch(ext, "jpg") || isMatch(ext, "jpeg") || isMatch(ext, "jpe"))
-            {
-                response.setContentType("image/jpeg");
-            }
-            else if(isMatch(ext, "png"))
-            {
-                response.setContentType("image/png");
-            }
-            else if(isMatch(ext, "gif"))
-            {
-                response.setContentType("image/gif");
-            }
-            else if(isMatch(ext, "ico"))
-            {
-                response.setContentType("image/vnd.microsoft.icon");
+            response.setContentType(ofxOAuthStaticFile::getContentType(ext));
 
-                // everything else
-            }
-            else
-            {
-                response.setContentType("text/html");
-            }
-            
-        
             // replace any magic keys
             
             // {@QUERY} -> is replaced with URL
@@ -174,32 +146,28 @@ public:
             // {@HEADERS} -> is replaced with headers
             // {@COOKIES} -> is replaced with cookies
             
-            // load the file into the buffer
-            file >> outputBuffer;
-            
-            if(doReplacements)
+            if(isMatch(ext, "html") || isMatch(ext, "htm"))
             {
-                std::string text = outputBuffer.getText();
-                
-                std::string target;
-                target = "{@QUERY}";
-                Poco::replaceInPlace(text, target, makeHTMLList(uri.getQuery()));
-                
-                target = "{@GET_PARAMS}";
-                Poco::replaceInPlace(text, target, makeHTMLList(queryParams));
-                
-                target = "{@POST_PARAMS}";
-                Poco::replaceInPlace(text, target, makeHTMLList(postParams));
+                // parsed once, and again only when the file changes.
+                page = templates->get(file.getAbsolutePath());
+            }
+            else
+            {
+                // mapped once, and again only when the file changes.
+                std::shared_ptr<const ofxOAuthStaticFile> staticFile = files->get(file.getAbsolutePath());
 
-                target = "{@HEADERS}";
-                Poco::replaceInPlace(text, target, makeHTMLList(request));
-                
-                target = "{@COOKIES}";
-                Poco::replaceInPlace(text, target, makeHTMLList(cookies));
+                if(staticFile != NULL)
+                {
+                    sendStaticFile(request, response, *staticFile);
+                    return;
+                }
+            }
 
-                outputBuffer.set(text);
+            if(page == NULL)
+            {
+                // load the file into the buffer
+                file >> outputBuffer;
             }
-            
         }
         else
         {
@@ -218,11 +186,135 @@ public:
             }
         }
 
+        if(page != NULL)
+        {
+            // only the values the page actually uses are built.
+            std::string values[ofxOAuthTemplate::NUM_SLOTS];
+            if(page->uses(ofxOAuthTemplate::QUERY)) values[ofxOAuthTemplate::QUERY] = makeHTMLList(uri.getQuery());
+            if(page->uses(ofxOAuthTemplate::GET_PARAMS)) values[ofxOAuthTemplate::GET_PARAMS] = makeHTMLList(queryParams);
+            if(page->uses(ofxOAuthTemplate::POST_PARAMS)) values[ofxOAuthTemplate::POST_PARAMS] = makeHTMLList(postParams);
+            if(page->uses(ofxOAuthTemplate::HEADERS)) values[ofxOAuthTemplate::HEADERS] = makeHTMLList(request);
+            if(page->uses(ofxOAuthTemplate::COOKIES)) values[ofxOAuthTemplate::COOKIES] = makeHTMLList(cookies);
+
+            response.setChunkedTransferEncoding(false);
+            response.setContentLength(page->getRenderedSize(values));
+
+            std::ostream& ostr = response.send();
+            page->render(ostr, values);
+            return;
+        }
+
         std::ostream& ostr = response.send();
         ostr << outputBuffer;
     }
     
 protected:
+    // Reads a form body in fixed size chunks as it arrives.  Returns
+    // HTTP_OK, or the status to answer with if the body is too large or
+    // malformed.
+    Poco::Net::HTTPResponse::HTTPStatus readPostParams(Poco::Net::HTTPServerRequest& request,
+                                                       Poco::Net::NameValueCollection& postParams)
+    {
+        if(request.hasContentLength() && request.getContentLength() > (std::streamsize)maxPostBodySize)
+        {
+            return Poco::Net::HTTPResponse::HTTP_REQUESTENTITYTOOLARGE;
+        }
+
+        ofxOAuthFormParser parser(request.getContentType(), maxPostBodySize, postParams);
+
+        std::istream& in = request.stream();
+        char buffer[ofxOAuthFormParser::CHUNK_SIZE];
+
+        while(in.good())
+        {
+            in.read(buffer, sizeof(buffer));
+            std::streamsize n = in.gcount();
+            if(n > 0 && !parser.write(buffer, (std::size_t)n)) break;
+        }
+
+        if(parser.isTooLarge())
+        {
+            return Poco::Net::HTTPResponse::HTTP_REQUESTENTITYTOOLARGE;
+        }
+
+        if(!parser.finish())
+        {
+            ofLogWarning("ofxOAuthAuthReqHandler::readPostParams") << "Malformed " << request.getContentType() << " body.";
+            return Poco::Net::HTTPResponse::HTTP_BAD_REQUEST;
+        }
+
+        return Poco::Net::HTTPResponse::HTTP_OK;
+    }
+
+    void sendStaticFile(const Poco::Net::HTTPServerRequest& request,
+                        Poco::Net::HTTPServerResponse& response,
+                        const ofxOAuthStaticFile& staticFile)
+    {
+        response.setChunkedTransferEncoding(false);
+        response.set("ETag", staticFile.getETag());
+        response.set("Last-Modified", staticFile.getLastModified());
+
+        if(staticFile.isNotModified(request))
+        {
+            response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NOT_MODIFIED);
+            response.send();
+            return;
+        }
+
+        // written straight from the mapping.
+        response.setContentLength(staticFile.getSize());
+        std::ostream& ostr = response.send();
+        ostr.write(staticFile.getData(), staticFile.getSize());
+    }
+
+    void notify(ofxOAuthVerifierCallbackInterface* target,
+                const Poco::Net::HTTPServerRequest& request,
+                const Poco::Net::NameValueCollection& cookies,
+                const Poco::Net::NameValueCollection& queryParams,
+                const Poco::Net::NameValueCollection& postParams)
+    {
+        // send raw request
+        target->receivedVerifierCallbackRequest(request);
+        
+        // send the cookies
+        if(!cookies.empty())
+        {
+            target->receivedVerifierCallbackCookies(cookies);
+        }
+        else
+        {
+            ofLogVerbose("ofxOAuthAuthReqHandler::handleRequest") << "Cookies are empty.";
+        }
+
+        // send the headers
+        if(!request.empty())
+        {
+            target->receivedVerifierCallbackHeaders(request);
+        }
+        else
+        {
+            ofLogVerbose("ofxOAuthAuthReqHandler::handleRequest") << "Headers are empty.";
+        }
+        
+        if(!queryParams.empty())
+        {
+            target->receivedVerifierCallbackGetParams(queryParams);
+        }
+        else
+        {
+            ofLogVerbose("ofxOAuthAuthReqHandler::handleRequest") << "Get Query params are empty.";
+        }
+                
+        if(!postParams.empty())
+        {
+            target->receivedVerifierCallbackPostParams(postParams);
+        }
+        else
+        {
+            ofLogVerbose("ofxOAuthAuthReqHandler::handleRequest") << "Post Query params are empty.";
+        }
+    }
+
     std::string makeHTMLList(const Poco::Net::NameValueCollection& params)
     {
         std::string html;
@@ -254,14 +346,14 @@ protected:
     {
         if(!query.empty())
         {
-            // could use oauth_split_url_parameters here.
             std::vector<std::string> params = ofSplitString(query, "&", true);
             for(int i = 0; i < params.size(); i++)
             {
                 std::vector<std::string> tokens = ofSplitString(params[i], "=");
                 if(tokens.size() == 2)
                 {
-                    returnParams.set(tokens[0], tokens[1]);
+                    returnParams.set(ofxOAuthPercentEncoding::decode(tokens[0]),
+                                     ofxOAuthPercentEncoding::decode(tokens[1]));
                 }
                 else
                 {
@@ -278,9 +370,15 @@ protected:
         return Poco::icompare(s0,s1) == 0;
     }
 
-    ofxOAuthVerifierCallbackInterface* callback;
+    ofxOAuthVerifierCallbackInterface* callback; // may be NULL
+    std::shared_ptr<ofxOAuthVerifierCallbackRouter> router;
 
     std::string docRoot;
+
+    std::shared_ptr<ofxOAuthTemplateCache> templates;
+    std::shared_ptr<ofxOAuthStaticFileCache> files;
+
+    std::size_t maxPostBodySize;
     
 };
 
@@ -289,78 +387,204 @@ class ofxOAuthAuthReqHandlerFactory: public Poco::Net::HTTPRequestHandlerFactory
 {
 public:
     ofxOAuthAuthReqHandlerFactory(ofxOAuthVerifierCallbackInterface* _callback,
-                                  const std::string& _docRoot):
+                                  std::shared_ptr<ofxOAuthVerifierCallbackRouter> _router,
+                                  const std::string& _docRoot,
+                                  std::size_t _maxPostBodySize):
         callback(_callback),
-        docRoot(_docRoot)
+        router(_router),
+        docRoot(_docRoot),
+        templates(new ofxOAuthTemplateCache()),
+        files(new ofxOAuthStaticFileCache()),
+        maxPostBodySize(_maxPostBodySize)
     {
     }
 
     Poco::Net::HTTPRequestHandler* createRequestHandler(const Poco::Net::HTTPServerRequest& request)
     {
-        return new ofxOAuthAuthReqHandler(callback, docRoot); 
+        return new ofxOAuthAuthReqHandler(callback, router, docRoot, templates, files, maxPostBodySize); 
     }
 
 protected:
 
     ofxOAuthVerifierCallbackInterface* callback;
+    std::shared_ptr<ofxOAuthVerifierCallbackRouter> router;
     std::string docRoot;
+    std::shared_ptr<ofxOAuthTemplateCache> templates; // shared by all requests
+    std::shared_ptr<ofxOAuthStaticFileCache> files;
+    std::size_t maxPostBodySize;
 
 };
 
 //------------------------------------------------------------------------------
+// A small http server on 127.0.0.1 that the provider redirects the user's
+// browser to after authorization.
+//
+// start() binds the socket before it returns, so getURL() is right from
+// then on; with no port set, the kernel picks a free one.  The server
+// thread sleeps in select() on the listening socket and a wake-up socket,
+// so stop() returns as soon as the thread has seen the wake-up datagram.
+// Accepted connections are handled by a pool of worker threads.
+//
+// Each redirect goes to the client that registered its oauth_token with
+// addRoute(), or else to the callback given to the constructor, so one
+// server (e.g. getShared()) can serve many authorization flows at once.
 class ofxOAuthVerifierCallbackServer: public ofThread
 {
 public:
+    enum
+    {
+        DEFAULT_NUM_WORKERS = 4,
+
+        // how long a connection may take to send its request.
+        SESSION_TIMEOUT_SECONDS = 5
+    };
+
     ofxOAuthVerifierCallbackServer(ofxOAuthVerifierCallbackInterface* _callback, 
                                    const string& _docRoot = "", 
                                    int _port = -1):
         callback(_callback),
-        docRoot(_docRoot)
+        docRoot(_docRoot),
+        port(_port),
+        numWorkers(DEFAULT_NUM_WORKERS),
+        maxPostBodySize(ofxOAuthFormParser::DEFAULT_MAX_BODY_SIZE),
+        router(new ofxOAuthVerifierCallbackRouter())
+    {
+    }
+
+    // The process-wide server, created on first use.  It has no callback
+    // of its own and serves pages from the default docRoot.
+    static std::shared_ptr<ofxOAuthVerifierCallbackServer> getShared()
     {
-        port = _port <= 0 ? (int)ofRandom(8000,9000) : _port;
+        static ofMutex mutex;
+        static std::shared_ptr<ofxOAuthVerifierCallbackServer> server;
+
+        ofScopedLock lock(mutex);
+
+        if(server == NULL)
+        {
+            server = std::shared_ptr<ofxOAuthVerifierCallbackServer>(new ofxOAuthVerifierCallbackServer(NULL, "VerifierCallbackServer/"));
+            server->setNumWorkers(8);
+        }
+
+        return server;
     }
    
     virtual ~ofxOAuthVerifierCallbackServer()
     {
-        waitForThread(true); // just in case
+        stop();
         ofLogVerbose("ofxOAuthVerifierCallbackServer::~ofxOAuthVerifierCallbackServer") << "Server destroyed.";
-
     }
 
-    void start()
+    // Returns false if the socket could not be bound, e.g. because a port
+    // was set with setPort() and is already in use.
+    bool start()
     {
+        ofScopedLock lock(stateMutex);
+
+        if(isThreadRunning()) return true;
+
+        try
+        {
+            socket = Poco::Net::ServerSocket();
+            socket.bind(Poco::Net::SocketAddress("127.0.0.1", port > 0 ? (Poco::UInt16)port : 0), true);
+            socket.listen();
+            port = socket.address().port();
+
+            wakeSocket = Poco::Net::DatagramSocket(Poco::Net::SocketAddress("127.0.0.1", 0), true);
+        }
+        catch(const Poco::Exception& exc)
+        {
+            ofLogError("ofxOAuthVerifierCallbackServer::start") << "Could not bind the server: " << exc.displayText();
+            socket.close();
+            return false;
+        }
+
+        // all of these params are an attempt to make the server shut down VERY quickly.
+        params = new Poco::Net::HTTPServerParams();
+        params->setKeepAlive(false);
+        params->setMaxKeepAliveRequests(0);
+        params->setKeepAliveTimeout(1);
+        params->setTimeout(Poco::Timespan(SESSION_TIMEOUT_SECONDS, 0));
+        params->setServerName("ofxOAuthVerifierCallbackServer/1.0");
+
+        factory = new ofxOAuthAuthReqHandlerFactory(callback, router, docRoot, maxPostBodySize);
+
+        workers = std::shared_ptr<Poco::ThreadPool>(new Poco::ThreadPool(1, numWorkers));
+
         startThread(true, false);
+
+        ofLogVerbose("ofxOAuthVerifierCallbackServer::start") << "Server started @ " << getURL();
+
+        return true;
     }
 
     void stop()
     {
+        ofScopedLock lock(stateMutex);
+
+        if(!isThreadRunning()) return;
+
         stopThread();
+        wake();
+        waitForThread(false);
+
+        socket.close();
+        wakeSocket.close();
+
+        // connections that never sent a request (e.g. a browser's
+        // speculative preconnects) would hold their worker until the
+        // session timeout, so their reads are ended now.  The requests
+        // that are being handled can still send their responses.
+        {
+            ofScopedLock connectionsLock(connectionsMutex);
+
+            std::set<Worker*>::iterator iter = connections.begin();
+            while(iter != connections.end())
+            {
+                (*iter)->shutdownReceive();
+                ++iter;
+            }
+        }
+
+        workers->joinAll();
+        workers.reset();
+
+        ofLogVerbose("ofxOAuthVerifierCallbackServer::stop") << "Server successfully shut down.";
     }
 
     void threadedFunction()
     {
-        ofLogVerbose("ofxOAuthVerifierCallbackServer::~ofxOAuthVerifierCallbackServer") << "Server starting @ " << getURL();
-        Poco::Net::ServerSocket socket(port);
-        // all of these params are an attempt to make the server shut down VERY quickly.
-        Poco::Net::HTTPServerParams* pParams = new Poco::Net::HTTPServerParams();
-        pParams->setMaxQueued(1);
-        pParams->setMaxThreads(1);
-        pParams->setKeepAlive(false);
-        pParams->setMaxKeepAliveRequests(0);
-        pParams->setKeepAliveTimeout(1);
-        pParams->setServerName("ofxOAuthVerifierCallbackServer/1.0");
-        Poco::ThreadPool babyPool(1,1,1,1);
-        Poco::Net::HTTPServer server(new ofxOAuthAuthReqHandlerFactory(callback, docRoot),
-                                     babyPool,
-                                     socket,
-                                     new Poco::Net::HTTPServerParams());
-        server.start(); // start the http server
-        ofLogVerbose("ofxOAuthVerifierCallbackServer::~ofxOAuthVerifierCallbackServer") << "Server successfully started @ " + getURL();
-        while( isThreadRunning() != 0 ) sleep(250);
-        server.stop(); // stop the http server
-        socket.close();
-        babyPool.joinAll();
-        ofLogVerbose("ofxOAuthVerifierCallbackServer::~ofxOAuthVerifierCallbackServer") << "Server successfully shut down.";
+        while(isThreadRunning())
+        {
+            Poco::Net::Socket::SocketList readList;
+            Poco::Net::Socket::SocketList writeList;
+            Poco::Net::Socket::SocketList exceptList;
+            readList.push_back(socket);
+            readList.push_back(wakeSocket);
+
+            try
+            {
+                // the timeout is only a safety net, stop() wakes us up.
+                Poco::Net::Socket::select(readList, writeList, exceptList, Poco::Timespan(60, 0));
+
+                for(std::size_t i = 0; i < readList.size(); ++i)
+                {
+                    if(readList[i] == wakeSocket)
+                    {
+                        char buffer[16];
+                        wakeSocket.receiveBytes(buffer, sizeof(buffer));
+                    }
+                    else if(readList[i] == socket && isThreadRunning())
+                    {
+                        dispatch(socket.acceptConnection());
+                    }
+                }
+            }
+            catch(const Poco::Exception& exc)
+            {
+                ofLogError("ofxOAuthVerifierCallbackServer::threadedFunction") << exc.displayText();
+            }
+        }
     }
 
     std::string getURL()
@@ -368,11 +592,63 @@ public:
         return "http://127.0.0.1:" + ofToString(port) + "/";
     }
 
+    // Requests for the token go to the callback, until it is removed.
+    void addRoute(const std::string& token, ofxOAuthVerifierCallbackInterface* _callback)
+    {
+        router->add(token, _callback);
+    }
+
+    // Waits for a request for the token that is calling into its callback.
+    void removeRoute(const std::string& token)
+    {
+        router->remove(token);
+    }
+
+    // Removes all of the callback's tokens and waits for any request that
+    // is calling into it.  This visits every route; removeRoute() is
+    // cheaper when the token is known.
+    void removeRoutes(ofxOAuthVerifierCallbackInterface* _callback)
+    {
+        router->remove(_callback);
+    }
+
+    std::size_t getNumRoutes()
+    {
+        return router->size();
+    }
+
+    // The most connections handled at once (DEFAULT_NUM_WORKERS by
+    // default); more are answered with a 503.  Only has an effect before
+    // start().
+    void setNumWorkers(int n)
+    {
+        numWorkers = std::max(1, n);
+    }
+
+    int getNumWorkers() const
+    {
+        return numWorkers;
+    }
+
+    // Larger form bodies are answered with 413.  Only has an effect
+    // before start().
+    void setMaxPostBodySize(std::size_t n)
+    {
+        maxPostBodySize = n;
+    }
+
+    std::size_t getMaxPostBodySize() const
+    {
+        return maxPostBodySize;
+    }
+
+    // The bound port once start() has succeeded.
     int getPort()
     {
         return port;
     }
 
+    // Only has an effect before start().
     void setPort(int _port)
     {
         port = _port;
@@ -384,7 +660,125 @@ public:
     }
     
 protected:
-    ofxOAuthVerifierCallbackInterface* callback;
-    int port;
+    // Runs one connection on a worker and then deletes itself.  It is
+    // listed in the server's connections while it exists.
+    class Worker: public Poco::Runnable
+    {
+    public:
+        Worker(ofxOAuthVerifierCallbackServer& _server,
+               const Poco::Net::StreamSocket& _socket,
+               Poco::Net::HTTPServerParams::Ptr params,
+               Poco::Net::HTTPRequestHandlerFactory::Ptr factory):
+            server(_server),
+            socket(_socket),
+            connection(_socket, params, factory)
+        {
+            ofScopedLock lock(server.connectionsMutex);
+            server.connections.insert(this);
+        }
+
+        virtual ~Worker()
+        {
+            ofScopedLock lock(server.connectionsMutex);
+            server.connections.erase(this);
+        }
+
+        // Called with the server's connectionsMutex held.
+        void shutdownReceive()
+        {
+            try
+            {
+                socket.shutdownReceive();
+            }
+            catch(const Poco::Exception&)
+            {
+                // already closed.
+            }
+        }
+
+        void run()
+        {
+            try
+            {
+                connection.run();
+            }
+            catch(const Poco::Exception& exc)
+            {
+                ofLogError("ofxOAuthVerifierCallbackServer::Worker::run") << exc.displayText();
+            }
+
+            delete this;
+        }
+
+    private:
+        ofxOAuthVerifierCallbackServer& server;
+        Poco::Net::StreamSocket socket; // shares the connection's socket
+        Poco::Net::HTTPServerConnection connection;
+    };
+
+    void dispatch(const Poco::Net::StreamSocket& client)
+    {
+        Worker* worker = new Worker(*this, client, params, factory);
+
+        try
+        {
+            workers->start(*worker);
+        }
+        catch(const Poco::NoThreadAvailableException&)
+        {
+            // all workers are busy.  The accepting thread never handles a
+            // connection itself, as it could be held up for the whole
+            // session timeout, so the client is told to try again.
+            delete worker;
+            refuse(client);
+        }
+    }
+
+    static void refuse(Poco::Net::StreamSocket client)
+    {
+        static const char reply[] = "HTTP/1.1 503 Service Unavailable\r\n"
+                                    "Retry-After: 1\r\n"
+                                    "Content-Length: 0\r\n"
+                                    "Connection: close\r\n\r\n";
+
+        try
+        {
+            client.sendBytes(reply, sizeof(reply) - 1);
+            client.close();
+        }
+        catch(const Poco::Exception& exc)
+        {
+            ofLogVerbose("ofxOAuthVerifierCallbackServer::refuse") << exc.displayText();
+        }
+    }
+
+    void wake()
+    {
+        try
+        {
+            wakeSocket.sendTo("x", 1, wakeSocket.address());
+        }
+        catch(const Poco::Exception& exc)
+        {
+            ofLogError("ofxOAuthVerifierCallbackServer::wake") << exc.displayText();
+        }
+    }
+
+    ofxOAuthVerifierCallbackInterface* callback; // for requests without a route, may be NULL
     string docRoot;
+    int port;
+    int numWorkers;
+    std::size_t maxPostBodySize;
+
+    std::shared_ptr<ofxOAuthVerifierCallbackRouter> router;
+    std::shared_ptr<Poco::ThreadPool> workers;
+    ofMutex stateMutex; // start() / stop()
+
+    std::set<Worker*> connections; // the workers' open connections
+    ofMutex connectionsMutex;
+
+    Poco::Net::ServerSocket socket;
+    Poco::Net::DatagramSocket wakeSocket; // stop() sends a datagram to itself to end the select()
+    Poco::Net::HTTPServerParams::Ptr params;
+    Poco::Net::HTTPRequestHandlerFactory::Ptr factory;
 };
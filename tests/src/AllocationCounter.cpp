@@ -0,0 +1,169 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+#include "Poco/AtomicCounter.h"
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#endif
+
+#if defined(__linux__)
+#include <stdio.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#endif
+
+
+// Static constructors may allocate before these are constructed (which
+// zeroes them), so only compare two readings taken after main() started.
+static Poco::AtomicCounter numAllocations;
+static Poco::AtomicCounter numFrees;
+
+// Poco::AtomicCounter is an int and can only count by one.
+#if defined(_MSC_VER)
+static volatile LONGLONG numBytesAllocated;
+#else
+static volatile long long numBytesAllocated;
+#endif
+
+
+static long long addBytesAllocated(long long size)
+{
+#if defined(_MSC_VER)
+    return InterlockedExchangeAdd64(&numBytesAllocated, size);
+#else
+    return __sync_fetch_and_add(&numBytesAllocated, size);
+#endif
+}
+
+
+#if __cplusplus >= 201103L
+void* operator new(std::size_t size)
+#else
+void* operator new(std::size_t size) throw(std::bad_alloc)
+#endif
+{
+    ++numAllocations;
+    addBytesAllocated((long long)size);
+
+    void* p = std::malloc(size > 0 ? size : 1);
+    if(p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+
+#if __cplusplus >= 201103L
+void operator delete(void* p) noexcept
+#else
+void operator delete(void* p) throw()
+#endif
+{
+    if(p == NULL) return;
+
+    ++numFrees;
+    std::free(p);
+}
+
+
+//------------------------------------------------------------------------------
+long AllocationCounter::getNumAllocations()
+{
+    return numAllocations.value();
+}
+
+//------------------------------------------------------------------------------
+long AllocationCounter::getNumLive()
+{
+    return numAllocations.value() - numFrees.value();
+}
+
+//------------------------------------------------------------------------------
+unsigned long long AllocationCounter::getNumBytesAllocated()
+{
+    return (unsigned long long)addBytesAllocated(0);
+}
+
+//------------------------------------------------------------------------------
+std::size_t AllocationCounter::getResidentBytes()
+{
+#if defined(__linux__)
+    // the second field of statm is the resident set, in pages.
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if(statm == NULL) return 0;
+
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    int numRead = fscanf(statm, "%lu %lu", &size, &resident);
+    fclose(statm);
+
+    return numRead == 2 ? (std::size_t)resident * (std::size_t)sysconf(_SC_PAGESIZE) : 0;
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+    if(task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+    {
+        return 0;
+    }
+
+    return (std::size_t)info.resident_size;
+#else
+    return 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+std::size_t AllocationCounter::getPeakResidentBytes()
+{
+#if defined(__linux__)
+    FILE* status = fopen("/proc/self/status", "r");
+    if(status == NULL) return 0;
+
+    char line[256];
+    unsigned long peak = 0;
+
+    while(fgets(line, sizeof(line), status) != NULL)
+    {
+        if(sscanf(line, "VmHWM: %lu kB", &peak) == 1) break;
+    }
+
+    fclose(status);
+
+    return (std::size_t)peak * 1024;
+#elif defined(__APPLE__)
+    // ru_maxrss is in bytes on macOS.
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return (std::size_t)usage.ru_maxrss;
+#else
+    return 0;
+#endif
+}
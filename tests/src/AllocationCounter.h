@@ -0,0 +1,56 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <cstddef>
+
+
+//------------------------------------------------------------------------------
+// Counts the allocations made through the global operator new, which the
+// tests app replaces (see AllocationCounter.cpp), and measures the resident
+// set size of the process.  The counts are only meaningful as the
+// difference between two readings.
+class AllocationCounter
+{
+public:
+    // every allocation made so far.
+    static long getNumAllocations();
+
+    // the allocations made so far that have not been freed.
+    static long getNumLive();
+
+    // the bytes asked for by every allocation made so far.
+    static unsigned long long getNumBytesAllocated();
+
+    // the resident set size in bytes, 0 where it can't be measured.
+    static std::size_t getResidentBytes();
+
+    // the largest the resident set has been, 0 where it can't be measured.
+    static std::size_t getPeakResidentBytes();
+
+};
@@ -0,0 +1,94 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include "ofxOAuth.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Remembers whether it was called back, and on which thread.
+class ThreadRecorder: public ofxOAuthRequestListener
+{
+public:
+    ThreadRecorder():
+        called(false),
+        calledOnMainThread(false)
+    {
+    }
+
+    void requestCompleted(const ofxOAuthTransportResult& _result)
+    {
+        ofScopedLock lock(mutex);
+        called = true;
+        calledOnMainThread = ofThread::isMainThread();
+        result = _result;
+    }
+
+    bool called;
+    bool calledOnMainThread;
+    ofxOAuthTransportResult result;
+    ofMutex mutex;
+
+};
+
+
+//------------------------------------------------------------------------------
+class AsyncTransportTests: public TestSuite
+{
+public:
+    AsyncTransportTests():
+        TestSuite("AsyncTransportTests")
+    {
+    }
+
+protected:
+    void run()
+    {
+        testFailsOnTheEventLoop();
+    }
+
+    void testFailsOnTheEventLoop()
+    {
+        begin("calls back a request that can't be signed on the event loop");
+
+        // no api url, so nothing can be signed.
+        ofxOAuth client;
+
+        ThreadRecorder recorder;
+        ofxOAuthAsyncResult result = client.getAsync("/resource", "", &recorder);
+        result.wait();
+
+        ofScopedLock lock(recorder.mutex);
+        TEST_CHECK(recorder.called);
+        TEST_CHECK(!recorder.calledOnMainThread);
+        TEST_CHECK(recorder.result.curlCode == CURLE_FAILED_INIT);
+        TEST_CHECK(result.data().curlCode == CURLE_FAILED_INIT);
+    }
+
+};
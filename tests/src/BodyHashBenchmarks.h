@@ -0,0 +1,183 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <fstream>
+#include "ofxOAuthMultipartBody.h"
+#include "ofxOAuthSigner.h"
+#include "AllocationCounter.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Compares the chunked body hash of an upload (ofxOAuthSigner::
+// computeBodyHash) with reading the whole body into memory and hashing
+// that, as oauth_body_hash_file did, for files of 100 MB to 4 GB.  The
+// files are sparse where the file system allows it, so they take no disk
+// space, but they are read like any other.  The whole-body hash is only
+// run up to MAX_BUFFERED_BYTES, as it needs that much memory.
+class BodyHashBenchmarks: public TestSuite
+{
+public:
+    enum
+    {
+        MAX_BUFFERED_BYTES = 1024 * 1024 * 1024,
+
+        // the chunked hash needs a chunk, not the body.
+        MAX_CHUNKED_PEAK_GROWTH = 16 * 1024 * 1024
+    };
+
+    BodyHashBenchmarks():
+        TestSuite("BodyHashBenchmarks")
+    {
+        sizes.push_back(100ULL * 1024 * 1024);
+        sizes.push_back(1024ULL * 1024 * 1024);
+        sizes.push_back(4096ULL * 1024 * 1024);
+    }
+
+protected:
+    void run()
+    {
+        // the same bodies (and so boundaries) for both, so the hashes match.
+        std::vector<std::shared_ptr<ofxOAuthMultipartBody> > bodies;
+
+        for(std::size_t i = 0; i < sizes.size(); ++i)
+        {
+            bodies.push_back(std::shared_ptr<ofxOAuthMultipartBody>(new ofxOAuthMultipartBody()));
+            TEST_CHECK(makeFile(sizes[i]) && bodies[i]->addFile("media", getFileName(sizes[i])));
+        }
+
+        // the peak resident set only ever grows, so every chunked hash is
+        // measured before the first whole-body one.
+        std::vector<std::string> hashes;
+
+        for(std::size_t i = 0; i < sizes.size(); ++i)
+        {
+            hashes.push_back(benchmarkChunked(*bodies[i]));
+        }
+
+        for(std::size_t i = 0; i < sizes.size(); ++i)
+        {
+            if(sizes[i] <= MAX_BUFFERED_BYTES)
+            {
+                benchmarkBuffered(*bodies[i], hashes[i]);
+            }
+            else
+            {
+                ofLogNotice(name) << "whole body hash, " << sizes[i] / (1024 * 1024) << " MB: skipped, it would need as much memory.";
+            }
+        }
+
+        for(std::size_t i = 0; i < sizes.size(); ++i)
+        {
+            ofFile::removeFile(getFileName(sizes[i]), false);
+        }
+    }
+
+    std::string getFileName(uint64_t size) const
+    {
+        return ofToDataPath("BodyHashBenchmarks-" + ofToString(size) + ".bin", true);
+    }
+
+    // A file of size zeros, sparse where the file system allows it.
+    bool makeFile(uint64_t size)
+    {
+        std::ofstream out(getFileName(size).c_str(), std::ios::binary | std::ios::trunc);
+        out.seekp((std::streamoff)(size - 1));
+        out.put('\0');
+        return (bool)out;
+    }
+
+    std::string benchmarkChunked(ofxOAuthMultipartBody& body)
+    {
+        uint64_t size = body.getSize();
+
+        begin("chunked hash, " + ofToString(size / (1024 * 1024)) + " MB");
+
+        std::string hash;
+
+        std::size_t peakBefore = AllocationCounter::getPeakResidentBytes();
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        TEST_CHECK(ofxOAuthSigner::computeBodyHash(body, hash));
+
+        unsigned long long elapsedMillis = std::max(1ULL, ofGetElapsedTimeMillis() - startTime);
+        std::size_t peakGrowth = AllocationCounter::getPeakResidentBytes() - peakBefore;
+
+        ofLogNotice(name) << elapsedMillis << " ms (" << size / 1024 * 1000 / elapsedMillis / 1024 << " MB/s), peak resident set grew "
+                          << peakGrowth / 1024 << " KB.";
+
+        TEST_CHECK(peakGrowth <= MAX_CHUNKED_PEAK_GROWTH);
+
+        return hash;
+    }
+
+    void benchmarkBuffered(ofxOAuthMultipartBody& body, const std::string& chunkedHash)
+    {
+        uint64_t size = body.getSize();
+
+        begin("whole body hash, " + ofToString(size / (1024 * 1024)) + " MB");
+
+        std::size_t peakBefore = AllocationCounter::getPeakResidentBytes();
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        std::string hash;
+
+        {
+            std::vector<char> buffer((std::size_t)body.getSize());
+            std::size_t total = 0;
+
+            body.rewind();
+
+            while(total < buffer.size())
+            {
+                std::size_t n = body.read(&buffer[total], buffer.size() - total);
+                if(n == 0 || n == CURL_READFUNC_ABORT) break;
+                total += n;
+            }
+
+            ofxOAuthSHA1 sha;
+            sha.update(&buffer[0], total);
+
+            unsigned char digest[ofxOAuthSHA1::DIGEST_SIZE];
+            sha.finish(digest);
+            hash = ofxOAuthSigner::encodeBase64(digest, sizeof(digest));
+        }
+
+        unsigned long long elapsedMillis = std::max(1ULL, ofGetElapsedTimeMillis() - startTime);
+        std::size_t peakGrowth = AllocationCounter::getPeakResidentBytes() - peakBefore;
+
+        ofLogNotice(name) << elapsedMillis << " ms (" << size / 1024 * 1000 / elapsedMillis / 1024 << " MB/s), peak resident set grew "
+                          << peakGrowth / 1024 << " KB.";
+
+        TEST_CHECK(hash == chunkedHash);
+    }
+
+    std::vector<uint64_t> sizes;
+
+};
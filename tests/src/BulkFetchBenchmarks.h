@@ -0,0 +1,182 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include "ofxOAuth.h"
+#include "ofxOAuthBulkFetch.h"
+#include "StandInServer.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Answers every request with its own uri, query included.
+class UriEchoApi: public StandInHandler
+{
+public:
+    void handle(Poco::Net::HTTPServerRequest& request,
+                Poco::Net::HTTPServerResponse& response)
+    {
+        response.setContentType("text/plain");
+        response.send() << request.getURI();
+    }
+
+};
+
+
+//------------------------------------------------------------------------------
+// Checks that ofxOAuthBulkFetch signs items added as parameters and leaves
+// the transport's idle handle limit as it found it, then counts the
+// requests per second a bulk fetch gets through with 1 to 256 of them in
+// flight.
+class BulkFetchBenchmarks: public TestSuite
+{
+public:
+    enum
+    {
+        NUM_ITEMS = 4000,
+        MAX_CONCURRENT = 256
+    };
+
+    BulkFetchBenchmarks():
+        TestSuite("BulkFetchBenchmarks")
+    {
+    }
+
+protected:
+    void run()
+    {
+        UriEchoApi api;
+
+        // a thread per connection in flight, with some to spare.
+        StandInServer server(api, MAX_CONCURRENT + 16);
+
+        testAddsParams(server);
+        testKeepsTheIdleHandleLimit(server);
+
+        static const std::size_t concurrencies[] = { 1, 8, 64, MAX_CONCURRENT };
+
+        for(std::size_t i = 0; i < sizeof(concurrencies) / sizeof(concurrencies[0]); ++i)
+        {
+            benchmark(server, concurrencies[i]);
+        }
+    }
+
+    void testAddsParams(StandInServer& server)
+    {
+        begin("items can be added as parameters");
+
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+
+        ofxOAuthParams params;
+        params.add("q", "a b");
+
+        ofxOAuthBulkFetch bulk(client, 2);
+        bulk.add("/params", params);
+        bulk.add("/query", "q=a%20b");
+        bulk.start();
+
+        ofxOAuthBulkResult result;
+        int numOk = 0;
+
+        while(bulk.next(result, 5000))
+        {
+            TEST_CHECK(result.isOk());
+            TEST_CHECK(result.result.body == result.uri + "?q=a%20b");
+            if(result.isOk()) numOk++;
+        }
+
+        TEST_CHECK(numOk == 2);
+    }
+
+    void testKeepsTheIdleHandleLimit(StandInServer& server)
+    {
+        begin("the idle handle limit is kept");
+
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+
+        std::size_t limit = client.getTransport()->getMaxIdleHandlesPerHost();
+
+        {
+            ofxOAuthBulkFetch bulk(client, 32);
+            for(int i = 0; i < 64; ++i) bulk.add("/item");
+            bulk.start();
+
+            ofxOAuthBulkResult result;
+            while(bulk.next(result, 5000));
+
+            TEST_CHECK(bulk.isDone());
+            TEST_CHECK(client.getTransport()->getMaxIdleHandlesPerHost() == limit);
+        }
+
+        // a fetch that never completes gives its reservation back as well.
+        {
+            ofxOAuthBulkFetch bulk(client, 32);
+            for(int i = 0; i < 64; ++i) bulk.add("/item");
+            bulk.start();
+        }
+
+        TEST_CHECK(client.getTransport()->getMaxIdleHandlesPerHost() == limit);
+    }
+
+    void benchmark(StandInServer& server, std::size_t maxConcurrent)
+    {
+        begin("benchmark " + ofToString(maxConcurrent) + " in flight");
+
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+
+        ofxOAuthBulkFetch bulk(client, maxConcurrent);
+
+        for(int i = 0; i < NUM_ITEMS; ++i)
+        {
+            bulk.add("/item", "i=" + ofToString(i));
+        }
+
+        unsigned long long startTime = ofGetElapsedTimeMicros();
+
+        bulk.start();
+
+        ofxOAuthBulkResult result;
+        int numOk = 0;
+
+        while(bulk.next(result, 30000))
+        {
+            if(result.isOk()) numOk++;
+        }
+
+        double seconds = (ofGetElapsedTimeMicros() - startTime) / 1000000.0;
+
+        ofLogNotice(name) << maxConcurrent << " in flight: " << NUM_ITEMS / seconds
+                          << " requests per second, " << bulk.getNumFailed() << " failed.";
+
+        TEST_CHECK(numOk == NUM_ITEMS);
+    }
+
+};
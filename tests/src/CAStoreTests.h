@@ -0,0 +1,149 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include "ofxOAuthTransport.h"
+#include "StandInTLSServer.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Checks that certificates are verified against a shared, parsed bundle and
+// times full handshakes with it against curl loading the bundle from its
+// path (CURLOPT_CAINFO) for every connection.  The bundle is the one the
+// examples ship with, plus the stand-in's certificate.
+class CAStoreTests: public TestSuite
+{
+public:
+    CAStoreTests():
+        TestSuite("CAStoreTests")
+    {
+    }
+
+protected:
+    enum
+    {
+        NUM_HANDSHAKES = 100
+    };
+
+    void run()
+    {
+        bundlePath = ofToDataPath("cacert-localhost.pem", true);
+
+        StandInTLSServer server(ofToDataPath("localhost.pem", true),
+                                ofToDataPath("localhost.key", true));
+
+        testSharesParsedBundles();
+        testVerifiesAgainstTheBundle(server);
+        testBenchmarkHandshakes(server);
+    }
+
+    void testSharesParsedBundles()
+    {
+        begin("shares parsed bundles");
+
+        ofxOAuthCAStore::Ptr store = ofxOAuthCAStore::get(bundlePath);
+
+        TEST_CHECK(ofxOAuthCAStore::get(bundlePath) == store);
+
+        ofLogNotice(name) << "curl " << curl_version_info(CURLVERSION_NOW)->ssl_version
+                          << (store->isParsed() ? ": the bundle is parsed once." : ": the bundle is loaded by each connection.");
+    }
+
+    void testVerifiesAgainstTheBundle(StandInTLSServer& server)
+    {
+        begin("verifies against the bundle");
+
+        ofxOAuthTransport transport;
+        ofxOAuthTransportResult result;
+
+        transport.setCACertificateFile(bundlePath);
+        TEST_CHECK(transport.get(server.getURL() + "/", "", result));
+        TEST_CHECK(result.status == 200);
+
+        // a bundle without the stand-in's certificate.
+        transport.setCACertificateFile(ofToDataPath("other.pem", true));
+        TEST_CHECK(!transport.get(server.getURL() + "/", "", result));
+    }
+
+    void testBenchmarkHandshakes(StandInTLSServer& server)
+    {
+        begin("benchmark handshakes");
+
+        ofxOAuthCAStore::Ptr store = ofxOAuthCAStore::get(bundlePath);
+
+        double pathMillis = timeHandshakes(server, store, false);
+        double storeMillis = timeHandshakes(server, store, true);
+
+        ofLogNotice(name) << NUM_HANDSHAKES << " handshakes, CURLOPT_CAINFO: " << pathMillis << " ms each, shared store: " << storeMillis << " ms each";
+
+        TEST_CHECK(pathMillis > 0 && storeMillis > 0);
+
+        if(store->isParsed())
+        {
+            TEST_CHECK(storeMillis < pathMillis);
+        }
+    }
+
+    // The mean time of a request on a fresh connection, or -1 if any failed.
+    double timeHandshakes(StandInTLSServer& server, ofxOAuthCAStore::Ptr store, bool useStore)
+    {
+        unsigned long long startTime = ofGetElapsedTimeMicros();
+
+        for(int i = 0; i < NUM_HANDSHAKES; ++i)
+        {
+            CURL* handle = curl_easy_init();
+            curl_easy_setopt(handle, CURLOPT_URL, (server.getURL() + "/").c_str());
+            curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, &CAStoreTests::discard);
+            curl_easy_setopt(handle, CURLOPT_FORBID_REUSE, 1L);
+
+            if(useStore)
+            {
+                store->configure(handle);
+            }
+            else
+            {
+                curl_easy_setopt(handle, CURLOPT_CAINFO, bundlePath.c_str());
+            }
+
+            CURLcode code = curl_easy_perform(handle);
+            curl_easy_cleanup(handle);
+
+            if(!TEST_CHECK(code == CURLE_OK)) return -1;
+        }
+
+        return (ofGetElapsedTimeMicros() - startTime) / 1000.0 / NUM_HANDSHAKES;
+    }
+
+    static std::size_t discard(char*, std::size_t size, std::size_t count, void*)
+    {
+        return size * count;
+    }
+
+    std::string bundlePath;
+
+};
@@ -0,0 +1,225 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include "ofxOAuth.h"
+#include "StandInServer.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Stands in for an api with large, compressible json answers.  Remembers
+// the Accept-Encoding of the last request.
+//
+//   /gzip    gzip compressed when the request offers it, plain otherwise
+//   /plain   always plain
+class CompressibleApi: public StandInHandler
+{
+public:
+    CompressibleApi()
+    {
+        body = "[";
+
+        for(int i = 0; i < 1000; ++i)
+        {
+            body += (i > 0 ? "," : "");
+            body += "{\"id\":" + ofToString(i) + ",\"text\":\"a status update\",\"user\":\"someone\"}";
+        }
+
+        body += "]";
+    }
+
+    void handle(Poco::Net::HTTPServerRequest& request,
+                Poco::Net::HTTPServerResponse& response)
+    {
+        {
+            ofScopedLock lock(mutex);
+            lastAcceptEncoding = request.get("Accept-Encoding", "");
+        }
+
+        response.setContentType("application/json");
+
+        if(request.getURI() == "/gzip")
+        {
+            sendBody(request, response, body);
+        }
+        else
+        {
+            response.sendBuffer(body.data(), body.size());
+        }
+    }
+
+    std::string getLastAcceptEncoding()
+    {
+        ofScopedLock lock(mutex);
+        return lastAcceptEncoding;
+    }
+
+    std::string body;
+
+protected:
+    std::string lastAcceptEncoding;
+
+    ofMutex mutex;
+
+};
+
+
+//------------------------------------------------------------------------------
+class CompressionTests: public TestSuite
+{
+public:
+    CompressionTests():
+        TestSuite("CompressionTests")
+    {
+    }
+
+protected:
+    void run()
+    {
+        testInflatesCompressedBodies();
+        testCountsPlainBodies();
+        testClientSwitch();
+        testPerRequestSwitch();
+    }
+
+    static std::string toString(const ofxOAuthResponse& response)
+    {
+        return std::string(response.data(), response.size());
+    }
+
+    void testInflatesCompressedBodies()
+    {
+        begin("inflates compressed bodies");
+
+        CompressibleApi api;
+        StandInServer server(api);
+
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+
+        TEST_CHECK(toString(client.getResponse("/gzip")) == api.body);
+        TEST_CHECK(client.get("/gzip") == api.body);
+        TEST_CHECK(api.getLastAcceptEncoding().find("gzip") != std::string::npos);
+
+        ofxOAuthTransportStats stats = client.getTransport()->getStats();
+
+        TEST_CHECK(stats.numResponses == 2);
+        TEST_CHECK(stats.numCompressedResponses == 2);
+        TEST_CHECK(stats.bytesDecoded == 2 * api.body.size());
+        TEST_CHECK(stats.bytesReceived < stats.bytesDecoded);
+        TEST_CHECK(stats.getBytesSaved() == stats.bytesDecoded - stats.bytesReceived);
+
+        ofLogNotice(name) << stats.bytesReceived << " bytes received for "
+                          << stats.bytesDecoded << " bytes decoded.";
+
+        client.getTransport()->resetStats();
+        TEST_CHECK(client.getTransport()->getStats().numResponses == 0);
+        TEST_CHECK(client.getTransport()->getStats().getBytesSaved() == 0);
+    }
+
+    void testCountsPlainBodies()
+    {
+        begin("counts plain bodies");
+
+        CompressibleApi api;
+        StandInServer server(api);
+
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+
+        TEST_CHECK(client.get("/plain") == api.body);
+
+        ofxOAuthTransportStats stats = client.getTransport()->getStats();
+
+        TEST_CHECK(stats.numResponses == 1);
+        TEST_CHECK(stats.numCompressedResponses == 0);
+        TEST_CHECK(stats.bytesReceived == api.body.size());
+        TEST_CHECK(stats.bytesDecoded == api.body.size());
+        TEST_CHECK(stats.getBytesSaved() == 0);
+    }
+
+    void testClientSwitch()
+    {
+        begin("setAcceptCompression(false) asks for plain bodies");
+
+        CompressibleApi api;
+        StandInServer server(api);
+
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+        client.setAcceptCompression(false);
+
+        TEST_CHECK(!client.isAcceptCompression());
+        TEST_CHECK(client.get("/gzip") == api.body);
+        TEST_CHECK(api.getLastAcceptEncoding().empty());
+
+        ofxOAuthTransportStats stats = client.getTransport()->getStats();
+
+        TEST_CHECK(stats.numCompressedResponses == 0);
+        TEST_CHECK(stats.getBytesSaved() == 0);
+
+        client.setAcceptCompression(true);
+
+        TEST_CHECK(client.get("/gzip") == api.body);
+        TEST_CHECK(client.getTransport()->getStats().numCompressedResponses == 1);
+    }
+
+    void testPerRequestSwitch()
+    {
+        begin("the switch applies per request");
+
+        CompressibleApi api;
+        StandInServer server(api);
+
+        ofxOAuthTransport transport;
+
+        for(int i = 0; i < 4; ++i)
+        {
+            bool compressed = (i % 2 == 0);
+
+            ofxOAuthTransportRequest request;
+            request.method = "GET";
+            request.url = server.getURL() + "/gzip";
+            request.acceptCompression = compressed;
+
+            ofxOAuthTransportResult result;
+            TEST_CHECK(transport.perform(request, result) && result.status == 200);
+            TEST_CHECK(result.body == api.body);
+            TEST_CHECK(api.getLastAcceptEncoding().empty() != compressed);
+        }
+
+        ofxOAuthTransportStats stats = transport.getStats();
+
+        TEST_CHECK(stats.numResponses == 4);
+        TEST_CHECK(stats.numCompressedResponses == 2);
+        TEST_CHECK(stats.bytesDecoded == 4 * api.body.size());
+        TEST_CHECK(stats.getBytesSaved() > 0);
+    }
+
+};
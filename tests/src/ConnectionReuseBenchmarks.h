@@ -0,0 +1,95 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include "ofxOAuthTransport.h"
+#include "StandInTLSServer.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Times https GETs through a transport that keeps its
+// curl handles (and so their keep-alive connections) between calls, against
+// one that makes a fresh handle for every call, as oauth_http_get2 did, and
+// so pays for a TCP connect and a full TLS handshake each time.
+class ConnectionReuseBenchmarks: public TestSuite
+{
+public:
+    ConnectionReuseBenchmarks():
+        TestSuite("ConnectionReuseBenchmarks")
+    {
+    }
+
+protected:
+    enum
+    {
+        NUM_REQUESTS = 200
+    };
+
+    void run()
+    {
+        StandInTLSServer server(ofToDataPath("localhost.pem", true),
+                                ofToDataPath("localhost.key", true),
+                                true);
+
+        begin("benchmark pooled and fresh handles");
+
+        double freshMillis = timeRequests(server, 0);
+        double pooledMillis = timeRequests(server, 1);
+
+        ofLogNotice(name) << NUM_REQUESTS << " requests, fresh handle per call: " << freshMillis
+                          << " ms each, pooled handle: " << pooledMillis << " ms each";
+
+        TEST_CHECK(freshMillis > 0 && pooledMillis > 0);
+        TEST_CHECK(pooledMillis < freshMillis);
+    }
+
+    // The mean time of a request, or -1 if any failed.  The transport, and
+    // with it the connections the server is serving, is closed on return.
+    double timeRequests(StandInTLSServer& server, std::size_t maxIdleHandlesPerHost)
+    {
+        ofxOAuthTransport transport;
+        transport.setCACertificateFile(ofToDataPath("cacert-localhost.pem", true));
+        transport.setMaxIdleHandlesPerHost(maxIdleHandlesPerHost);
+
+        ofxOAuthTransportResult result;
+
+        // the first request is not timed, it makes the pooled connection.
+        if(!TEST_CHECK(transport.get(server.getURL() + "/", "", result))) return -1;
+
+        unsigned long long startTime = ofGetElapsedTimeMicros();
+
+        for(int i = 0; i < NUM_REQUESTS; ++i)
+        {
+            if(!TEST_CHECK(transport.get(server.getURL() + "/resource?a=" + ofToString(i), "", result) && result.body == "ok")) return -1;
+        }
+
+        return (ofGetElapsedTimeMicros() - startTime) / 1000.0 / NUM_REQUESTS;
+    }
+
+};
@@ -0,0 +1,349 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <cstdlib>
+#include "ofxOAuthFormParser.h"
+#include "ofxOAuthTransport.h"
+#include "ofxOAuthVerifierCallbackServer.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Remembers the form fields the callback server hands over.
+class PostParamsRecorder: public ofxOAuthVerifierCallbackInterface
+{
+public:
+    void setRequestTokenVerifier(const std::string&, const std::string&) {}
+    void receivedVerifierCallbackRequest(const Poco::Net::HTTPServerRequest&) {}
+    void receivedVerifierCallbackHeaders(const Poco::Net::NameValueCollection&) {}
+    void receivedVerifierCallbackCookies(const Poco::Net::NameValueCollection&) {}
+    void receivedVerifierCallbackGetParams(const Poco::Net::NameValueCollection&) {}
+
+    void receivedVerifierCallbackPostParams(const Poco::Net::NameValueCollection& postParams)
+    {
+        ofScopedLock lock(mutex);
+        params = postParams;
+    }
+
+    Poco::Net::NameValueCollection getParams()
+    {
+        ofScopedLock lock(mutex);
+        return params;
+    }
+
+    void clear()
+    {
+        ofScopedLock lock(mutex);
+        params.clear();
+    }
+
+protected:
+    Poco::Net::NameValueCollection params;
+    ofMutex mutex;
+
+};
+
+
+//------------------------------------------------------------------------------
+class FormParserTests: public TestSuite
+{
+public:
+    FormParserTests():
+        TestSuite("FormParserTests")
+    {
+    }
+
+protected:
+    enum
+    {
+        NUM_SPLITS = 100
+    };
+
+    void run()
+    {
+        testURLEncodedInPieces();
+        testMultipartInPieces();
+        testBoundarySplitAcrossWrites();
+        testPartWithoutHeaders();
+        testSkipsFileParts();
+        testTruncatedBody();
+        testTooLargeBody();
+        testVerifierCallbackServerPosts();
+    }
+
+    static std::string multipartType()
+    {
+        return "multipart/form-data; boundary=XyZzy";
+    }
+
+    // name=value fields, a file and the closing boundary.
+    static std::string multipartBody(const std::string& fileData = "file contents")
+    {
+        return "preamble\r\n"
+               "--XyZzy\r\n"
+               "Content-Disposition: form-data; name=\"oauth_token\"\r\n"
+               "\r\n"
+               "token\r\n"
+               "--XyZzy\r\n"
+               "Content-Disposition: form-data; name=\"upload\"; filename=\"a.txt\"\r\n"
+               "Content-Type: text/plain\r\n"
+               "\r\n" +
+               fileData + "\r\n"
+               "--XyZzy  \r\n"
+               "content-disposition: form-data; name=\"oauth_verifier\"\r\n"
+               "\r\n"
+               "line one\r\nline two\r\n"
+               "--XyZzy--\r\n"
+               "epilogue";
+    }
+
+    // Feeds body in pieces of 1 to 7 bytes.  Returns what finish() returns.
+    static bool parseInPieces(const std::string& contentType,
+                              const std::string& body,
+                              unsigned int seed,
+                              Poco::Net::NameValueCollection& params)
+    {
+        ofxOAuthFormParser parser(contentType, ofxOAuthFormParser::DEFAULT_MAX_BODY_SIZE, params);
+
+        std::srand(seed);
+
+        std::size_t start = 0;
+        while(start < body.size())
+        {
+            std::size_t n = std::min(body.size() - start, (std::size_t)(1 + std::rand() % 7));
+            if(!parser.write(body.data() + start, n)) return false;
+            start += n;
+        }
+
+        return parser.finish();
+    }
+
+    void testURLEncodedInPieces()
+    {
+        begin("url encoded bodies in pieces");
+
+        std::string body = "oauth_token=token&oauth_verifier=hello%20world&empty=&flag&amp=%26%3D&&plus=a+b";
+
+        for(unsigned int seed = 0; seed < NUM_SPLITS; ++seed)
+        {
+            Poco::Net::NameValueCollection params;
+            TEST_CHECK(parseInPieces("application/x-www-form-urlencoded", body, seed, params));
+            TEST_CHECK(params.size() == 6);
+            TEST_CHECK(params.get("oauth_token", "") == "token");
+            TEST_CHECK(params.get("oauth_verifier", "") == "hello world");
+            TEST_CHECK(params.has("empty") && params.get("empty") == "");
+            TEST_CHECK(params.has("flag") && params.get("flag") == "");
+            TEST_CHECK(params.get("amp", "") == "&=");
+            TEST_CHECK(params.has("plus"));
+        }
+    }
+
+    void testMultipartInPieces()
+    {
+        begin("multipart bodies in pieces");
+
+        std::string body = multipartBody();
+
+        for(unsigned int seed = 0; seed < NUM_SPLITS; ++seed)
+        {
+            Poco::Net::NameValueCollection params;
+            TEST_CHECK(parseInPieces(multipartType(), body, seed, params));
+            TEST_CHECK(params.size() == 2);
+            TEST_CHECK(params.get("oauth_token", "") == "token");
+            TEST_CHECK(params.get("oauth_verifier", "") == "line one\r\nline two");
+        }
+    }
+
+    void testBoundarySplitAcrossWrites()
+    {
+        begin("a boundary split across writes");
+
+        std::string body = multipartBody();
+        int numWrong = 0;
+
+        // every possible cut, so each boundary is split at each of its bytes.
+        for(std::size_t cut = 1; cut < body.size(); ++cut)
+        {
+            Poco::Net::NameValueCollection params;
+            ofxOAuthFormParser parser(multipartType(), ofxOAuthFormParser::DEFAULT_MAX_BODY_SIZE, params);
+
+            bool ok = parser.write(body.data(), cut) &&
+                      parser.write(body.data() + cut, body.size() - cut) &&
+                      parser.finish();
+
+            if(!ok ||
+               params.get("oauth_token", "") != "token" ||
+               params.get("oauth_verifier", "") != "line one\r\nline two")
+            {
+                numWrong++;
+            }
+        }
+
+        TEST_CHECK(numWrong == 0);
+    }
+
+    void testPartWithoutHeaders()
+    {
+        begin("a part without headers");
+
+        std::string body = "--XyZzy\r\n"
+                           "\r\n"
+                           "anonymous\r\n"
+                           "--XyZzy--\r\n";
+
+        for(unsigned int seed = 0; seed < NUM_SPLITS; ++seed)
+        {
+            Poco::Net::NameValueCollection params;
+            TEST_CHECK(parseInPieces(multipartType(), body, seed, params));
+            TEST_CHECK(params.size() == 1);
+            TEST_CHECK(params.get("", "") == "anonymous");
+        }
+    }
+
+    void testSkipsFileParts()
+    {
+        begin("skips file parts");
+
+        // far larger than what the parser keeps of a part.
+        std::string fileData(256 * 1024, 'x');
+        std::string body = multipartBody(fileData);
+
+        Poco::Net::NameValueCollection params;
+        ofxOAuthFormParser parser(multipartType(), ofxOAuthFormParser::DEFAULT_MAX_BODY_SIZE, params);
+
+        for(std::size_t start = 0; start < body.size(); start += ofxOAuthFormParser::CHUNK_SIZE)
+        {
+            TEST_CHECK(parser.write(body.data() + start, std::min(body.size() - start, (std::size_t)ofxOAuthFormParser::CHUNK_SIZE)));
+        }
+
+        TEST_CHECK(parser.finish());
+        TEST_CHECK(!params.has("upload"));
+        TEST_CHECK(params.get("oauth_token", "") == "token");
+        TEST_CHECK(params.get("oauth_verifier", "") == "line one\r\nline two");
+    }
+
+    void testTruncatedBody()
+    {
+        begin("a truncated body");
+
+        std::string body = multipartBody();
+
+        // cut short anywhere before the closing boundary's "--".
+        std::size_t end = body.find("--XyZzy--") + 8;
+        int numWrong = 0;
+
+        for(std::size_t size = 0; size < end; ++size)
+        {
+            Poco::Net::NameValueCollection params;
+            ofxOAuthFormParser parser(multipartType(), ofxOAuthFormParser::DEFAULT_MAX_BODY_SIZE, params);
+            parser.write(body.data(), size);
+            if(parser.finish()) numWrong++;
+        }
+
+        TEST_CHECK(numWrong == 0);
+    }
+
+    void testTooLargeBody()
+    {
+        begin("a body that is too large");
+
+        std::string body = "oauth_token=token&oauth_verifier=verifier";
+
+        Poco::Net::NameValueCollection params;
+        ofxOAuthFormParser parser("application/x-www-form-urlencoded", 16, params);
+
+        TEST_CHECK(parser.write(body.data(), 16));
+        TEST_CHECK(!parser.isTooLarge());
+        TEST_CHECK(!parser.write(body.data() + 16, body.size() - 16));
+        TEST_CHECK(parser.isTooLarge());
+        TEST_CHECK(!parser.isOk());
+
+        Poco::Net::NameValueCollection multipartParams;
+        ofxOAuthFormParser multipartParser(multipartType(), 16, multipartParams);
+        std::string multipart = multipartBody();
+
+        TEST_CHECK(!multipartParser.write(multipart.data(), multipart.size()));
+        TEST_CHECK(multipartParser.isTooLarge());
+        TEST_CHECK(!multipartParser.finish());
+    }
+
+    void testVerifierCallbackServerPosts()
+    {
+        begin("the callback server reads posted forms");
+
+        PostParamsRecorder recorder;
+        ofxOAuthVerifierCallbackServer server(&recorder, "VerifierCallbackServer/");
+        server.setMaxPostBodySize(1024);
+        TEST_CHECK(server.start());
+
+        ofxOAuthTransport transport;
+
+        {
+            ofxOAuthTransportResult result;
+            TEST_CHECK(transport.post(server.getURL(), "oauth_token=token&oauth_verifier=verifier", "", result));
+            TEST_CHECK(result.status == 200);
+
+            Poco::Net::NameValueCollection params = recorder.getParams();
+            TEST_CHECK(params.get("oauth_token", "") == "token");
+            TEST_CHECK(params.get("oauth_verifier", "") == "verifier");
+        }
+
+        {
+            recorder.clear();
+
+            ofxOAuthTransportResult result;
+            TEST_CHECK(transport.post(server.getURL(), multipartBody(), "Content-Type: " + multipartType(), result));
+            TEST_CHECK(result.status == 200);
+
+            Poco::Net::NameValueCollection params = recorder.getParams();
+            TEST_CHECK(params.get("oauth_token", "") == "token");
+            TEST_CHECK(params.get("oauth_verifier", "") == "line one\r\nline two");
+        }
+
+        {
+            recorder.clear();
+
+            ofxOAuthTransportResult result;
+            transport.post(server.getURL(), "oauth_token=" + std::string(2048, 'x'), "", result);
+            TEST_CHECK(result.status == 413);
+            TEST_CHECK(recorder.getParams().empty());
+        }
+
+        {
+            ofxOAuthTransportResult result;
+            std::string body = multipartBody();
+            transport.post(server.getURL(), body.substr(0, body.find("--XyZzy--")), "Content-Type: " + multipartType(), result);
+            TEST_CHECK(result.status == 400);
+            TEST_CHECK(recorder.getParams().empty());
+        }
+
+        server.stop();
+    }
+
+};
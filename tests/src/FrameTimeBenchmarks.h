@@ -0,0 +1,166 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include "ofxOAuth.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Tells whether the client's update() is registered for frames.
+class FrameClient: public ofxOAuth
+{
+public:
+    bool isListeningToUpdate()
+    {
+        ofScopedLock lock(authStateMutex);
+        return listeningToUpdate;
+    }
+
+};
+
+
+//------------------------------------------------------------------------------
+// Checks that ofxOAuth::update() unregisters itself once the authorization
+// flow has ended, and measures what NUM_CLIENTS clients add to each frame
+// while their update() is registered and once it isn't.
+class FrameTimeBenchmarks: public TestSuite
+{
+public:
+    enum
+    {
+        NUM_CLIENTS = 1000,
+        NUM_FRAMES = 1000
+    };
+
+    FrameTimeBenchmarks():
+        TestSuite("FrameTimeBenchmarks")
+    {
+    }
+
+protected:
+    void run()
+    {
+        testUnregistersWhenAuthorized();
+        testResetErrorsRegisters();
+        testBenchmarkFrames();
+    }
+
+    void testUnregistersWhenAuthorized()
+    {
+        begin("update() unregisters once authorized");
+
+        FrameClient client;
+        setupClient(client, "http://127.0.0.1/");
+
+        TEST_CHECK(client.isListeningToUpdate());
+
+        frame();
+
+        TEST_CHECK(client.getAuthState() == ofxOAuth::OFX_AUTH_AUTHORIZED);
+        TEST_CHECK(!client.isListeningToUpdate());
+    }
+
+    void testResetErrorsRegisters()
+    {
+        begin("resetErrors() registers update() again");
+
+        FrameClient client;
+        setupClient(client, "http://127.0.0.1/");
+
+        frame();
+        client.resetErrors();
+
+        TEST_CHECK(client.isListeningToUpdate());
+
+        frame();
+
+        TEST_CHECK(!client.isListeningToUpdate());
+    }
+
+    void testBenchmarkFrames()
+    {
+        begin("benchmark frames");
+
+        double emptyMicros = timeFrames();
+
+        // not configured for the flow, so they stay registered and check
+        // their state every frame.
+        std::vector<std::shared_ptr<FrameClient> > clients;
+
+        for(int i = 0; i < NUM_CLIENTS; ++i)
+        {
+            clients.push_back(std::shared_ptr<FrameClient>(new FrameClient()));
+        }
+
+        double registeredMicros = timeFrames();
+
+        for(int i = 0; i < NUM_CLIENTS; ++i)
+        {
+            setupClient(*clients[i], "http://127.0.0.1/");
+        }
+
+        frame();
+
+        int numListening = 0;
+
+        for(int i = 0; i < NUM_CLIENTS; ++i)
+        {
+            if(clients[i]->isListeningToUpdate()) numListening++;
+        }
+
+        double authorizedMicros = timeFrames();
+
+        ofLogNotice(name) << "us per frame: no clients " << emptyMicros << ", "
+                          << NUM_CLIENTS << " registered clients " << registeredMicros << ", "
+                          << NUM_CLIENTS << " authorized clients " << authorizedMicros;
+
+        TEST_CHECK(numListening == 0);
+        TEST_CHECK(authorizedMicros < registeredMicros);
+    }
+
+    // The mean time of a frame's update event, in microseconds.
+    double timeFrames()
+    {
+        unsigned long long startTime = ofGetElapsedTimeMicros();
+
+        for(int i = 0; i < NUM_FRAMES; ++i)
+        {
+            frame();
+        }
+
+        return (ofGetElapsedTimeMicros() - startTime) / (double)NUM_FRAMES;
+    }
+
+    static void frame()
+    {
+        ofEventArgs args;
+        ofNotifyEvent(ofEvents().update, args);
+    }
+
+};
@@ -0,0 +1,198 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include "ofxOAuthHeaders.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+class HeadersTests: public TestSuite
+{
+public:
+    HeadersTests():
+        TestSuite("HeadersTests")
+    {
+    }
+
+protected:
+    void run()
+    {
+        testParsesFields();
+        testKeepsTheFinalBlockAfter100Continue();
+        testKeepsTheFinalBlockAfterRedirects();
+        testParsesNumbers();
+    }
+
+    // Feeds a header block to headers the way curl does, one line at a time.
+    static void appendBlock(ofxOAuthHeaders& headers, const std::string& block)
+    {
+        std::size_t start = 0;
+
+        while(start < block.size())
+        {
+            std::size_t end = block.find('\n', start);
+            end = (end == std::string::npos) ? block.size() : end + 1;
+            headers.appendLine(block.data() + start, end - start);
+            start = end;
+        }
+    }
+
+    void testParsesFields()
+    {
+        begin("parses fields, ignoring case, folded lines and blanks around values");
+
+        std::string block =
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type:  text/plain \t\r\n"
+            "X-Empty:\r\n"
+            "X-Folded: first\r\n"
+            "  second\r\n"
+            "no colon\r\n"
+            "ETag: \"1\"\r\n"
+            "etag: \"2\"\r\n"
+            "\r\n";
+
+        ofxOAuthHeaders headers;
+        appendBlock(headers, block);
+
+        TEST_CHECK(headers.size() == 5);
+        TEST_CHECK(headers.getName(0) == "Content-Type");
+        TEST_CHECK(headers.getValue(0) == "text/plain");
+        TEST_CHECK(headers.get("content-type") == "text/plain");
+        TEST_CHECK(headers.get("CONTENT-TYPE") == "text/plain");
+        TEST_CHECK(headers.has("x-empty") && headers.get("x-empty", "default") == "");
+        TEST_CHECK(headers.get("X-Folded") == "first");
+        TEST_CHECK(headers.get("ETag") == "\"1\"");
+        TEST_CHECK(!headers.has("Content-Length"));
+        TEST_CHECK(!headers.has("Content"));
+        TEST_CHECK(headers.get("Content-Length", "default") == "default");
+        TEST_CHECK(headers.getRaw() == block);
+
+        ofxOAuthHeaders other;
+        other.swap(headers);
+
+        TEST_CHECK(headers.empty() && headers.getRaw().empty());
+        TEST_CHECK(other.get("content-type") == "text/plain");
+
+        other.clear();
+
+        TEST_CHECK(other.empty() && !other.has("Content-Type"));
+    }
+
+    void testKeepsTheFinalBlockAfter100Continue()
+    {
+        begin("keeps only the final block after a 100 Continue");
+
+        std::string interim =
+            "HTTP/1.1 100 Continue\r\n"
+            "X-Interim: yes\r\n"
+            "\r\n";
+
+        std::string finalBlock =
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Length: 2\r\n"
+            "\r\n";
+
+        ofxOAuthHeaders headers;
+        appendBlock(headers, finalBlock);
+
+        ofxOAuthHeaders continued;
+        appendBlock(continued, interim);
+        appendBlock(continued, finalBlock);
+
+        TEST_CHECK(continued.size() == headers.size());
+        TEST_CHECK(continued.size() == 1);
+        TEST_CHECK(!continued.has("X-Interim"));
+        TEST_CHECK(continued.getNumber("Content-Length", -1) == 2);
+        TEST_CHECK(continued.getRaw() == finalBlock);
+        TEST_CHECK(headers.getRaw() == finalBlock);
+    }
+
+    void testKeepsTheFinalBlockAfterRedirects()
+    {
+        begin("keeps only the final block after redirects");
+
+        ofxOAuthHeaders headers;
+        appendBlock(headers,
+                    "HTTP/1.1 301 Moved Permanently\r\n"
+                    "Location: http://example.com/a\r\n"
+                    "Set-Cookie: first=1\r\n"
+                    "\r\n");
+
+        TEST_CHECK(headers.get("Location") == "http://example.com/a");
+
+        appendBlock(headers,
+                    "HTTP/1.0 302 Found\r\n"
+                    "Location: http://example.com/b\r\n"
+                    "Content-Length: 0\r\n"
+                    "\r\n");
+
+        TEST_CHECK(headers.get("Location") == "http://example.com/b");
+        TEST_CHECK(!headers.has("Set-Cookie"));
+
+        std::string finalBlock =
+            "HTTP/1.1 200 OK\r\n"
+            "content-length: 12\r\n"
+            "ETag: \"b\"\r\n"
+            "\r\n";
+
+        appendBlock(headers, finalBlock);
+
+        TEST_CHECK(headers.size() == 2);
+        TEST_CHECK(!headers.has("Location"));
+        TEST_CHECK(headers.getNumber("Content-Length", -1) == 12);
+        TEST_CHECK(headers.get("etag") == "\"b\"");
+        TEST_CHECK(headers.getRaw() == finalBlock);
+    }
+
+    void testParsesNumbers()
+    {
+        begin("parses numbers");
+
+        ofxOAuthHeaders headers;
+        appendBlock(headers,
+                    "HTTP/1.1 200 OK\r\n"
+                    "Content-Length: 1234567890123\r\n"
+                    "X-Rate-Limit-Remaining: 0\r\n"
+                    "X-Rate-Limit-Reset: 42, 43\r\n"
+                    "Retry-After: soon\r\n"
+                    "X-Negative: -5\r\n"
+                    "X-Empty: \r\n"
+                    "\r\n");
+
+        TEST_CHECK(headers.getNumber("content-length", -1) == 1234567890123LL);
+        TEST_CHECK(headers.getNumber("x-rate-limit-remaining", -1) == 0);
+        TEST_CHECK(headers.getNumber("X-Rate-Limit-Reset", -1) == 42);
+        TEST_CHECK(headers.getNumber("Retry-After", -1) == -1);
+        TEST_CHECK(headers.getNumber("X-Negative", -1) == -1);
+        TEST_CHECK(headers.getNumber("X-Empty", -1) == -1);
+        TEST_CHECK(headers.getNumber("X-Missing", 7) == 7);
+    }
+
+};
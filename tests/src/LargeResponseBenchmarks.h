@@ -0,0 +1,170 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include "ofxOAuth.h"
+#include "AllocationCounter.h"
+#include "StandInServer.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Answers with the same 1 MB body every time.
+class LargeBodyApi: public StandInHandler
+{
+public:
+    enum
+    {
+        BODY_SIZE = 1024 * 1024
+    };
+
+    LargeBodyApi()
+    {
+        body.reserve(BODY_SIZE);
+
+        for(int i = 0; i < BODY_SIZE; ++i)
+        {
+            body += (char)('a' + i % 26);
+        }
+    }
+
+    void handle(Poco::Net::HTTPServerRequest& request,
+                Poco::Net::HTTPServerResponse& response)
+    {
+        response.setContentType("application/octet-stream");
+        response.sendBuffer(body.data(), body.size());
+    }
+
+    std::string body;
+
+};
+
+
+//------------------------------------------------------------------------------
+// Fetches a 1 MB body NUM_REQUESTS times through the transport's old string
+// result, through get(), which copies the pooled body into a string, and
+// through getResponse(), which hands out the pooled buffer itself.  Logs
+// the allocator calls and the bytes allocated per request for each; every
+// body copy beyond the one curl writes into a buffer needs memory of its
+// own, so the bytes allocated count the bytes copied.
+class LargeResponseBenchmarks: public TestSuite
+{
+public:
+    enum
+    {
+        NUM_REQUESTS = 100,
+        NUM_WARMUP_REQUESTS = 5,
+
+        // what a request allocates besides the body: url, headers, ...
+        MAX_POOLED_BYTES_PER_REQUEST = 64 * 1024
+    };
+
+    LargeResponseBenchmarks():
+        TestSuite("LargeResponseBenchmarks")
+    {
+    }
+
+protected:
+    enum Path
+    {
+        TRANSPORT_STRING,
+        GET_STRING,
+        GET_RESPONSE
+    };
+
+    void run()
+    {
+        LargeBodyApi api;
+        StandInServer server(api);
+
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+
+        begin("benchmark 1 MB responses");
+
+        unsigned long long stringBytes = benchmark(client, server, TRANSPORT_STRING);
+        unsigned long long getBytes = benchmark(client, server, GET_STRING);
+        unsigned long long responseBytes = benchmark(client, server, GET_RESPONSE);
+
+        TEST_CHECK(responseBytes < MAX_POOLED_BYTES_PER_REQUEST);
+        TEST_CHECK(responseBytes < getBytes && responseBytes < stringBytes);
+    }
+
+    // Returns the bytes allocated per request.
+    unsigned long long benchmark(ofxOAuth& client, StandInServer& server, Path path)
+    {
+        static const char* names[] = { "transport string result", "get()", "getResponse()" };
+
+        int numWrong = 0;
+        long numAllocations = 0;
+        unsigned long long numBytes = 0;
+        unsigned long long startTime = 0;
+
+        for(int i = 0; i < NUM_WARMUP_REQUESTS + NUM_REQUESTS; ++i)
+        {
+            if(i == NUM_WARMUP_REQUESTS)
+            {
+                numAllocations = AllocationCounter::getNumAllocations();
+                numBytes = AllocationCounter::getNumBytesAllocated();
+                startTime = ofGetElapsedTimeMicros();
+            }
+
+            std::size_t size = 0;
+
+            if(path == TRANSPORT_STRING)
+            {
+                ofxOAuthTransportResult result;
+                client.getTransport()->get(server.getURL() + "/large", "", result);
+                size = result.body.size();
+            }
+            else if(path == GET_STRING)
+            {
+                size = client.get("/large").size();
+            }
+            else
+            {
+                size = client.getResponse("/large").size();
+            }
+
+            if(size != LargeBodyApi::BODY_SIZE) numWrong++;
+        }
+
+        unsigned long long elapsedMicros = ofGetElapsedTimeMicros() - startTime;
+        long allocationsPerRequest = (AllocationCounter::getNumAllocations() - numAllocations) / NUM_REQUESTS;
+        unsigned long long bytesPerRequest = (AllocationCounter::getNumBytesAllocated() - numBytes) / NUM_REQUESTS;
+
+        ofLogNotice(name) << names[path] << ": " << allocationsPerRequest << " allocations and "
+                          << bytesPerRequest / 1024 << " KB allocated per request, "
+                          << elapsedMicros / 1000.0 / NUM_REQUESTS << " ms each.";
+
+        TEST_CHECK(numWrong == 0);
+
+        return bytesPerRequest;
+    }
+
+};
@@ -0,0 +1,155 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include "ofxOAuth.h"
+#include "ofxOAuthMessageSplitter.h"
+#include "StandInServer.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Stands in for a streaming api: it sends three messages at once and then
+// keeps the stream open, idle, for IDLE_MILLIS.
+class IdleStreamApi: public StandInHandler
+{
+public:
+    enum
+    {
+        IDLE_MILLIS = 3000
+    };
+
+    void handle(Poco::Net::HTTPServerRequest& request,
+                Poco::Net::HTTPServerResponse& response)
+    {
+        response.setChunkedTransferEncoding(true);
+        response.setContentType("text/plain");
+
+        std::ostream& out = response.send();
+        out << "one\r\ntwo\r\nthree\r\n";
+        out.flush();
+
+        ofSleepMillis(IDLE_MILLIS);
+    }
+
+};
+
+
+//------------------------------------------------------------------------------
+// Holds back the first message it is given once, as a slow consumer would.
+class HoldingListener: public ofxOAuthMessageStreamListener
+{
+public:
+    HoldingListener():
+        numHeld(0)
+    {
+    }
+
+    bool messageReceived(const char* data, std::size_t size)
+    {
+        ofScopedLock lock(mutex);
+
+        if(numHeld == 0)
+        {
+            numHeld++;
+            return false;
+        }
+
+        messages.push_back(std::string(data, size));
+        return true;
+    }
+
+    void requestCompleted(const ofxOAuthTransportResult&)
+    {
+    }
+
+    std::vector<std::string> getMessages()
+    {
+        ofScopedLock lock(mutex);
+        return messages;
+    }
+
+protected:
+    int numHeld;
+    std::vector<std::string> messages;
+    ofMutex mutex;
+
+};
+
+
+//------------------------------------------------------------------------------
+class MessageStreamTests: public TestSuite
+{
+public:
+    MessageStreamTests():
+        TestSuite("MessageStreamTests")
+    {
+    }
+
+protected:
+    void run()
+    {
+        testDeliversHeldMessagesOnResume();
+    }
+
+    void testDeliversHeldMessagesOnResume()
+    {
+        begin("delivers a held message on resume while the stream is idle");
+
+        IdleStreamApi api;
+        StandInServer server(api);
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+
+        HoldingListener listener;
+        ofxOAuthAsyncResult result = client.getStream("/stream", "", &listener);
+
+        // all three messages have arrived and the first is held.
+        ofSleepMillis(500);
+        TEST_CHECK(listener.getMessages().empty());
+
+        listener.resume();
+        ofSleepMillis(500);
+
+        std::vector<std::string> messages = listener.getMessages();
+
+        // well before the stream sends anything else.
+        TEST_CHECK(messages.size() == 3);
+        TEST_CHECK(messages.size() > 0 && messages[0] == "one");
+        TEST_CHECK(messages.size() > 2 && messages[2] == "three");
+
+        // the stream is idle, so only the cancel() wakes the event loop.
+        unsigned long long cancelTime = ofGetElapsedTimeMillis();
+        listener.cancel();
+        TEST_CHECK(result.tryWait(200));
+        result.wait();
+
+        ofLogNotice(name) << "the cancelled stream ended after " << ofGetElapsedTimeMillis() - cancelTime << " ms.";
+    }
+
+};
@@ -0,0 +1,280 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <stdlib.h>
+#include <fstream>
+#include "Poco/Exception.h"
+#include "Poco/Net/MessageHeader.h"
+#include "Poco/Net/NameValueCollection.h"
+#include "ofxOAuth.h"
+#include "ofxOAuthMultipartBody.h"
+#include "AllocationCounter.h"
+#include "StandInServer.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Counts the bytes of each upload as it arrives, without keeping them, and
+// checks them against the Content-Length and the boundary of the
+// Content-Type.  Answers "ok", or a 400 if the body doesn't match.
+class UploadCountingApi: public StandInHandler
+{
+public:
+    enum
+    {
+        EDGE_SIZE = 256
+    };
+
+    UploadCountingApi():
+        numBytes(0),
+        contentLength(0)
+    {
+    }
+
+    void handle(Poco::Net::HTTPServerRequest& request,
+                Poco::Net::HTTPServerResponse& response)
+    {
+        std::string type;
+        Poco::Net::NameValueCollection parameters;
+        Poco::Net::MessageHeader::splitParameters(request.getContentType(), type, parameters);
+
+        std::string b = parameters.get("boundary", "");
+        unsigned long long length = strtoull(request.get("Content-Length", "0").c_str(), NULL, 10);
+        unsigned long long n = 0;
+        std::string head;
+        std::string tail;
+
+        try
+        {
+            std::istream& in = request.stream();
+            std::vector<char> buffer(64 * 1024);
+
+            while(in.good())
+            {
+                in.read(&buffer[0], buffer.size());
+                std::streamsize count = in.gcount();
+                if(count <= 0) break;
+
+                n += count;
+
+                if(head.size() < EDGE_SIZE) head.append(&buffer[0], std::min((std::size_t)count, EDGE_SIZE - head.size()));
+
+                tail.append(&buffer[0], (std::size_t)count);
+                if(tail.size() > EDGE_SIZE) tail.erase(0, tail.size() - EDGE_SIZE);
+            }
+        }
+        catch(const Poco::Exception&)
+        {
+            // an upload that was given up part way.
+        }
+
+        bool ok = type == "multipart/form-data" &&
+                  !b.empty() &&
+                  n == length &&
+                  head.compare(0, b.size() + 4, "--" + b + "\r\n") == 0 &&
+                  tail.size() >= b.size() + 8 &&
+                  tail.compare(tail.size() - (b.size() + 8), b.size() + 8, "\r\n--" + b + "--\r\n") == 0;
+
+        {
+            ofScopedLock lock(mutex);
+            boundary = b;
+            numBytes = n;
+            contentLength = length;
+        }
+
+        if(!ok) response.setStatus(Poco::Net::HTTPResponse::HTTP_BAD_REQUEST);
+        response.setContentType("text/plain");
+        response.send() << (ok ? "ok" : "mismatch");
+    }
+
+    std::string getBoundary()
+    {
+        ofScopedLock lock(mutex);
+        return boundary;
+    }
+
+    unsigned long long getNumBytes()
+    {
+        ofScopedLock lock(mutex);
+        return numBytes;
+    }
+
+    unsigned long long getContentLength()
+    {
+        ofScopedLock lock(mutex);
+        return contentLength;
+    }
+
+protected:
+    std::string boundary;
+    unsigned long long numBytes;
+    unsigned long long contentLength;
+
+    ofMutex mutex;
+
+};
+
+
+//------------------------------------------------------------------------------
+// Uploads a multi-GB file through postMultipart() and checks that what
+// arrives is the whole body while the resident set size stays flat, as the
+// file is read in chunks while it is sent.  The file is sparse where the
+// file system allows it.  Also checks that a file that changes after it
+// was added fails the upload instead of sending a body that doesn't match
+// its Content-Length.
+class MultipartUploadTests: public TestSuite
+{
+public:
+    enum
+    {
+        // the body is streamed, so only chunks and buffers are resident.
+        MAX_RESIDENT_GROWTH = 16 * 1024 * 1024
+    };
+
+    MultipartUploadTests():
+        TestSuite("MultipartUploadTests")
+    {
+    }
+
+protected:
+    void run()
+    {
+        UploadCountingApi api;
+        StandInServer server(api);
+
+        testUploadsLargeFiles(api, server);
+        testFailsOnChangedFiles(api, server, true);
+        testFailsOnChangedFiles(api, server, false);
+    }
+
+    std::string getFileName(const std::string& suffix) const
+    {
+        return ofToDataPath("MultipartUploadTests-" + suffix + ".bin", true);
+    }
+
+    // A file of size zeros, sparse where the file system allows it.
+    bool makeFile(const std::string& pathname, uint64_t size)
+    {
+        std::ofstream out(pathname.c_str(), std::ios::binary | std::ios::trunc);
+        out.seekp((std::streamoff)(size - 1));
+        out.put('\0');
+        return (bool)out;
+    }
+
+    bool upload(ofxOAuth& client,
+                UploadCountingApi& api,
+                const std::string& pathname,
+                ofxOAuthResponse& response)
+    {
+        std::shared_ptr<ofxOAuthMultipartBody> body(new ofxOAuthMultipartBody());
+        body->addField("status", "an upload");
+        if(!body->addFile("media", pathname)) return false;
+
+        response = client.postMultipart("/upload", body);
+
+        return response.isOk() &&
+               response.status == 200 &&
+               api.getBoundary() == body->getBoundary() &&
+               api.getNumBytes() == body->getSize() &&
+               api.getContentLength() == body->getSize();
+    }
+
+    void testUploadsLargeFiles(UploadCountingApi& api, StandInServer& server)
+    {
+        begin("uploads a multi-GB file in constant memory");
+
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+
+        std::string small = getFileName("small");
+        std::string large = getFileName("large");
+
+        // 4 GB and some, more than a 32 bit length can hold.
+        uint64_t largeSize = 4096ULL * 1024 * 1024 + 12345;
+
+        TEST_CHECK(makeFile(small, 16 * 1024 * 1024));
+        TEST_CHECK(makeFile(large, largeSize));
+
+        ofxOAuthResponse response;
+
+        // warms up the handles and buffers.
+        TEST_CHECK(upload(client, api, small, response));
+
+        std::size_t residentBytes = AllocationCounter::getResidentBytes();
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        TEST_CHECK(upload(client, api, large, response));
+        TEST_CHECK(response.toString() == "ok");
+        TEST_CHECK(api.getNumBytes() > largeSize);
+
+        unsigned long long millis = ofGetElapsedTimeMillis() - startTime;
+        long residentGrowth = (long)AllocationCounter::getResidentBytes() - (long)residentBytes;
+
+        ofLogNotice(name) << api.getNumBytes() / (1024 * 1024) << " MB uploaded in " << millis << " ms, "
+                          << residentGrowth / 1024 << " KB more resident.";
+
+        // 0 where the resident set size can't be measured.
+        TEST_CHECK(residentBytes == 0 || residentGrowth <= MAX_RESIDENT_GROWTH);
+
+        ofFile::removeFile(small, false);
+        ofFile::removeFile(large, false);
+    }
+
+    void testFailsOnChangedFiles(UploadCountingApi& api, StandInServer& server, bool append)
+    {
+        begin(append ? "fails if the file grew after it was added" : "fails if the file shrank after it was added");
+
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+
+        std::string pathname = getFileName("changed");
+        TEST_CHECK(makeFile(pathname, 1024 * 1024));
+
+        std::shared_ptr<ofxOAuthMultipartBody> body(new ofxOAuthMultipartBody());
+        TEST_CHECK(body->addFile("media", pathname));
+
+        if(append)
+        {
+            std::ofstream out(pathname.c_str(), std::ios::binary | std::ios::app);
+            out << "appended";
+        }
+        else
+        {
+            TEST_CHECK(makeFile(pathname, 1024));
+        }
+
+        // the read callback gives up with CURL_READFUNC_ABORT.
+        ofxOAuthResponse response = client.postMultipart("/upload", body);
+        TEST_CHECK(!response.isOk());
+        TEST_CHECK(response.curlCode == CURLE_ABORTED_BY_CALLBACK);
+
+        ofFile::removeFile(pathname, false);
+    }
+
+};
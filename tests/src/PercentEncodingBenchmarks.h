@@ -0,0 +1,181 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include "ofxOAuthPercentEncoding.h"
+#include "PercentEncodingScalar.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Measures the percent-encoding and decoding throughput of the vectorized
+// build (AVX2 or SSE2, whichever this app was compiled for) against the
+// OFX_OAUTH_PERCENT_ENCODING_SCALAR build, for inputs of 16 bytes to 1 MB.
+// The input is mostly unreserved, with a byte to escape every 24 bytes or
+// so, like the parameter values of a typical request.
+class PercentEncodingBenchmarks: public TestSuite
+{
+public:
+    enum
+    {
+        BYTES_PER_SIZE = 64 * 1024 * 1024
+    };
+
+    PercentEncodingBenchmarks():
+        TestSuite("PercentEncodingBenchmarks")
+    {
+        sizes.push_back(16);
+        sizes.push_back(64);
+        sizes.push_back(256);
+        sizes.push_back(1024);
+        sizes.push_back(16 * 1024);
+        sizes.push_back(1024 * 1024);
+    }
+
+protected:
+    class VectorizedCodec
+    {
+    public:
+        static void encode(const std::string& value, std::string& result)
+        {
+            ofxOAuthPercentEncoding::encode(value.data(), value.size(), result);
+        }
+
+        static void decode(const std::string& value, std::string& result)
+        {
+            ofxOAuthPercentEncoding::decode(value.data(), value.size(), result);
+        }
+    };
+
+    void run()
+    {
+#if defined(OFX_OAUTH_PERCENT_ENCODING_SCALAR)
+        ofLogNotice(name) << "this app is built with OFX_OAUTH_PERCENT_ENCODING_SCALAR, both paths are scalar.";
+        const char* vectorized = "scalar";
+#elif defined(OFX_OAUTH_PERCENT_ENCODING_AVX2)
+        const char* vectorized = "AVX2";
+#elif defined(OFX_OAUTH_PERCENT_ENCODING_SSE2)
+        const char* vectorized = "SSE2";
+#else
+        ofLogNotice(name) << "this app is built without SSE2 or AVX2, both paths are scalar.";
+        const char* vectorized = "scalar";
+#endif
+
+        for(std::size_t i = 0; i < sizes.size(); ++i)
+        {
+            benchmark(sizes[i], vectorized);
+        }
+    }
+
+    void benchmark(std::size_t size, const char* vectorized)
+    {
+        begin("benchmark " + ofToString(size) + " bytes");
+
+        std::string input = makeInput(size);
+
+        std::string vectorizedEncoded;
+        std::string scalarEncoded;
+        VectorizedCodec::encode(input, vectorizedEncoded);
+        PercentEncodingScalar::encode(input, scalarEncoded);
+
+        TEST_CHECK(vectorizedEncoded == scalarEncoded);
+
+        std::string decoded;
+        VectorizedCodec::decode(vectorizedEncoded, decoded);
+        TEST_CHECK(decoded == input);
+
+        decoded.clear();
+        PercentEncodingScalar::decode(scalarEncoded, decoded);
+        TEST_CHECK(decoded == input);
+
+        double vectorizedEncode = measure<VectorizedCodec, true>(input);
+        double scalarEncode = measure<PercentEncodingScalar, true>(input);
+        double vectorizedDecode = measure<VectorizedCodec, false>(vectorizedEncoded);
+        double scalarDecode = measure<PercentEncodingScalar, false>(vectorizedEncoded);
+
+        ofLogNotice(name) << size << " bytes, MB/s of input: encode " << vectorized << " " << (long)vectorizedEncode
+                          << ", scalar " << (long)scalarEncode << "; decode " << vectorized << " " << (long)vectorizedDecode
+                          << ", scalar " << (long)scalarDecode;
+    }
+
+    // The MB per second of input that Codec encodes (or decodes).
+    template<typename Codec, bool encoding>
+    static double measure(const std::string& input)
+    {
+        std::size_t numRuns = std::max((std::size_t)1, BYTES_PER_SIZE / input.size());
+
+        std::string result;
+        result.reserve(input.size() * 3);
+
+        unsigned long long startTime = ofGetElapsedTimeMicros();
+
+        for(std::size_t i = 0; i < numRuns; ++i)
+        {
+            result.clear();
+
+            if(encoding)
+            {
+                Codec::encode(input, result);
+            }
+            else
+            {
+                Codec::decode(input, result);
+            }
+        }
+
+        unsigned long long elapsedMicros = std::max(1ULL, ofGetElapsedTimeMicros() - startTime);
+
+        return (double)numRuns * input.size() / elapsedMicros;
+    }
+
+    static std::string makeInput(std::size_t size)
+    {
+        static const char unreserved[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-._~";
+        static const char reserved[] = " /:?&=+%@\xC3\xA9";
+
+        std::string input;
+        input.reserve(size);
+
+        for(std::size_t i = 0; i < size; ++i)
+        {
+            if(i % 24 == 23)
+            {
+                input += reserved[(i / 24) % (sizeof(reserved) - 1)];
+            }
+            else
+            {
+                input += unreserved[(i * 7) % (sizeof(unreserved) - 1)];
+            }
+        }
+
+        return input;
+    }
+
+    std::vector<std::size_t> sizes;
+
+};
@@ -0,0 +1,48 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+// The scalar build is given a class name of its own, so it doesn't clash
+// with the vectorized ofxOAuthPercentEncoding of the other files.
+#define OFX_OAUTH_PERCENT_ENCODING_SCALAR
+#define ofxOAuthPercentEncoding ofxOAuthPercentEncodingScalar
+#include "ofxOAuthPercentEncoding.h"
+#undef ofxOAuthPercentEncoding
+
+#include "PercentEncodingScalar.h"
+
+
+//------------------------------------------------------------------------------
+void PercentEncodingScalar::encode(const std::string& value, std::string& result)
+{
+    ofxOAuthPercentEncodingScalar::encode(value.data(), value.size(), result);
+}
+
+
+//------------------------------------------------------------------------------
+void PercentEncodingScalar::decode(const std::string& value, std::string& result)
+{
+    ofxOAuthPercentEncodingScalar::decode(value.data(), value.size(), result);
+}
@@ -0,0 +1,379 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <ctime>
+#include "ofxOAuthTransport.h"
+#include "StandInServer.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Stands in for an api that allows limit requests per second and account
+// (told apart by the Authorization header) under /limited, like Twitter
+// does per 15 minutes, and refuses the rest with a 429.  /free is not
+// limited and /busy refuses its first request with a Retry-After.
+class RateLimitedApi: public StandInHandler
+{
+public:
+    RateLimitedApi(int _limit):
+        limit(_limit),
+        numServed(0),
+        numRefused(0),
+        busy(true)
+    {
+    }
+
+    void handle(Poco::Net::HTTPServerRequest& request,
+                Poco::Net::HTTPServerResponse& response)
+    {
+        const std::string& uri = request.getURI();
+
+        if(uri.compare(0, 5, "/busy") == 0)
+        {
+            ofScopedLock lock(mutex);
+
+            if(busy)
+            {
+                busy = false;
+                numRefused++;
+                response.set("Retry-After", "1");
+                response.setStatusAndReason((Poco::Net::HTTPResponse::HTTPStatus)429, "Too Many Requests");
+                response.send();
+                return;
+            }
+        }
+        else if(uri.compare(0, 8, "/limited") == 0)
+        {
+            std::string account = request.get("Authorization", "");
+
+            ofScopedLock lock(mutex);
+
+            std::time_t now = std::time(NULL);
+            Window& w = windows[account];
+
+            if(w.start != now)
+            {
+                w.start = now;
+                w.count = 0;
+            }
+
+            w.count++;
+
+            response.set("x-rate-limit-limit", ofToString(limit));
+            response.set("x-rate-limit-remaining", ofToString(std::max(0, limit - w.count)));
+            response.set("x-rate-limit-reset", ofToString((long long)now + 1));
+
+            if(w.count > limit)
+            {
+                numRefused++;
+                response.setStatusAndReason((Poco::Net::HTTPResponse::HTTPStatus)429, "Too Many Requests");
+                response.send();
+                return;
+            }
+        }
+
+        {
+            ofScopedLock lock(mutex);
+            numServed++;
+        }
+
+        response.setContentType("text/plain");
+        response.send() << "ok";
+    }
+
+    int getNumServed()
+    {
+        ofScopedLock lock(mutex);
+        return numServed;
+    }
+
+    int getNumRefused()
+    {
+        ofScopedLock lock(mutex);
+        return numRefused;
+    }
+
+protected:
+    struct Window
+    {
+        Window(): start(0), count(0) {}
+        std::time_t start;
+        int count;
+    };
+
+    int limit;
+    int numServed;
+    int numRefused;
+    bool busy;
+    std::map<std::string, Window> windows;
+
+    ofMutex mutex;
+
+};
+
+
+//------------------------------------------------------------------------------
+class RateLimiterTests: public TestSuite
+{
+public:
+    RateLimiterTests():
+        TestSuite("RateLimiterTests")
+    {
+    }
+
+protected:
+    enum
+    {
+        LIMIT = 5
+    };
+
+    void run()
+    {
+        testThrottlesToTheLimit();
+        testKeepsAccountsApart();
+        testOnlyKeepsLimitedFamilies();
+        testDropsIdleBudgets();
+        testWaitsForRetryAfter();
+        testProbesWithoutReset();
+        testProbesAfterRefusalWithoutHeaders();
+    }
+
+    void testThrottlesToTheLimit()
+    {
+        begin("throttles to the limit");
+
+        RateLimitedApi api(LIMIT);
+        StandInServer server(api);
+        ofxOAuthTransport transport;
+
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        for(int i = 0; i < 3 * LIMIT; ++i)
+        {
+            ofxOAuthTransportResult result;
+            TEST_CHECK(get(transport, server.getURL() + "/limited?page=" + ofToString(i), "a", result));
+            TEST_CHECK(result.status == 200);
+        }
+
+        // three windows' worth can't be sent in less than two.
+        TEST_CHECK(ofGetElapsedTimeMillis() - startTime >= 1000);
+        TEST_CHECK(api.getNumRefused() == 0);
+        TEST_CHECK(api.getNumServed() == 3 * LIMIT);
+
+        ofxOAuthRateLimitBudget b = transport.getRateLimiter()->getBudget(server.getURL() + "/limited", "a");
+        TEST_CHECK(b.isKnown());
+        TEST_CHECK(b.limit == LIMIT);
+        TEST_CHECK(b.numInFlight == 0);
+    }
+
+    void testKeepsAccountsApart()
+    {
+        begin("keeps the budgets of accounts apart");
+
+        RateLimitedApi api(LIMIT);
+        StandInServer server(api);
+        ofxOAuthTransport transport;
+
+        waitForNextSecond();
+
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        // both accounts use up their own window, neither waits for the other.
+        for(int i = 0; i < 2 * LIMIT; ++i)
+        {
+            ofxOAuthTransportResult result;
+            TEST_CHECK(get(transport, server.getURL() + "/limited", i < LIMIT ? "a" : "b", result));
+            TEST_CHECK(result.status == 200);
+        }
+
+        TEST_CHECK(ofGetElapsedTimeMillis() - startTime < 900);
+        TEST_CHECK(api.getNumRefused() == 0);
+        TEST_CHECK(transport.getRateLimiter()->getNumBudgets() == 2);
+        TEST_CHECK(transport.getRateLimiter()->getBudget(server.getURL() + "/limited", "a").remaining == 0);
+        TEST_CHECK(transport.getRateLimiter()->getBudget(server.getURL() + "/limited", "b").remaining == 0);
+        TEST_CHECK(!transport.getRateLimiter()->getBudget(server.getURL() + "/limited", "c").isKnown());
+    }
+
+    void testOnlyKeepsLimitedFamilies()
+    {
+        begin("only keeps budgets for limited families");
+
+        RateLimitedApi api(LIMIT);
+        StandInServer server(api);
+        ofxOAuthTransport transport;
+
+        for(int i = 0; i < 100; ++i)
+        {
+            ofxOAuthTransportResult result;
+            TEST_CHECK(get(transport, server.getURL() + "/free/" + ofToString(i), "a", result));
+        }
+
+        TEST_CHECK(transport.getRateLimiter()->getNumBudgets() == 0);
+    }
+
+    void testDropsIdleBudgets()
+    {
+        begin("drops idle budgets");
+
+        RateLimitedApi api(LIMIT);
+        StandInServer server(api);
+        ofxOAuthTransport transport;
+        std::shared_ptr<ofxOAuthRateLimiter> limiter = transport.getRateLimiter();
+
+        ofxOAuthTransportResult result;
+        TEST_CHECK(get(transport, server.getURL() + "/limited", "a", result));
+        TEST_CHECK(limiter->getNumBudgets() == 1);
+
+        // a budget is kept until its window resets, however short the idle time.
+        limiter->setMaxIdleMillis(0);
+        TEST_CHECK(get(transport, server.getURL() + "/free", "a", result));
+        TEST_CHECK(limiter->getNumBudgets() == 1);
+
+        ofSleepMillis(1100);
+
+        limiter->setMaxIdleMillis(0);
+        TEST_CHECK(get(transport, server.getURL() + "/free", "a", result));
+        TEST_CHECK(limiter->getNumBudgets() == 0);
+    }
+
+    void testWaitsForRetryAfter()
+    {
+        begin("waits for Retry-After");
+
+        RateLimitedApi api(LIMIT);
+        StandInServer server(api);
+        ofxOAuthTransport transport;
+
+        ofxOAuthTransportResult result;
+        TEST_CHECK(get(transport, server.getURL() + "/busy", "a", result));
+        TEST_CHECK(result.status == 429);
+        TEST_CHECK(transport.getRateLimiter()->tryAcquire(server.getURL() + "/busy", -1, "a") > 0);
+        TEST_CHECK(transport.getRateLimiter()->tryAcquire(server.getURL() + "/busy", -1, "b") == 0);
+        transport.getRateLimiter()->release(server.getURL() + "/busy", 0, ofxOAuthHeaders(), "b");
+
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        TEST_CHECK(get(transport, server.getURL() + "/busy", "a", result));
+        TEST_CHECK(result.status == 200);
+        TEST_CHECK(ofGetElapsedTimeMillis() - startTime >= 900);
+    }
+
+    void testProbesWithoutReset()
+    {
+        begin("probes a used up budget without a reset");
+
+        ofxOAuthRateLimiter limiter;
+        limiter.setDefaultRetryAfterMillis(100);
+        std::string url = "http://api/limited";
+
+        TEST_CHECK(limiter.tryAcquire(url) == 0);
+        limiter.release(url, 200, headers("x-rate-limit-limit: 5\r\nx-rate-limit-remaining: 0\r\n"));
+        TEST_CHECK(limiter.tryAcquire(url) > 0);
+
+        // one probe is let through once the delay is over, the rest wait for it.
+        TEST_CHECK(limiter.acquire(url, 1000));
+        TEST_CHECK(limiter.tryAcquire(url) > 0);
+        TEST_CHECK(limiter.tryAcquire(url, 10) == -1);
+
+        limiter.release(url, 200, headers("x-rate-limit-limit: 5\r\nx-rate-limit-remaining: 4\r\n"));
+        TEST_CHECK(limiter.getBudget(url).remaining == 4);
+        TEST_CHECK(limiter.acquire(url, 1000));
+        TEST_CHECK(limiter.getBudget(url).remaining == 3);
+        limiter.release(url, 200, headers("x-rate-limit-limit: 5\r\nx-rate-limit-remaining: 3\r\n"));
+    }
+
+    void testProbesAfterRefusalWithoutHeaders()
+    {
+        begin("probes after a 429 without headers once the window refilled");
+
+        ofxOAuthRateLimiter limiter;
+        limiter.setDefaultRetryAfterMillis(100);
+        std::string url = "http://api/limited";
+
+        long long reset = ofxOAuthRateLimiter::getTime() / 1000 + 1;
+
+        TEST_CHECK(limiter.tryAcquire(url) == 0);
+        limiter.release(url, 200, headers("x-rate-limit-limit: 5\r\nx-rate-limit-remaining: 4\r\nx-rate-limit-reset: " + ofToString(reset) + "\r\n"));
+
+        // the window resets and the budget refills, forgetting the reset.
+        while(ofxOAuthRateLimiter::getTime() < reset * 1000) ofSleepMillis(10);
+        TEST_CHECK(limiter.getBudget(url).remaining == 5);
+        TEST_CHECK(limiter.getBudget(url).resetTime == 0);
+
+        TEST_CHECK(limiter.tryAcquire(url) == 0);
+        limiter.release(url, 429, ofxOAuthHeaders());
+        TEST_CHECK(limiter.getBudget(url).remaining == 0);
+        TEST_CHECK(limiter.tryAcquire(url) > 0);
+
+        TEST_CHECK(limiter.acquire(url, 1000));
+        TEST_CHECK(limiter.tryAcquire(url) > 0);
+
+        // the probe went through, so the window has been reset.
+        limiter.release(url, 200, ofxOAuthHeaders());
+        TEST_CHECK(limiter.getBudget(url).remaining == 5);
+        TEST_CHECK(limiter.acquire(url, 1000));
+        limiter.release(url, 200, ofxOAuthHeaders());
+    }
+
+    static ofxOAuthHeaders headers(const std::string& block)
+    {
+        ofxOAuthHeaders h;
+        h.appendLine("HTTP/1.1 200 OK\r\n", 17);
+
+        std::size_t start = 0;
+        while(start < block.size())
+        {
+            std::size_t end = block.find("\r\n", start);
+            if(end == std::string::npos) end = block.size();
+            h.appendLine(block.data() + start, end - start);
+            start = end + 2;
+        }
+
+        return h;
+    }
+
+    static bool get(ofxOAuthTransport& transport,
+                    const std::string& url,
+                    const std::string& account,
+                    ofxOAuthTransportResult& result)
+    {
+        ofxOAuthTransportRequest request;
+        request.url = url;
+        request.header = "Authorization: OAuth oauth_token=\"" + account + "\"";
+        request.account = account;
+        return transport.perform(request, result);
+    }
+
+    // so that a burst fits in one of the stand-in's windows.
+    static void waitForNextSecond()
+    {
+        std::time_t start = std::time(NULL);
+        while(std::time(NULL) == start) ofSleepMillis(5);
+    }
+
+};
@@ -0,0 +1,241 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include "ofxOAuth.h"
+#include "StandInServer.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Stands in for a cacheable api.  Every answer says which server sent it:
+//
+//   /fresh      fresh for a minute
+//   /same       must be revalidated, and never changes (304)
+//   /changing   must be revalidated, and changes every time (200)
+class CacheableApi: public StandInHandler
+{
+public:
+    CacheableApi(const std::string& _name):
+        name(_name),
+        version(0)
+    {
+    }
+
+    void handle(Poco::Net::HTTPServerRequest& request,
+                Poco::Net::HTTPServerResponse& response)
+    {
+        std::string path = request.getURI().substr(0, request.getURI().find('?'));
+        std::string etag;
+
+        if(path == "/fresh")
+        {
+            response.set("Cache-Control", "max-age=60");
+        }
+        else
+        {
+            ofScopedLock lock(mutex);
+            etag = "\"" + (path == "/same" ? std::string("1") : ofToString(++version)) + "\"";
+            response.set("Cache-Control", "no-cache");
+            response.set("ETag", etag);
+        }
+
+        if(!etag.empty() && request.get("If-None-Match", "") == etag)
+        {
+            response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NOT_MODIFIED);
+            response.send();
+            return;
+        }
+
+        response.setContentType("text/plain");
+        response.send() << name << path;
+    }
+
+protected:
+    std::string name;
+    int version;
+
+    ofMutex mutex;
+
+};
+
+
+//------------------------------------------------------------------------------
+class ResponseCacheTests: public TestSuite
+{
+public:
+    ResponseCacheTests():
+        TestSuite("ResponseCacheTests"),
+        diskPath(ofToDataPath("ResponseCacheTests", true))
+    {
+    }
+
+protected:
+    void run()
+    {
+        testKeysIncludeTheApiURL();
+        testCountsRevalidations();
+        testMapsDiskHits();
+        testCountsFilesAlreadyOnDisk();
+    }
+
+    static std::string toString(const ofxOAuthResponse& response)
+    {
+        return std::string(response.data(), response.size());
+    }
+
+    void resetDiskPath()
+    {
+        ofDirectory::removeDirectory(diskPath, true, false);
+        ofDirectory::createDirectory(diskPath, false, true);
+    }
+
+    void testKeysIncludeTheApiURL()
+    {
+        begin("keys include the api url");
+
+        CacheableApi apiA("a");
+        CacheableApi apiB("b");
+        StandInServer serverA(apiA);
+        StandInServer serverB(apiB);
+
+        std::shared_ptr<ofxOAuthResponseCache> cache(new ofxOAuthResponseCache());
+
+        ofxOAuth clientA;
+        setupClient(clientA, serverA.getURL());
+        clientA.setResponseCache(cache);
+
+        ofxOAuth clientB;
+        setupClient(clientB, serverB.getURL());
+        clientB.setResponseCache(cache);
+
+        TEST_CHECK(toString(clientA.getResponse("/fresh")) == "a/fresh");
+        TEST_CHECK(toString(clientB.getResponse("/fresh")) == "b/fresh");
+        TEST_CHECK(toString(clientA.getResponse("/fresh")) == "a/fresh");
+        TEST_CHECK(cache->getStats().hits == 1);
+    }
+
+    void testCountsRevalidations()
+    {
+        begin("counts a stale entry as a miss unless it is revalidated");
+
+        CacheableApi api("a");
+        StandInServer server(api);
+
+        std::shared_ptr<ofxOAuthResponseCache> cache(new ofxOAuthResponseCache());
+
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+        client.setResponseCache(cache);
+
+        client.getResponse("/same");
+        ofxOAuthResponse response = client.getResponse("/same");
+
+        TEST_CHECK(response.status == 200 && response.fromCache);
+        TEST_CHECK(cache->getStats().misses == 1);
+        TEST_CHECK(cache->getStats().revalidations == 1);
+
+        client.getResponse("/changing");
+        response = client.getResponse("/changing");
+
+        TEST_CHECK(response.status == 200 && !response.fromCache);
+        TEST_CHECK(cache->getStats().misses == 3);
+        TEST_CHECK(cache->getStats().revalidations == 1);
+    }
+
+    void testMapsDiskHits()
+    {
+        begin("answers disk hits from the mapped file");
+
+        resetDiskPath();
+
+        CacheableApi api("a");
+        StandInServer server(api);
+
+        std::shared_ptr<ofxOAuthResponseCache> cache(new ofxOAuthResponseCache());
+        cache->setDiskPath(diskPath);
+
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+        client.setResponseCache(cache);
+
+        client.getResponse("/fresh");
+        cache->clear();
+
+        ofxOAuthResponse response = client.getResponse("/fresh");
+
+        TEST_CHECK(response.fromCache);
+        TEST_CHECK(response.mappedFile != NULL);
+        TEST_CHECK(toString(response) == "a/fresh");
+        TEST_CHECK(response.getBuffer().getText() == "a/fresh");
+        TEST_CHECK(cache->getStats().diskHits == 1);
+    }
+
+    void testCountsFilesAlreadyOnDisk()
+    {
+        begin("counts the files a previous run left on disk");
+
+        resetDiskPath();
+
+        CacheableApi api("a");
+        StandInServer server(api);
+
+        std::size_t diskBytes = 0;
+
+        {
+            std::shared_ptr<ofxOAuthResponseCache> cache(new ofxOAuthResponseCache());
+            cache->setDiskPath(diskPath);
+
+            ofxOAuth client;
+            setupClient(client, server.getURL());
+            client.setResponseCache(cache);
+
+            client.getResponse("/fresh");
+            client.getResponse("/same");
+            diskBytes = cache->getDiskBytes();
+        }
+
+        TEST_CHECK(diskBytes > 0);
+
+        ofxOAuthResponseCache cache;
+        cache.setDiskPath(diskPath);
+
+        TEST_CHECK(cache.getDiskBytes() == diskBytes);
+
+        // too small for both, the older one goes.
+        cache.setDiskPath(diskPath, diskBytes - 1);
+
+        TEST_CHECK(cache.getDiskBytes() < diskBytes);
+        TEST_CHECK(cache.getStats().evictions == 1);
+
+        ofDirectory::removeDirectory(diskPath, true, false);
+    }
+
+    std::string diskPath;
+
+};
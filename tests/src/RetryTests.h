@@ -0,0 +1,330 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <set>
+#include "ofxOAuth.h"
+#include "StandInServer.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Stands in for an unreliable api.  Each path fails its first few requests
+// in the way its name says, then answers "ok":
+//
+//   /unavailable/N   N 503s
+//   /slow/N          N answers that take SLOW_MILLIS, longer than the
+//                    client's timeout
+//   /later/N         N 503s asking to come back in an hour
+//   /revalidated/N   request number N is slow; every answer must be
+//                    revalidated and never changes (304 on If-None-Match)
+class FlakyApi: public StandInHandler
+{
+public:
+    enum
+    {
+        SLOW_MILLIS = 2500
+    };
+
+    FlakyApi():
+        numNotModified(0)
+    {
+    }
+
+    void handle(Poco::Net::HTTPServerRequest& request,
+                Poco::Net::HTTPServerResponse& response)
+    {
+        std::string path = request.getURI().substr(0, request.getURI().find('?'));
+        std::vector<std::string> parts = ofSplitString(path, "/", true);
+
+        std::string fault = parts.size() > 0 ? parts[0] : "";
+        int numFaults = parts.size() > 1 ? ofToInt(parts[1]) : 0;
+        int count = 0;
+
+        {
+            ofScopedLock lock(mutex);
+            count = ++counts[path];
+            nonces.insert(getNonce(request.get("Authorization", "")));
+        }
+
+        if(fault == "revalidated")
+        {
+            if(count == numFaults)
+            {
+                ofSleepMillis(SLOW_MILLIS);
+            }
+
+            response.set("Cache-Control", "no-cache");
+            response.set("ETag", "\"1\"");
+
+            if(request.get("If-None-Match", "") == "\"1\"")
+            {
+                {
+                    ofScopedLock lock(mutex);
+                    ++numNotModified;
+                }
+                response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NOT_MODIFIED);
+                response.send();
+                return;
+            }
+        }
+        else if(count <= numFaults)
+        {
+            if(fault == "unavailable")
+            {
+                response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_SERVICE_UNAVAILABLE);
+                response.send();
+                return;
+            }
+            else if(fault == "slow")
+            {
+                ofSleepMillis(SLOW_MILLIS);
+            }
+            else if(fault == "later")
+            {
+                response.set("Retry-After", "3600");
+                response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_SERVICE_UNAVAILABLE);
+                response.send();
+                return;
+            }
+        }
+
+        response.setContentType("text/plain");
+        response.send() << "ok";
+    }
+
+    int getCount(const std::string& path)
+    {
+        ofScopedLock lock(mutex);
+        return counts[path];
+    }
+
+    std::size_t getNumNonces()
+    {
+        ofScopedLock lock(mutex);
+        return nonces.size();
+    }
+
+    int getNumNotModified()
+    {
+        ofScopedLock lock(mutex);
+        return numNotModified;
+    }
+
+protected:
+    static std::string getNonce(const std::string& authorization)
+    {
+        std::string key = "oauth_nonce=\"";
+        std::size_t start = authorization.find(key);
+        if(start == std::string::npos) return "";
+        start += key.size();
+        return authorization.substr(start, authorization.find('"', start) - start);
+    }
+
+    std::map<std::string, int> counts;
+    std::set<std::string> nonces;
+    int numNotModified;
+
+    ofMutex mutex;
+
+};
+
+
+//------------------------------------------------------------------------------
+class RetryTests: public TestSuite
+{
+public:
+    RetryTests():
+        TestSuite("RetryTests")
+    {
+    }
+
+protected:
+    void run()
+    {
+        testDoesNotRetryByDefault();
+        testRetriesServerErrors();
+        testRetriesTimeouts();
+        testDoesNotRetryPosts();
+        testGivesUpOnLongRetryAfter();
+        testGivesUpAtTheDeadline();
+        testHedgesRevalidations();
+    }
+
+    static ofxOAuthRetryPolicy makePolicy(int maxAttempts)
+    {
+        ofxOAuthRetryPolicy policy;
+        policy.maxAttempts = maxAttempts;
+        policy.baseDelayMillis = 10;
+        return policy;
+    }
+
+    void testDoesNotRetryByDefault()
+    {
+        begin("does not retry by default");
+
+        FlakyApi api;
+        StandInServer server(api);
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+
+        ofxOAuthResponse response = client.getResponse("/unavailable/1");
+
+        TEST_CHECK(response.status == 503);
+        TEST_CHECK(response.attempts == 1);
+        TEST_CHECK(api.getCount("/unavailable/1") == 1);
+    }
+
+    void testRetriesServerErrors()
+    {
+        begin("retries 5xx, signing each attempt again");
+
+        FlakyApi api;
+        StandInServer server(api);
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+        client.setRetryPolicy(makePolicy(3));
+
+        ofxOAuthResponse response = client.getResponse("/unavailable/2");
+
+        TEST_CHECK(response.status == 200);
+        TEST_CHECK(response.attempts == 3);
+        TEST_CHECK(api.getCount("/unavailable/2") == 3);
+        TEST_CHECK(api.getNumNonces() == 3);
+
+        response = client.getResponse("/unavailable/5");
+
+        TEST_CHECK(response.status == 503);
+        TEST_CHECK(response.attempts == 3);
+    }
+
+    void testRetriesTimeouts()
+    {
+        begin("retries timeouts");
+
+        FlakyApi api;
+        StandInServer server(api);
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+        client.setRetryPolicy(makePolicy(2));
+        client.getTransport()->setTimeout(1);
+
+        ofxOAuthResponse response = client.getResponse("/slow/1");
+
+        TEST_CHECK(response.status == 200);
+        TEST_CHECK(response.attempts == 2);
+    }
+
+    void testDoesNotRetryPosts()
+    {
+        begin("does not retry a POST the server saw");
+
+        FlakyApi api;
+        StandInServer server(api);
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+        client.setRetryPolicy(makePolicy(3));
+
+        ofxOAuthResponse response = client.postResponse("/unavailable/1");
+
+        TEST_CHECK(response.status == 503);
+        TEST_CHECK(response.attempts == 1);
+        TEST_CHECK(api.getCount("/unavailable/1") == 1);
+    }
+
+    void testGivesUpOnLongRetryAfter()
+    {
+        begin("gives up when Retry-After is longer than maxDelayMillis");
+
+        FlakyApi api;
+        StandInServer server(api);
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+        client.setRetryPolicy(makePolicy(3));
+
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        ofxOAuthResponse response = client.getResponse("/later/1");
+
+        TEST_CHECK(response.status == 503);
+        TEST_CHECK(response.attempts == 1);
+        TEST_CHECK(ofGetElapsedTimeMillis() - startTime < 1000);
+    }
+
+    void testGivesUpAtTheDeadline()
+    {
+        begin("gives up at the deadline");
+
+        FlakyApi api;
+        StandInServer server(api);
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+
+        ofxOAuthRetryPolicy policy = makePolicy(10);
+        policy.deadlineMillis = 1000;
+        client.setRetryPolicy(policy);
+
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        ofxOAuthResponse response = client.getResponse("/slow/10");
+
+        TEST_CHECK(response.status != 200);
+        TEST_CHECK(ofGetElapsedTimeMillis() - startTime < 1500);
+    }
+
+    void testHedgesRevalidations()
+    {
+        begin("a hedged revalidation still gets a 304");
+
+        FlakyApi api;
+        StandInServer server(api);
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+
+        ofxOAuthRetryPolicy policy;
+        policy.hedgeGets = true;
+        policy.hedgeDelayMillis = 100;
+        client.setRetryPolicy(policy);
+
+        std::shared_ptr<ofxOAuthResponseCache> cache(new ofxOAuthResponseCache());
+        client.setResponseCache(cache);
+
+        client.getResponse("/revalidated/2");
+
+        // the first copy of the revalidation is slow, so the duplicate wins.
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        ofxOAuthResponse response = client.getResponse("/revalidated/2");
+
+        TEST_CHECK(response.status == 200 && response.fromCache);
+        TEST_CHECK(ofGetElapsedTimeMillis() - startTime < FlakyApi::SLOW_MILLIS);
+        TEST_CHECK(api.getCount("/revalidated/2") == 3);
+        TEST_CHECK(api.getNumNotModified() >= 1);
+        TEST_CHECK(cache->getStats().revalidations == 1);
+    }
+
+};
@@ -0,0 +1,132 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include "ofxOAuth.h"
+#include "AllocationCounter.h"
+#include "StandInServer.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Answers "ok" to everything.
+class OkApi: public StandInHandler
+{
+public:
+    void handle(Poco::Net::HTTPServerRequest& request,
+                Poco::Net::HTTPServerResponse& response)
+    {
+        response.setContentType("text/plain");
+        response.send() << "ok";
+    }
+
+};
+
+
+//------------------------------------------------------------------------------
+// Has NUM_CLIENTS live ofxOAuth clients take turns sending requests, first
+// each with its own transport and then all through one
+// ofxOAuthSharedContext, and compares the time, the connections the
+// stand-in accepted and the memory the clients' transports took.  Like
+// most apis, the stand-in closes connections that are idle for a while,
+// so a client with a connection of its own reconnects on its next turn.
+class SharedContextBenchmarks: public TestSuite
+{
+public:
+    enum
+    {
+        NUM_CLIENTS = 1000,
+        NUM_ROUNDS = 3
+    };
+
+    SharedContextBenchmarks():
+        TestSuite("SharedContextBenchmarks")
+    {
+    }
+
+protected:
+    void run()
+    {
+        OkApi api;
+        StandInServer server(api, 64, Poco::Timespan(0, 100000));
+
+        benchmark(server, false);
+        benchmark(server, true);
+    }
+
+    void benchmark(StandInServer& server, bool shared)
+    {
+        begin(std::string("benchmark ") + ofToString(NUM_CLIENTS) + " clients, " + (shared ? "shared context" : "own transports"));
+
+        std::shared_ptr<ofxOAuthSharedContext> context(new ofxOAuthSharedContext());
+
+        std::vector<std::shared_ptr<ofxOAuth> > clients;
+
+        for(int i = 0; i < NUM_CLIENTS; ++i)
+        {
+            clients.push_back(std::shared_ptr<ofxOAuth>(new ofxOAuth()));
+            setupClient(*clients.back(), server.getURL());
+            if(shared) clients.back()->setSharedContext(context);
+        }
+
+        long numLive = AllocationCounter::getNumLive();
+        std::size_t residentBytes = AllocationCounter::getResidentBytes();
+        int numConnections = server.getServer().totalConnections();
+        int numFailed = 0;
+
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        for(int round = 0; round < NUM_ROUNDS; ++round)
+        {
+            for(int i = 0; i < NUM_CLIENTS; ++i)
+            {
+                if(clients[i]->get("/resource", "a=" + ofToString(round)) != "ok") numFailed++;
+            }
+        }
+
+        unsigned long long elapsedMillis = std::max(1ULL, ofGetElapsedTimeMillis() - startTime);
+
+        numConnections = server.getServer().totalConnections() - numConnections;
+        long liveGrowth = AllocationCounter::getNumLive() - numLive;
+        long residentGrowth = (long)AllocationCounter::getResidentBytes() - (long)residentBytes;
+
+        ofLogNotice(name) << NUM_CLIENTS * NUM_ROUNDS << " requests in " << elapsedMillis << " ms ("
+                          << NUM_CLIENTS * NUM_ROUNDS * 1000ULL / elapsedMillis << " / s), "
+                          << numConnections << " connections, " << liveGrowth << " more live allocations and "
+                          << residentGrowth / 1024 << " KB more resident.";
+
+        TEST_CHECK(numFailed == 0);
+
+        if(shared)
+        {
+            // one keep-alive connection, taken in turn by every client.
+            TEST_CHECK(numConnections < NUM_ROUNDS);
+        }
+    }
+
+};
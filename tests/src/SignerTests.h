@@ -0,0 +1,96 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include "ofxOAuthSigner.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+class SignerTests: public TestSuite
+{
+public:
+    SignerTests():
+        TestSuite("SignerTests")
+    {
+    }
+
+protected:
+    void run()
+    {
+        testNormalizesURLs();
+        testSignsMixedCaseURLs();
+    }
+
+    void testNormalizesURLs()
+    {
+        begin("normalizes urls");
+
+        TEST_CHECK(ofxOAuthSigner::normalizeURL("HTTP://Example.COM/r?a=1#f") == "http://example.com/r");
+        TEST_CHECK(ofxOAuthSigner::normalizeURL("HTTPS://Example.com:443/Path") == "https://example.com/Path");
+        TEST_CHECK(ofxOAuthSigner::normalizeURL("http://example.com:80/") == "http://example.com/");
+        TEST_CHECK(ofxOAuthSigner::normalizeURL("http://example.com:8080/Path") == "http://example.com:8080/Path");
+        TEST_CHECK(ofxOAuthSigner::normalizeURL("https://Example.com") == "https://example.com");
+    }
+
+    void testSignsMixedCaseURLs()
+    {
+        begin("signs a mixed case url like its lowercase form");
+
+        std::string mixedHeader = sign("HTTPS://API.Example.com/1/Resource");
+        std::string lowerHeader = sign("https://api.example.com/1/Resource");
+
+        TEST_CHECK(!lowerHeader.empty());
+        TEST_CHECK(mixedHeader == lowerHeader);
+    }
+
+    // The Authorization header of a GET with a fixed nonce and timestamp.
+    static std::string sign(const std::string& url)
+    {
+        ofxOAuthParams params("a=1");
+        params.add("oauth_nonce", "nonce");
+        params.add("oauth_timestamp", "1380000000");
+
+        ofxOAuthHMACSHA1 signingKey;
+        signingKey.setKey(ofxOAuthSigner::makeKey("consumer-secret", "access-token-secret"));
+
+        std::string requestURL;
+        std::string header;
+
+        if(!ofxOAuthSigner::signRequest(params, "GET", url, OA_HMAC,
+                                        "consumer-key", "consumer-secret",
+                                        "access-token", signingKey, "",
+                                        requestURL, header))
+        {
+            return "";
+        }
+
+        return header;
+    }
+
+};
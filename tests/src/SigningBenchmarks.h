@@ -0,0 +1,157 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include "ofxOAuthMallocString.h"
+#include "ofxOAuthSigner.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Counts HMAC-SHA1 signatures per second of a typical signature base
+// string, signed with a key schedule that is cached per credential pair
+// (ofxOAuthHMACSHA1, set up once), with one that is rebuilt for every
+// signature, and with liboauth's oauth_sign_hmac_sha1, which the requests
+// used before.
+class SigningBenchmarks: public TestSuite
+{
+public:
+    SigningBenchmarks():
+        TestSuite("SigningBenchmarks")
+    {
+    }
+
+protected:
+    enum
+    {
+        NUM_SIGNATURES = 200000
+    };
+
+    void run()
+    {
+        key = ofxOAuthSigner::makeKey("consumer-secret-0123456789abcdefghij", "access-token-secret-0123456789abcdefghij");
+
+        // a GET with a few parameters, as a signed request would hash it.
+        base = "GET&https%3A%2F%2Fapi.example.com%2F1.1%2Fstatuses%2Fhome_timeline.json&count%3D200"
+               "%26include_entities%3Dtrue%26oauth_consumer_key%3Dconsumer-key%26oauth_nonce%3D"
+               "8f0e4c2b1a9d7e6f5c3b2a1908f7e6d5%26oauth_signature_method%3DHMAC-SHA1%26oauth_timestamp"
+               "%3D1380000000%26oauth_token%3Daccess-token%26oauth_version%3D1.0%26since_id%3D";
+
+        testMatchesLiboauth();
+        testBenchmark();
+    }
+
+    void testMatchesLiboauth()
+    {
+        begin("signs like liboauth");
+
+        ofxOAuthHMACSHA1 signingKey;
+        signingKey.setKey(key);
+
+        for(int i = 0; i < 100; ++i)
+        {
+            std::string message = base + ofToString(i);
+            ofxOAuthMallocString expected(oauth_sign_hmac_sha1(message.c_str(), key.c_str()));
+            TEST_CHECK(sign(signingKey, message) == expected.str());
+        }
+    }
+
+    void testBenchmark()
+    {
+        begin("benchmark signatures per second");
+
+        std::vector<std::string> messages;
+
+        for(int i = 0; i < 1000; ++i)
+        {
+            messages.push_back(base + ofToString(i));
+        }
+
+        // the signatures are summed up, so they can't be optimized away.
+        std::size_t cachedCheck = 0;
+        std::size_t uncachedCheck = 0;
+        std::size_t liboauthCheck = 0;
+
+        unsigned long long startTime = ofGetElapsedTimeMicros();
+
+        ofxOAuthHMACSHA1 signingKey;
+        signingKey.setKey(key);
+
+        for(int i = 0; i < NUM_SIGNATURES; ++i)
+        {
+            cachedCheck += sign(signingKey, messages[i % messages.size()])[0];
+        }
+
+        double cachedRate = getRate(startTime);
+
+        startTime = ofGetElapsedTimeMicros();
+
+        for(int i = 0; i < NUM_SIGNATURES; ++i)
+        {
+            ofxOAuthHMACSHA1 freshKey;
+            freshKey.setKey(key);
+            uncachedCheck += sign(freshKey, messages[i % messages.size()])[0];
+        }
+
+        double uncachedRate = getRate(startTime);
+
+        startTime = ofGetElapsedTimeMicros();
+
+        for(int i = 0; i < NUM_SIGNATURES; ++i)
+        {
+            ofxOAuthMallocString signature(oauth_sign_hmac_sha1(messages[i % messages.size()].c_str(), key.c_str()));
+            liboauthCheck += signature.str()[0];
+        }
+
+        double liboauthRate = getRate(startTime);
+
+        ofLogNotice(name) << base.size() << " byte base strings, signatures per second: cached key schedule "
+                          << (long)cachedRate << ", rebuilt per signature " << (long)uncachedRate
+                          << ", oauth_sign_hmac_sha1 " << (long)liboauthRate;
+
+        TEST_CHECK(cachedCheck == uncachedCheck && cachedCheck == liboauthCheck);
+        TEST_CHECK(cachedRate > uncachedRate);
+    }
+
+    static std::string sign(const ofxOAuthHMACSHA1& signingKey, const std::string& message)
+    {
+        unsigned char digest[ofxOAuthSHA1::DIGEST_SIZE];
+        signingKey.sign(message.data(), message.size(), digest);
+        return ofxOAuthSigner::encodeBase64(digest, sizeof(digest));
+    }
+
+    static double getRate(unsigned long long startTime)
+    {
+        unsigned long long elapsedMicros = std::max(1ULL, ofGetElapsedTimeMicros() - startTime);
+        return NUM_SIGNATURES * 1000000.0 / elapsedMicros;
+    }
+
+    std::string key;
+    std::string base;
+
+};
@@ -0,0 +1,174 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include "Poco/DeflatingStream.h"
+#include "Poco/Net/HTTPRequestHandler.h"
+#include "Poco/Net/HTTPRequestHandlerFactory.h"
+#include "Poco/Net/HTTPServer.h"
+#include "Poco/Net/HTTPServerParams.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include "Poco/Net/HTTPServerResponse.h"
+#include "Poco/Net/ServerSocket.h"
+#include "Poco/Net/SocketAddress.h"
+#include "Poco/ThreadPool.h"
+#include "Poco/Timespan.h"
+#include "ofMain.h"
+
+
+//------------------------------------------------------------------------------
+// Answers the requests made to a StandInServer.  handle() is called from
+// the server's threads, several at a time, so keep any state locked.
+class StandInHandler
+{
+public:
+    virtual ~StandInHandler()
+    {
+    }
+
+    virtual void handle(Poco::Net::HTTPServerRequest& request,
+                        Poco::Net::HTTPServerResponse& response) = 0;
+
+    // Sends body gzip compressed, with Content-Encoding: gzip, when the
+    // request offers gzip in its Accept-Encoding, and plain otherwise.
+    static void sendBody(Poco::Net::HTTPServerRequest& request,
+                         Poco::Net::HTTPServerResponse& response,
+                         const std::string& body)
+    {
+        if(request.get("Accept-Encoding", "").find("gzip") == std::string::npos)
+        {
+            response.sendBuffer(body.data(), body.size());
+            return;
+        }
+
+        std::ostringstream compressed;
+        Poco::DeflatingOutputStream deflater(compressed, Poco::DeflatingStreamBuf::STREAM_GZIP);
+        deflater.write(body.data(), body.size());
+        deflater.close();
+
+        std::string gzipped = compressed.str();
+        response.set("Content-Encoding", "gzip");
+        response.sendBuffer(gzipped.data(), gzipped.size());
+    }
+
+};
+
+
+//------------------------------------------------------------------------------
+// A local http server that stands in for an api while testing.  It listens
+// on an ephemeral port of 127.0.0.1 for as long as it exists.  Each open
+// connection takes one of maxThreads threads of a pool of its own (Poco's
+// default pool has only 16) until it has been idle for keepAliveTimeout.
+class StandInServer
+{
+public:
+    StandInServer(StandInHandler& handler,
+                  int maxThreads = 16,
+                  const Poco::Timespan& keepAliveTimeout = Poco::Timespan(1, 0)):
+        socket(Poco::Net::SocketAddress("127.0.0.1", 0)),
+        threads(1, maxThreads),
+        server(NULL)
+    {
+        Poco::Net::HTTPServerParams* params = new Poco::Net::HTTPServerParams();
+        params->setMaxThreads(maxThreads);
+        params->setMaxQueued(1024);
+        params->setKeepAlive(true);
+
+        // idle connections end quickly, so the destructor need not wait long.
+        params->setKeepAliveTimeout(keepAliveTimeout);
+
+        server = new Poco::Net::HTTPServer(new Factory(handler), threads, socket, params);
+        server->start();
+    }
+
+    // Waits for the connections still open, as they use the handler.
+    virtual ~StandInServer()
+    {
+        server->stop();
+
+        while(server->currentConnections() > 0)
+        {
+            ofSleepMillis(10);
+        }
+
+        delete server;
+    }
+
+    // e.g. http://127.0.0.1:54321
+    std::string getURL() const
+    {
+        return "http://127.0.0.1:" + ofToString(socket.address().port());
+    }
+
+    Poco::Net::HTTPServer& getServer()
+    {
+        return *server;
+    }
+
+protected:
+    class Forwarder: public Poco::Net::HTTPRequestHandler
+    {
+    public:
+        Forwarder(StandInHandler& _handler):
+            handler(_handler)
+        {
+        }
+
+        void handleRequest(Poco::Net::HTTPServerRequest& request,
+                           Poco::Net::HTTPServerResponse& response)
+        {
+            handler.handle(request, response);
+        }
+
+        StandInHandler& handler;
+    };
+
+    class Factory: public Poco::Net::HTTPRequestHandlerFactory
+    {
+    public:
+        Factory(StandInHandler& _handler):
+            handler(_handler)
+        {
+        }
+
+        Poco::Net::HTTPRequestHandler* createRequestHandler(const Poco::Net::HTTPServerRequest&)
+        {
+            return new Forwarder(handler);
+        }
+
+        StandInHandler& handler;
+    };
+
+    Poco::Net::ServerSocket socket;
+    Poco::ThreadPool threads; // outlives the server, which is deleted first
+    Poco::Net::HTTPServer* server;
+
+private:
+    StandInServer(const StandInServer&);
+    StandInServer& operator = (const StandInServer&);
+
+};
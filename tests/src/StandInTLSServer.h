@@ -0,0 +1,164 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include "Poco/Net/ServerSocket.h"
+#include "Poco/Net/SocketAddress.h"
+#include "Poco/Net/StreamSocket.h"
+#include "Poco/Timespan.h"
+#include "ofMain.h"
+
+
+//------------------------------------------------------------------------------
+// A minimal https server for timing handshakes.  It answers every request
+// with "ok" and closes the connection, so each request costs a full TLS
+// handshake.  With keepAlive it instead serves requests on a connection
+// until the client closes it, so close the client's connections before
+// the server is destroyed.  Connections are served one at a time.
+class StandInTLSServer: public ofThread
+{
+public:
+    StandInTLSServer(const std::string& certificatePath,
+                     const std::string& privateKeyPath,
+                     bool _keepAlive = false):
+        context(NULL),
+        keepAlive(_keepAlive)
+    {
+        SSL_library_init();
+        SSL_load_error_strings();
+
+        context = SSL_CTX_new(SSLv23_server_method());
+
+        if(SSL_CTX_use_certificate_file(context, certificatePath.c_str(), SSL_FILETYPE_PEM) != 1 ||
+           SSL_CTX_use_PrivateKey_file(context, privateKeyPath.c_str(), SSL_FILETYPE_PEM) != 1)
+        {
+            ofLogError("StandInTLSServer") << "Could not load " << certificatePath << " / " << privateKeyPath;
+            ERR_clear_error();
+        }
+
+        socket.bind(Poco::Net::SocketAddress("127.0.0.1", 0));
+        socket.listen();
+
+        startThread(true, false);
+    }
+
+    virtual ~StandInTLSServer()
+    {
+        stopThread();
+        waitForThread(false);
+        socket.close();
+        SSL_CTX_free(context);
+    }
+
+    // e.g. https://127.0.0.1:54321, the name in the certificate.
+    std::string getURL() const
+    {
+        return "https://127.0.0.1:" + ofToString(socket.address().port());
+    }
+
+    void threadedFunction()
+    {
+        while(isThreadRunning())
+        {
+            try
+            {
+                if(socket.poll(Poco::Timespan(0, 100000), Poco::Net::Socket::SELECT_READ))
+                {
+                    Poco::Net::StreamSocket client = socket.acceptConnection();
+                    serve(client);
+                    client.close();
+                }
+            }
+            catch(const Poco::Exception& exc)
+            {
+                ofLogError("StandInTLSServer::threadedFunction") << exc.displayText();
+            }
+        }
+    }
+
+protected:
+    void serve(Poco::Net::StreamSocket& client)
+    {
+        SSL* ssl = SSL_new(context);
+        SSL_set_fd(ssl, client.impl()->sockfd());
+
+        if(SSL_accept(ssl) == 1)
+        {
+            static const char closeReply[] = "HTTP/1.1 200 OK\r\n"
+                                             "Content-Length: 2\r\n"
+                                             "Connection: close\r\n\r\n"
+                                             "ok";
+
+            static const char keepAliveReply[] = "HTTP/1.1 200 OK\r\n"
+                                                 "Content-Length: 2\r\n"
+                                                 "Connection: keep-alive\r\n\r\n"
+                                                 "ok";
+
+            // the requests have no body, so each ends with its headers.
+            std::string requests;
+            char buffer[1024];
+            bool open = true;
+
+            while(open)
+            {
+                std::size_t end = requests.find("\r\n\r\n");
+
+                if(end == std::string::npos)
+                {
+                    int n = SSL_read(ssl, buffer, sizeof(buffer));
+                    if(n <= 0) break;
+                    requests.append(buffer, n);
+                    continue;
+                }
+
+                requests.erase(0, end + 4);
+
+                if(keepAlive)
+                {
+                    open = SSL_write(ssl, keepAliveReply, sizeof(keepAliveReply) - 1) > 0;
+                }
+                else
+                {
+                    SSL_write(ssl, closeReply, sizeof(closeReply) - 1);
+                    open = false;
+                }
+            }
+
+            SSL_shutdown(ssl);
+        }
+
+        SSL_free(ssl);
+        ERR_clear_error();
+    }
+
+    SSL_CTX* context;
+    bool keepAlive;
+    Poco::Net::ServerSocket socket;
+
+};
@@ -0,0 +1,168 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include "ofxOAuth.h"
+#include "AllocationCounter.h"
+#include "StandInServer.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Stands in for an api and its token endpoints, with answers that are the
+// same every time.
+class TokenApi: public StandInHandler
+{
+public:
+    void handle(Poco::Net::HTTPServerRequest& request,
+                Poco::Net::HTTPServerResponse& response)
+    {
+        std::string path = request.getURI().substr(0, request.getURI().find('?'));
+
+        response.setContentType("text/plain");
+
+        if(path == "/request_token")
+        {
+            response.send() << "oauth_token=request-token&oauth_token_secret=request-token-secret&oauth_callback_confirmed=true";
+        }
+        else if(path == "/access_token")
+        {
+            response.send() << "oauth_token=access-token&oauth_token_secret=access-token-secret";
+        }
+        else
+        {
+            response.send() << "ok";
+        }
+    }
+
+};
+
+
+//------------------------------------------------------------------------------
+// Makes the token exchange callable from the tests.
+class StressClient: public ofxOAuth
+{
+public:
+    using ofxOAuth::obtainRequestToken;
+    using ofxOAuth::obtainAccessToken;
+
+};
+
+
+//------------------------------------------------------------------------------
+// Runs NUM_REQUESTS requests through get(), post(), obtainRequestToken()
+// and obtainAccessToken() in turn, and checks that neither the number of
+// live allocations nor the resident set size grow once the pools and
+// caches are warm.  Takes a minute or so.
+class StressTests: public TestSuite
+{
+public:
+    enum
+    {
+        NUM_REQUESTS = 100000,
+        NUM_WARMUP_REQUESTS = 5000,
+        MAX_LIVE_GROWTH = 100,
+        MAX_RESIDENT_GROWTH = 2 * 1024 * 1024
+    };
+
+    StressTests():
+        TestSuite("StressTests")
+    {
+    }
+
+protected:
+    void run()
+    {
+        testFlatMemory();
+    }
+
+    void testFlatMemory()
+    {
+        begin("memory stays flat over " + ofToString(NUM_REQUESTS) + " requests");
+
+        TokenApi api;
+        StandInServer server(api);
+
+        std::string credentialsPathname = ofToDataPath("StressTests.xml", true);
+
+        StressClient client;
+        setupClient(client, server.getURL());
+        client.setRequestTokenURL(server.getURL() + "/request_token");
+        client.setAccessTokenURL(server.getURL() + "/access_token");
+        client.setCredentialsPathname(credentialsPathname);
+
+        long numAllocations = 0;
+        long numLive = 0;
+        std::size_t residentBytes = 0;
+        int numFailed = 0;
+
+        for(int i = 0; i < NUM_REQUESTS; ++i)
+        {
+            if(i == NUM_WARMUP_REQUESTS)
+            {
+                numAllocations = AllocationCounter::getNumAllocations();
+                numLive = AllocationCounter::getNumLive();
+                residentBytes = AllocationCounter::getResidentBytes();
+            }
+
+            switch(i % 4)
+            {
+                case 0:
+                    if(client.get("/resource", "a=1") != "ok") numFailed++;
+                    break;
+                case 1:
+                    if(client.post("/resource", "a=1") != "ok") numFailed++;
+                    break;
+                case 2:
+                    if(client.obtainRequestToken()["oauth_token"] != "request-token") numFailed++;
+                    break;
+                case 3:
+                    client.setRequestTokenVerifier("verifier");
+                    if(client.obtainAccessToken()["oauth_token"] != "access-token") numFailed++;
+                    break;
+            }
+        }
+
+        long numMeasured = NUM_REQUESTS - NUM_WARMUP_REQUESTS;
+        long liveGrowth = AllocationCounter::getNumLive() - numLive;
+        long residentGrowth = (long)AllocationCounter::getResidentBytes() - (long)residentBytes;
+
+        ofLogNotice(name) << (AllocationCounter::getNumAllocations() - numAllocations) / numMeasured
+                          << " allocations per request, " << liveGrowth << " more live allocations and "
+                          << residentGrowth / 1024 << " KB more resident after " << numMeasured << " requests.";
+
+        TEST_CHECK(numFailed == 0);
+        TEST_CHECK(liveGrowth <= MAX_LIVE_GROWTH);
+
+        // 0 where the resident set size can't be measured.
+        TEST_CHECK(residentBytes == 0 || residentGrowth <= MAX_RESIDENT_GROWTH);
+
+        ofFile::removeFile(credentialsPathname, false);
+    }
+
+};
@@ -0,0 +1,195 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <sstream>
+#include "Poco/String.h"
+#include "ofxOAuthTemplate.h"
+#include "ofxOAuthTransport.h"
+#include "ofxOAuthVerifierCallbackServer.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Fetches a page over and over and counts the answers that weren't a 200.
+class PageBrowser: public ofThread
+{
+public:
+    PageBrowser(const std::string& _url, int _numRequests):
+        url(_url),
+        numRequests(_numRequests),
+        numFailed(0)
+    {
+    }
+
+    void threadedFunction()
+    {
+        ofxOAuthTransport transport;
+
+        for(int i = 0; i < numRequests; ++i)
+        {
+            ofxOAuthTransportResult result;
+
+            if(!transport.get(url, "", result) || result.status != 200)
+            {
+                numFailed++;
+            }
+        }
+    }
+
+    std::string url;
+    int numRequests;
+    int numFailed;
+
+};
+
+
+//------------------------------------------------------------------------------
+// How fast the callback server produces the bundled index.html: rendering
+// the compiled page against reading and replacing it every time, as the
+// server used to, and then served over http.
+class TemplateBenchmarks: public TestSuite
+{
+public:
+    enum
+    {
+        NUM_RENDERS = 100000,
+        NUM_REQUESTS = 10000,
+        NUM_BROWSERS = 8
+    };
+
+    TemplateBenchmarks():
+        TestSuite("TemplateBenchmarks"),
+        docRoot("VerifierCallbackServer/")
+    {
+    }
+
+protected:
+    void run()
+    {
+        testRendersIndex();
+        testServesIndex();
+    }
+
+    void testRendersIndex()
+    {
+        begin("renders index.html " + ofToString(NUM_RENDERS) + " times");
+
+        std::string pathname = ofToDataPath(docRoot + "index.html", true);
+
+        std::string values[ofxOAuthTemplate::NUM_SLOTS];
+        values[ofxOAuthTemplate::QUERY] = "<ul><li>oauth_token=token&amp;oauth_verifier=verifier</li></ul>";
+        values[ofxOAuthTemplate::GET_PARAMS] = "<ul><li>oauth_token=token</li><li>oauth_verifier=verifier</li></ul>";
+        values[ofxOAuthTemplate::HEADERS] = "<ul><li>Host=127.0.0.1</li><li>Accept=*/*</li></ul>";
+
+        std::string replaced;
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        for(int i = 0; i < NUM_RENDERS; ++i)
+        {
+            std::string page = ofBufferFromFile(pathname).getText();
+
+            for(int slot = 0; slot < ofxOAuthTemplate::NUM_SLOTS; ++slot)
+            {
+                Poco::replaceInPlace(page,
+                                     std::string("{@") + ofxOAuthTemplate::getSlotName((ofxOAuthTemplate::Slot)slot) + "}",
+                                     values[slot]);
+            }
+
+            std::ostringstream out;
+            out << page;
+            replaced = out.str();
+        }
+
+        unsigned long long replaceMillis = std::max(1ULL, ofGetElapsedTimeMillis() - startTime);
+
+        ofxOAuthTemplateCache templates;
+        std::string rendered;
+        startTime = ofGetElapsedTimeMillis();
+
+        for(int i = 0; i < NUM_RENDERS; ++i)
+        {
+            std::shared_ptr<const ofxOAuthTemplate> page = templates.get(pathname);
+
+            std::ostringstream out;
+            page->render(out, values);
+            rendered = out.str();
+        }
+
+        unsigned long long renderMillis = std::max(1ULL, ofGetElapsedTimeMillis() - startTime);
+
+        ofLogNotice(name) << "read and replace " << NUM_RENDERS * 1000ULL / replaceMillis << " pages / s, "
+                          << "compiled " << NUM_RENDERS * 1000ULL / renderMillis << " pages / s.";
+
+        TEST_CHECK(!rendered.empty());
+        TEST_CHECK(rendered == replaced);
+    }
+
+    void testServesIndex()
+    {
+        begin("serves index.html " + ofToString(NUM_REQUESTS) + " times");
+
+        ofxOAuthVerifierCallbackServer server(NULL, docRoot);
+        server.setNumWorkers(NUM_BROWSERS);
+        TEST_CHECK(server.start());
+
+        std::vector<std::shared_ptr<PageBrowser> > browsers;
+
+        for(int i = 0; i < NUM_BROWSERS; ++i)
+        {
+            browsers.push_back(std::shared_ptr<PageBrowser>(new PageBrowser(server.getURL() + "/", NUM_REQUESTS / NUM_BROWSERS)));
+        }
+
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        for(std::size_t i = 0; i < browsers.size(); ++i)
+        {
+            browsers[i]->startThread(false, false);
+        }
+
+        int numFailed = 0;
+
+        for(std::size_t i = 0; i < browsers.size(); ++i)
+        {
+            browsers[i]->waitForThread(false);
+            numFailed += browsers[i]->numFailed;
+        }
+
+        unsigned long long elapsedMillis = std::max(1ULL, ofGetElapsedTimeMillis() - startTime);
+
+        server.stop();
+
+        ofLogNotice(name) << NUM_REQUESTS << " requests in " << elapsedMillis << " ms ("
+                          << NUM_REQUESTS * 1000ULL / elapsedMillis << " / s).";
+
+        TEST_CHECK(numFailed == 0);
+    }
+
+    std::string docRoot;
+
+};
@@ -0,0 +1,114 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include "ofMain.h"
+#include "ofxOAuth.h"
+
+
+// Fails the current test case with the expression and where it is, but
+// carries on with the rest of it.
+#define TEST_CHECK(expr) check((expr), #expr, __FILE__, __LINE__)
+
+
+//------------------------------------------------------------------------------
+// A group of test cases.  run() calls begin() before each case and the
+// TEST_CHECK()s of the case; runAll() returns the number that failed.
+class TestSuite
+{
+public:
+    TestSuite(const std::string& _name):
+        name(_name),
+        numChecks(0),
+        numFailed(0)
+    {
+    }
+
+    virtual ~TestSuite()
+    {
+    }
+
+    std::size_t runAll()
+    {
+        numChecks = 0;
+        numFailed = 0;
+
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        run();
+
+        ofLogNotice(name) << numChecks - numFailed << " / " << numChecks
+                          << " checks passed in " << ofGetElapsedTimeMillis() - startTime << " ms.";
+
+        return numFailed;
+    }
+
+    const std::string& getName() const
+    {
+        return name;
+    }
+
+protected:
+    virtual void run() = 0;
+
+    // Signs for made up credentials against apiURL, e.g. a stand-in
+    // server's, so that no authorization is needed.
+    static void setupClient(ofxOAuth& client, const std::string& apiURL)
+    {
+        client.setApiURL(apiURL, false);
+        client.setConsumerKey("consumer-key");
+        client.setConsumerSecret("consumer-secret");
+        client.setAccessToken("access-token");
+        client.setAccessTokenSecret("access-token-secret");
+    }
+
+    void begin(const std::string& caseName)
+    {
+        currentCase = caseName;
+        ofLogNotice(name) << caseName;
+    }
+
+    bool check(bool passed, const char* expression, const char* file, int line)
+    {
+        numChecks++;
+
+        if(!passed)
+        {
+            numFailed++;
+            ofLogError(name) << currentCase << ": " << expression
+                             << " failed at " << file << ":" << line;
+        }
+
+        return passed;
+    }
+
+    std::string name;
+    std::string currentCase;
+    std::size_t numChecks;
+    std::size_t numFailed;
+
+};
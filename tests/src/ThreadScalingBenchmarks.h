@@ -0,0 +1,178 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include "ofxOAuth.h"
+#include "StandInServer.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Answers "ok", and counts the requests that weren't signed or came with
+// the wrong method: /get must be a GET and /post a POST.
+class MethodCheckingApi: public StandInHandler
+{
+public:
+    MethodCheckingApi():
+        numWrong(0)
+    {
+    }
+
+    void handle(Poco::Net::HTTPServerRequest& request,
+                Poco::Net::HTTPServerResponse& response)
+    {
+        std::string path = request.getURI().substr(0, request.getURI().find('?'));
+        std::string expectedMethod = path == "/post" ? "POST" : "GET";
+
+        if(request.getMethod() != expectedMethod ||
+           request.get("Authorization", "").compare(0, 6, "OAuth ") != 0)
+        {
+            ofScopedLock lock(mutex);
+            numWrong++;
+        }
+
+        response.setContentType("text/plain");
+        response.send() << "ok";
+    }
+
+    int getNumWrong()
+    {
+        ofScopedLock lock(mutex);
+        return numWrong;
+    }
+
+private:
+    int numWrong;
+    ofMutex mutex;
+
+};
+
+
+//------------------------------------------------------------------------------
+// Sends gets and posts through a client shared with other threads, and
+// counts the ones that failed.
+class SharedClientCaller: public ofThread
+{
+public:
+    SharedClientCaller(ofxOAuth& _client, int _numRequests):
+        client(_client),
+        numRequests(_numRequests),
+        numFailed(0)
+    {
+    }
+
+    void threadedFunction()
+    {
+        for(int i = 0; i < numRequests; ++i)
+        {
+            std::string body = i % 2 == 0 ? client.get("/get", "a=" + ofToString(i))
+                                          : client.post("/post", "a=" + ofToString(i));
+
+            if(body != "ok") numFailed++;
+        }
+    }
+
+    ofxOAuth& client;
+    int numRequests;
+    int numFailed;
+
+};
+
+
+//------------------------------------------------------------------------------
+// Counts the requests per second that 1 to 32 threads get through one
+// shared ofxOAuth instance, signing against its credentials snapshot.
+class ThreadScalingBenchmarks: public TestSuite
+{
+public:
+    enum
+    {
+        NUM_REQUESTS = 8000,
+        MAX_THREADS = 32
+    };
+
+    ThreadScalingBenchmarks():
+        TestSuite("ThreadScalingBenchmarks")
+    {
+    }
+
+protected:
+    void run()
+    {
+        MethodCheckingApi api;
+        StandInServer server(api, MAX_THREADS);
+
+        ofxOAuth client;
+        setupClient(client, server.getURL());
+
+        // a keep-alive connection per thread, so no thread has to reconnect.
+        client.getTransport()->setMaxIdleHandlesPerHost(MAX_THREADS);
+
+        for(int numThreads = 1; numThreads <= MAX_THREADS; numThreads *= 2)
+        {
+            benchmark(client, numThreads);
+        }
+
+        TEST_CHECK(api.getNumWrong() == 0);
+    }
+
+    void benchmark(ofxOAuth& client, int numThreads)
+    {
+        begin("benchmark " + ofToString(numThreads) + " threads");
+
+        std::vector<std::shared_ptr<SharedClientCaller> > callers;
+
+        for(int i = 0; i < numThreads; ++i)
+        {
+            callers.push_back(std::shared_ptr<SharedClientCaller>(new SharedClientCaller(client, NUM_REQUESTS / numThreads)));
+        }
+
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        for(std::size_t i = 0; i < callers.size(); ++i)
+        {
+            callers[i]->startThread(false, false);
+        }
+
+        int numFailed = 0;
+
+        for(std::size_t i = 0; i < callers.size(); ++i)
+        {
+            callers[i]->waitForThread(false);
+            numFailed += callers[i]->numFailed;
+        }
+
+        unsigned long long elapsedMillis = std::max(1ULL, ofGetElapsedTimeMillis() - startTime);
+
+        ofLogNotice(name) << numThreads << " threads: " << NUM_REQUESTS << " requests in " << elapsedMillis << " ms ("
+                          << NUM_REQUESTS * 1000ULL / elapsedMillis << " / s).";
+
+        TEST_CHECK(numFailed == 0);
+    }
+
+};
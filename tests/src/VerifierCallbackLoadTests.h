@@ -0,0 +1,175 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include "ofxOAuthTransport.h"
+#include "ofxOAuthVerifierCallbackServer.h"
+#include "TestSuite.h"
+#include "VerifierCallbackServerTests.h"
+
+
+//------------------------------------------------------------------------------
+// Plays a browser being redirected to the callback server, for a range of
+// simulated authorization flows.  The server answers 503 when all of its
+// workers are busy, those redirects are sent again.
+class RedirectingBrowser: public ofThread
+{
+public:
+    RedirectingBrowser(const std::string& _url, int _first, int _last):
+        url(_url),
+        first(_first),
+        last(_last),
+        numFailed(0),
+        numRefused(0)
+    {
+    }
+
+    void threadedFunction()
+    {
+        ofxOAuthTransport transport;
+
+        for(int i = first; i < last; ++i)
+        {
+            std::string redirect = url + "?oauth_token=token-" + ofToString(i) + "&oauth_verifier=verifier-" + ofToString(i);
+
+            for(;;)
+            {
+                ofxOAuthTransportResult result;
+
+                if(!transport.get(redirect, "", result))
+                {
+                    numFailed++;
+                    break;
+                }
+
+                if(result.status != 503) break;
+
+                numRefused++;
+                ofSleepMillis(1);
+            }
+        }
+    }
+
+    std::string url;
+    int first;
+    int last;
+    int numFailed;
+    int numRefused;
+
+};
+
+
+//------------------------------------------------------------------------------
+// Runs many authorization flows at once through one shared callback server.
+class VerifierCallbackLoadTests: public TestSuite
+{
+public:
+    enum
+    {
+        NUM_FLOWS = 10000,
+        NUM_BROWSERS = 8
+    };
+
+    VerifierCallbackLoadTests():
+        TestSuite("VerifierCallbackLoadTests")
+    {
+    }
+
+protected:
+    void run()
+    {
+        testRoutesRedirects();
+    }
+
+    void testRoutesRedirects()
+    {
+        begin("routes " + ofToString(NUM_FLOWS) + " redirects to their clients");
+
+        // outlive the server, which has no callback of its own.
+        std::vector<std::shared_ptr<VerifierRecorder> > clients;
+
+        ofxOAuthVerifierCallbackServer server(NULL);
+        server.setNumWorkers(NUM_BROWSERS);
+
+        for(int i = 0; i < NUM_FLOWS; ++i)
+        {
+            clients.push_back(std::shared_ptr<VerifierRecorder>(new VerifierRecorder()));
+            server.addRoute("token-" + ofToString(i), clients.back().get());
+        }
+
+        TEST_CHECK(server.start());
+
+        std::vector<std::shared_ptr<RedirectingBrowser> > browsers;
+
+        for(int i = 0; i < NUM_BROWSERS; ++i)
+        {
+            browsers.push_back(std::shared_ptr<RedirectingBrowser>(new RedirectingBrowser(server.getURL(),
+                                                                                          i * NUM_FLOWS / NUM_BROWSERS,
+                                                                                          (i + 1) * NUM_FLOWS / NUM_BROWSERS)));
+        }
+
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        for(std::size_t i = 0; i < browsers.size(); ++i)
+        {
+            browsers[i]->startThread(false, false);
+        }
+
+        int numFailed = 0;
+        int numRefused = 0;
+
+        for(std::size_t i = 0; i < browsers.size(); ++i)
+        {
+            browsers[i]->waitForThread(false);
+            numFailed += browsers[i]->numFailed;
+            numRefused += browsers[i]->numRefused;
+        }
+
+        unsigned long long elapsedMillis = std::max(1ULL, ofGetElapsedTimeMillis() - startTime);
+
+        server.stop();
+
+        int numDelivered = 0;
+
+        for(int i = 0; i < NUM_FLOWS; ++i)
+        {
+            if(clients[i]->getToken() == "token-" + ofToString(i) &&
+               clients[i]->getVerifier() == "verifier-" + ofToString(i))
+            {
+                numDelivered++;
+            }
+        }
+
+        ofLogNotice(name) << NUM_FLOWS << " redirects in " << elapsedMillis << " ms ("
+                          << NUM_FLOWS * 1000ULL / elapsedMillis << " / s), " << numRefused << " refused and sent again.";
+
+        TEST_CHECK(numFailed == 0);
+        TEST_CHECK(numDelivered == NUM_FLOWS);
+    }
+
+};
@@ -0,0 +1,354 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include "Poco/Net/StreamSocket.h"
+#include "ofxOAuthTransport.h"
+#include "ofxOAuthVerifierCallbackServer.h"
+#include "TestSuite.h"
+
+
+//------------------------------------------------------------------------------
+// Remembers the verifier the callback server hands over.
+class VerifierRecorder: public ofxOAuthVerifierCallbackInterface
+{
+public:
+    void setRequestTokenVerifier(const std::string& requestToken,
+                                 const std::string& requestTokenVerifier)
+    {
+        ofScopedLock lock(mutex);
+        token = requestToken;
+        verifier = requestTokenVerifier;
+    }
+
+    void receivedVerifierCallbackRequest(const Poco::Net::HTTPServerRequest&) {}
+    void receivedVerifierCallbackHeaders(const Poco::Net::NameValueCollection&) {}
+    void receivedVerifierCallbackCookies(const Poco::Net::NameValueCollection&) {}
+    void receivedVerifierCallbackGetParams(const Poco::Net::NameValueCollection&) {}
+    void receivedVerifierCallbackPostParams(const Poco::Net::NameValueCollection&) {}
+
+    std::string getToken()
+    {
+        ofScopedLock lock(mutex);
+        return token;
+    }
+
+    std::string getVerifier()
+    {
+        ofScopedLock lock(mutex);
+        return verifier;
+    }
+
+protected:
+    std::string token;
+    std::string verifier;
+    ofMutex mutex;
+
+};
+
+
+//------------------------------------------------------------------------------
+// Measures how long the callback server takes to start and stop, including
+// while a browser holds idle (preconnected) connections to it, since the
+// authorization flow waits for stop() before it asks for the access token.
+class VerifierCallbackServerTests: public TestSuite
+{
+public:
+    VerifierCallbackServerTests():
+        TestSuite("VerifierCallbackServerTests")
+    {
+    }
+
+protected:
+    enum
+    {
+        // well under SESSION_TIMEOUT_SECONDS.
+        MAX_STOP_MILLIS = 500
+    };
+
+    void run()
+    {
+        testStartsAndStopsQuickly();
+        testStopsQuicklyWithIdleConnections();
+        testDeliversTheVerifier();
+        testRefusesConnectionsBeyondItsWorkers();
+        testServesStaticFiles();
+        testAnswersIfNoneMatch();
+        testAnswersIfModifiedSince();
+        testRemapsChangedFiles();
+    }
+
+    void testStartsAndStopsQuickly()
+    {
+        begin("starts and stops quickly");
+
+        VerifierRecorder recorder;
+
+        for(int i = 0; i < 10; ++i)
+        {
+            ofxOAuthVerifierCallbackServer server(&recorder);
+
+            unsigned long long startTime = ofGetElapsedTimeMicros();
+            TEST_CHECK(server.start());
+            unsigned long long startedTime = ofGetElapsedTimeMicros();
+            server.stop();
+            unsigned long long stoppedTime = ofGetElapsedTimeMicros();
+
+            TEST_CHECK(stoppedTime - startedTime < MAX_STOP_MILLIS * 1000);
+
+            ofLogNotice(name) << "start " << (startedTime - startTime) << " us, stop " << (stoppedTime - startedTime) << " us";
+        }
+    }
+
+    void testStopsQuicklyWithIdleConnections()
+    {
+        begin("stops quickly with idle connections open");
+
+        VerifierRecorder recorder;
+        ofxOAuthVerifierCallbackServer server(&recorder);
+        TEST_CHECK(server.start());
+
+        // like a browser's speculative preconnects, they never send a request.
+        std::vector<Poco::Net::StreamSocket> idle;
+
+        for(int i = 0; i < ofxOAuthVerifierCallbackServer::DEFAULT_NUM_WORKERS; ++i)
+        {
+            idle.push_back(Poco::Net::StreamSocket(Poco::Net::SocketAddress("127.0.0.1", (Poco::UInt16)server.getPort())));
+        }
+
+        // let the server accept them.
+        ofSleepMillis(100);
+
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+        server.stop();
+        unsigned long long stopMillis = ofGetElapsedTimeMillis() - startTime;
+
+        TEST_CHECK(stopMillis < MAX_STOP_MILLIS);
+
+        ofLogNotice(name) << "stop with " << idle.size() << " idle connections " << stopMillis << " ms";
+    }
+
+    void testDeliversTheVerifier()
+    {
+        begin("delivers the verifier");
+
+        VerifierRecorder recorder;
+        ofxOAuthVerifierCallbackServer server(&recorder);
+        TEST_CHECK(server.start());
+
+        ofxOAuthTransport transport;
+        ofxOAuthTransportResult result;
+        TEST_CHECK(transport.get(server.getURL() + "?oauth_token=token&oauth_verifier=verifier", "", result));
+
+        TEST_CHECK(recorder.getToken() == "token");
+        TEST_CHECK(recorder.getVerifier() == "verifier");
+
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+        server.stop();
+        TEST_CHECK(ofGetElapsedTimeMillis() - startTime < MAX_STOP_MILLIS);
+    }
+
+    void testRefusesConnectionsBeyondItsWorkers()
+    {
+        begin("refuses connections beyond its workers");
+
+        VerifierRecorder recorder;
+        ofxOAuthVerifierCallbackServer server(&recorder);
+        server.setNumWorkers(1);
+        TEST_CHECK(server.start());
+
+        // takes the only worker.
+        Poco::Net::StreamSocket idle(Poco::Net::SocketAddress("127.0.0.1", (Poco::UInt16)server.getPort()));
+        ofSleepMillis(100);
+
+        // answered right away, not after the idle connection times out.
+        unsigned long long startTime = ofGetElapsedTimeMillis();
+
+        ofxOAuthTransport transport;
+        ofxOAuthTransportResult result;
+        transport.get(server.getURL() + "?oauth_token=token&oauth_verifier=verifier", "", result);
+
+        TEST_CHECK(result.status == 503);
+        TEST_CHECK(ofGetElapsedTimeMillis() - startTime < 1000);
+
+        startTime = ofGetElapsedTimeMillis();
+        server.stop();
+        TEST_CHECK(ofGetElapsedTimeMillis() - startTime < MAX_STOP_MILLIS);
+    }
+
+    // A docRoot of its own with a stylesheet in it, which is served as a
+    // static file rather than as a template.
+    static std::string makeDocRoot(const std::string& css)
+    {
+        std::string docRoot = ofToDataPath("VerifierCallbackServerTests", true);
+        ofDirectory::removeDirectory(docRoot, true, false);
+        ofDirectory::createDirectory(docRoot, false, true);
+        writeFile(docRoot + "/style.css", css);
+        return docRoot + "/";
+    }
+
+    static void writeFile(const std::string& pathname, const std::string& contents)
+    {
+        ofBuffer buffer;
+        buffer.set(contents.data(), contents.size());
+        ofBufferToFile(pathname, buffer);
+    }
+
+    static bool get(const std::string& url,
+                    const std::string& extraHeader,
+                    ofxOAuthTransportResult& result)
+    {
+        ofxOAuthTransport transport;
+        ofxOAuthTransportRequest request;
+        request.url = url;
+        if(!extraHeader.empty()) request.extraHeaders.push_back(extraHeader);
+        return transport.perform(request, result);
+    }
+
+    void testServesStaticFiles()
+    {
+        begin("serves static files with a length and validators");
+
+        std::string css = "body { color: black; }\n";
+        std::string docRoot = makeDocRoot(css);
+
+        VerifierRecorder recorder;
+        ofxOAuthVerifierCallbackServer server(&recorder, docRoot);
+        TEST_CHECK(server.start());
+
+        ofxOAuthTransportResult result;
+        TEST_CHECK(get(server.getURL() + "/style.css", "", result));
+        TEST_CHECK(result.status == 200);
+        TEST_CHECK(result.body == css);
+        TEST_CHECK(result.headers.get("Content-Type") == "text/css");
+        TEST_CHECK(result.headers.getNumber("Content-Length", -1) == (long long)css.size());
+        TEST_CHECK(!result.headers.has("Transfer-Encoding"));
+        TEST_CHECK(!result.headers.get("ETag").empty());
+        TEST_CHECK(!result.headers.get("Last-Modified").empty());
+
+        server.stop();
+    }
+
+    void testAnswersIfNoneMatch()
+    {
+        begin("answers If-None-Match");
+
+        std::string docRoot = makeDocRoot("body { color: black; }\n");
+
+        VerifierRecorder recorder;
+        ofxOAuthVerifierCallbackServer server(&recorder, docRoot);
+        TEST_CHECK(server.start());
+
+        std::string url = server.getURL() + "/style.css";
+
+        ofxOAuthTransportResult first;
+        TEST_CHECK(get(url, "", first));
+        std::string etag = first.headers.get("ETag");
+
+        ofxOAuthTransportResult result;
+        TEST_CHECK(get(url, "If-None-Match: " + etag, result));
+        TEST_CHECK(result.status == 304);
+        TEST_CHECK(result.body.empty());
+        TEST_CHECK(result.headers.get("ETag") == etag);
+
+        ofxOAuthTransportResult weak;
+        TEST_CHECK(get(url, "If-None-Match: \"other\", W/" + etag, weak));
+        TEST_CHECK(weak.status == 304);
+        TEST_CHECK(weak.body.empty());
+
+        ofxOAuthTransportResult any;
+        TEST_CHECK(get(url, "If-None-Match: *", any));
+        TEST_CHECK(any.status == 304);
+
+        ofxOAuthTransportResult other;
+        TEST_CHECK(get(url, "If-None-Match: \"other\"", other));
+        TEST_CHECK(other.status == 200);
+        TEST_CHECK(other.body == first.body);
+
+        server.stop();
+    }
+
+    void testAnswersIfModifiedSince()
+    {
+        begin("answers If-Modified-Since");
+
+        std::string docRoot = makeDocRoot("body { color: black; }\n");
+
+        VerifierRecorder recorder;
+        ofxOAuthVerifierCallbackServer server(&recorder, docRoot);
+        TEST_CHECK(server.start());
+
+        std::string url = server.getURL() + "/style.css";
+
+        ofxOAuthTransportResult first;
+        TEST_CHECK(get(url, "", first));
+
+        ofxOAuthTransportResult result;
+        TEST_CHECK(get(url, "If-Modified-Since: " + first.headers.get("Last-Modified"), result));
+        TEST_CHECK(result.status == 304);
+        TEST_CHECK(result.body.empty());
+
+        ofxOAuthTransportResult older;
+        TEST_CHECK(get(url, "If-Modified-Since: Thu, 01 Jan 1998 00:00:00 GMT", older));
+        TEST_CHECK(older.status == 200);
+        TEST_CHECK(older.body == first.body);
+
+        server.stop();
+    }
+
+    void testRemapsChangedFiles()
+    {
+        begin("maps a changed file again");
+
+        std::string docRoot = makeDocRoot("body { color: black; }\n");
+
+        VerifierRecorder recorder;
+        ofxOAuthVerifierCallbackServer server(&recorder, docRoot);
+        TEST_CHECK(server.start());
+
+        std::string url = server.getURL() + "/style.css";
+
+        ofxOAuthTransportResult first;
+        TEST_CHECK(get(url, "", first));
+        std::string etag = first.headers.get("ETag");
+
+        // a different size, so the tag changes even within the mtime's resolution.
+        std::string css = "body { color: white; background: black; }\n";
+        writeFile(docRoot + "style.css", css);
+
+        ofxOAuthTransportResult result;
+        TEST_CHECK(get(url, "If-None-Match: " + etag, result));
+        TEST_CHECK(result.status == 200);
+        TEST_CHECK(result.body == css);
+        TEST_CHECK(result.headers.getNumber("Content-Length", -1) == (long long)css.size());
+        TEST_CHECK(!result.headers.get("ETag").empty());
+        TEST_CHECK(result.headers.get("ETag") != etag);
+
+        server.stop();
+    }
+
+};
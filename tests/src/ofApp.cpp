@@ -0,0 +1,91 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "ofApp.h"
+#include "AsyncTransportTests.h"
+#include "BodyHashBenchmarks.h"
+#include "BulkFetchBenchmarks.h"
+#include "CAStoreTests.h"
+#include "CompressionTests.h"
+#include "ConnectionReuseBenchmarks.h"
+#include "FormParserTests.h"
+#include "FrameTimeBenchmarks.h"
+#include "HeadersTests.h"
+#include "LargeResponseBenchmarks.h"
+#include "MessageStreamTests.h"
+#include "MultipartUploadTests.h"
+#include "PercentEncodingBenchmarks.h"
+#include "RateLimiterTests.h"
+#include "ResponseCacheTests.h"
+#include "RetryTests.h"
+#include "SignerTests.h"
+#include "SharedContextBenchmarks.h"
+#include "SigningBenchmarks.h"
+#include "StressTests.h"
+#include "TemplateBenchmarks.h"
+#include "ThreadScalingBenchmarks.h"
+#include "VerifierCallbackLoadTests.h"
+#include "VerifierCallbackServerTests.h"
+
+
+//------------------------------------------------------------------------------
+void ofApp::setup()
+{
+    suites.push_back(std::shared_ptr<TestSuite>(new SignerTests()));
+    suites.push_back(std::shared_ptr<TestSuite>(new HeadersTests()));
+    suites.push_back(std::shared_ptr<TestSuite>(new AsyncTransportTests()));
+    suites.push_back(std::shared_ptr<TestSuite>(new RateLimiterTests()));
+    suites.push_back(std::shared_ptr<TestSuite>(new ResponseCacheTests()));
+    suites.push_back(std::shared_ptr<TestSuite>(new CompressionTests()));
+    suites.push_back(std::shared_ptr<TestSuite>(new MessageStreamTests()));
+    suites.push_back(std::shared_ptr<TestSuite>(new RetryTests()));
+    suites.push_back(std::shared_ptr<TestSuite>(new FormParserTests()));
+    suites.push_back(std::shared_ptr<TestSuite>(new VerifierCallbackServerTests()));
+    suites.push_back(std::shared_ptr<TestSuite>(new VerifierCallbackLoadTests()));
+    suites.push_back(std::shared_ptr<TestSuite>(new CAStoreTests()));
+    suites.push_back(std::shared_ptr<TestSuite>(new FrameTimeBenchmarks()));
+    suites.push_back(std::shared_ptr<TestSuite>(new ConnectionReuseBenchmarks()));
+    suites.push_back(std::shared_ptr<TestSuite>(new ThreadScalingBenchmarks()));
+    suites.push_back(std::shared_ptr<TestSuite>(new SharedContextBenchmarks()));
+    suites.push_back(std::shared_ptr<TestSuite>(new BulkFetchBenchmarks()));
+    suites.push_back(std::shared_ptr<TestSuite>(new LargeResponseBenchmarks()));
+    suites.push_back(std::shared_ptr<TestSuite>(new MultipartUploadTests()));
+    suites.push_back(std::shared_ptr<TestSuite>(new StressTests()));
+    suites.push_back(std::shared_ptr<TestSuite>(new SigningBenchmarks()));
+    suites.push_back(std::shared_ptr<TestSuite>(new PercentEncodingBenchmarks()));
+    suites.push_back(std::shared_ptr<TestSuite>(new BodyHashBenchmarks()));
+    suites.push_back(std::shared_ptr<TestSuite>(new TemplateBenchmarks()));
+
+    std::size_t numFailed = 0;
+
+    for(std::size_t i = 0; i < suites.size(); ++i)
+    {
+        numFailed += suites[i]->runAll();
+    }
+
+    ofLogNotice("ofApp::setup") << (numFailed == 0 ? "All tests passed." : ofToString(numFailed) + " checks failed.");
+
+    ofExit((int)std::min(numFailed, (std::size_t)255));
+}